@@ -8,6 +8,7 @@ endif()
 find_package(Qt5Core)
 find_package(Qt5Widgets)
 find_package(Qt5Xml)
+find_package(Qt5Concurrent)
 find_package(Qt5LinguistTools)
 find_package(Qt5PrintSupport)
 find_package(Qt5Multimedia)
@@ -0,0 +1,578 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "logengine.h"
+
+#if defined(QT_CONCURRENT)
+  #include <QtConcurrent>
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Each pyramid level groups 1 << LEVEL_SHIFT buckets of the previous one
+#define LEVEL_SHIFT        2
+#define LEVEL_MIN_BUCKETS  64
+// Files smaller than this are parsed in one go
+#define CHUNK_MIN_SIZE     (1024 * 1024)
+
+enum ColumnFlags {
+  FLAG_NUMBER = 1,
+  FLAG_FLOAT = 2,
+  FLAG_TEXT = 4
+};
+
+struct LogEngine::Chunk
+{
+  const char * begin;
+  const char * end;
+  QVector<qint64> offsets;
+  QVector<double> timestamps;
+  QVector<QVector<double>> values;  // per column, dropped at the first text cell
+  QVector<int> flags;
+  int lines = 0;
+  int invalid = 0;
+  qint64 hourKey = -1;            // last local hour converted
+  double hourTime = 0;
+};
+
+static inline bool isBlank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool parseInt(const char * & p, const char * end, int & value)
+{
+  const char * start = p;
+  value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    value = value * 10 + (*p++ - '0');
+  }
+  return p > start && p - start <= 9;
+}
+
+static bool parseDate(const char * p, const char * end, int & year, int & month, int & day)
+{
+  return parseInt(p, end, year) && p < end && *p++ == '-' &&
+         parseInt(p, end, month) && p < end && *p++ == '-' &&
+         parseInt(p, end, day) && p == end;
+}
+
+// "hh:mm:ss" or "hh:mm:ss.zzz"
+static bool parseTime(const char * p, const char * end, int & hour, int & minute, double & seconds)
+{
+  int secs;
+  if (!(parseInt(p, end, hour) && p < end && *p++ == ':' &&
+        parseInt(p, end, minute) && p < end && *p++ == ':' &&
+        parseInt(p, end, secs)))
+    return false;
+
+  seconds = secs;
+  if (p < end && *p == '.') {
+    const char * start = ++p;
+    int fraction;
+    if (!parseInt(p, end, fraction))
+      return false;
+    seconds += fraction / pow(10, p - start);
+  }
+  return p == end;
+}
+
+// Locale independent, exact for up to 15 digits. Anything else (exponents,
+// longer numbers) goes through Qt.
+static bool parseNumber(const char * s, const char * end, double & value, bool & isFloat)
+{
+  static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                   1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+  const char * p = s;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p++ == '-');
+  }
+
+  qint64 mantissa = 0;
+  int digits = 0;
+  int scale = -1;
+  for (; p < end; p++) {
+    if (*p >= '0' && *p <= '9') {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits++;
+      if (scale >= 0)
+        scale++;
+    }
+    else if (*p == '.' && scale < 0) {
+      scale = 0;
+    }
+    else {
+      break;
+    }
+  }
+
+  if (p == end && digits > 0 && digits <= 15) {
+    value = (scale > 0 ? mantissa / powers[scale] : mantissa);
+    if (negative)
+      value = -value;
+    isFloat = (scale > 0);
+    return true;
+  }
+
+  bool ok = false;
+  value = QByteArray::fromRawData(s, end - s).toDouble(&ok);
+  isFloat = true;
+  return ok;
+}
+
+LogEngine::LogEngine():
+  data(nullptr),
+  size(0),
+  bodyStart(0),
+  lines(0),
+  invalid(0),
+  monotonic(true)
+{
+}
+
+LogEngine::~LogEngine()
+{
+  close();
+}
+
+void LogEngine::close()
+{
+  if (data) {
+    file.unmap((uchar *)data);
+    data = nullptr;
+  }
+  file.close();
+  size = 0;
+  bodyStart = 0;
+  lines = 0;
+  invalid = 0;
+  monotonic = true;
+  names.clear();
+  offsets.clear();
+  timestamps.clear();
+  columns.clear();
+}
+
+bool LogEngine::open(const QString & filename)
+{
+  close();
+  _error.clear();
+
+  file.setFileName(filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    _error = file.errorString();
+    return false;
+  }
+
+  size = file.size();
+  data = size > 0 ? (const char *)file.map(0, size) : nullptr;
+  if (!data) {
+    _error = tr("Cannot map the file in memory");
+    close();
+    return false;
+  }
+
+  const char * header = data;
+  const char * headerEnd = lineEnd(0);
+  if (headerEnd - header < 9 || strncmp(header, "Date,Time", 9)) {
+    _error = tr("Not a telemetry log");
+    close();
+    return false;
+  }
+
+  while (headerEnd > header && isBlank(headerEnd[-1]))
+    headerEnd--;
+  foreach (const QByteArray & name, QByteArray(header, headerEnd - header).split(',')) {
+    names.append(QString::fromUtf8(name));
+  }
+
+  bodyStart = lineEnd(0) - data;
+  if (bodyStart < size)
+    bodyStart++;
+
+  // Split the records in chunks at line boundaries, parsed in parallel
+  // when QtConcurrent is available
+  int chunkCount = 1;
+#if defined(QT_CONCURRENT)
+  if (size - bodyStart > CHUNK_MIN_SIZE)
+    chunkCount = qMax(1, QThread::idealThreadCount()) * 4;
+#endif
+
+  QVector<Chunk> chunks(chunkCount);
+  const char * begin = data + bodyStart;
+  for (int i = 0; i < chunkCount; i++) {
+    const char * end = data + bodyStart + (size - bodyStart) * (i + 1) / chunkCount;
+    if (i < chunkCount - 1) {
+      end = lineEnd(end - data);
+      if (end < data + size)
+        end++;
+    }
+    else {
+      end = data + size;
+    }
+    chunks[i].begin = begin;
+    chunks[i].end = qMax(begin, end);
+    begin = chunks[i].end;
+  }
+
+#if defined(QT_CONCURRENT)
+  QtConcurrent::blockingMap(chunks, [this](Chunk & chunk) {
+    parseChunk(chunk);
+  });
+#else
+  for (auto & chunk : chunks) {
+    parseChunk(chunk);
+  }
+#endif
+
+  // Gather the rows, in file order
+  int rows = 0;
+  for (const auto & chunk : chunks) {
+    rows += chunk.offsets.size();
+    lines += chunk.lines;
+    invalid += chunk.invalid;
+  }
+
+  const int columnCount = names.size();
+  offsets.reserve(rows);
+  timestamps.reserve(rows);
+  columns.resize(columnCount);
+  for (int column = 0; column < columnCount; column++) {
+    int flags = 0;
+    for (const auto & chunk : chunks) {
+      flags |= chunk.flags.at(column);
+    }
+    Column & c = columns[column];
+    if (column < 2)
+      c.type = COLUMN_TIMESTAMP;
+    else if ((flags & FLAG_TEXT) || !(flags & FLAG_NUMBER))
+      c.type = COLUMN_TEXT;
+    else if (flags & FLAG_FLOAT)
+      c.type = COLUMN_NUMBER;
+    else
+      c.type = COLUMN_INTEGER;
+    // only the numeric columns keep their values, text is read from the mapping
+    if (c.type == COLUMN_INTEGER || c.type == COLUMN_NUMBER)
+      c.values.reserve(rows);
+  }
+
+  for (auto & chunk : chunks) {
+    offsets += chunk.offsets;
+    timestamps += chunk.timestamps;
+    for (int column = 2; column < columnCount; column++) {
+      Column & c = columns[column];
+      if (c.type == COLUMN_INTEGER || c.type == COLUMN_NUMBER)
+        c.values += chunk.values.at(column);
+    }
+    chunk.values.clear();
+  }
+
+  for (int i = 1; i < rows; i++) {
+    if (timestamps[i] < timestamps[i - 1]) {
+      monotonic = false;
+      break;
+    }
+  }
+
+  if (rows == 0) {
+    _error = tr("No valid record found");
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void LogEngine::parseChunk(Chunk & chunk) const
+{
+  chunk.flags.fill(0, names.size());
+  chunk.values.resize(names.size());
+
+  const char * p = chunk.begin;
+  while (p < chunk.end) {
+    const char * eol = (const char *)memchr(p, '\n', chunk.end - p);
+    if (!eol)
+      eol = chunk.end;
+
+    const char * begin = p;
+    const char * end = eol;
+    while (begin < end && isBlank(*begin))
+      begin++;
+    while (end > begin && isBlank(end[-1]))
+      end--;
+
+    if (begin < end) {
+      chunk.lines++;
+      if (!parseRecord(begin, end, chunk))
+        chunk.invalid++;
+    }
+    p = eol + 1;
+  }
+}
+
+bool LogEngine::parseRecord(const char * begin, const char * end, Chunk & chunk) const
+{
+  const int columnCount = names.size();
+  QVarLengthArray<const char *, 64> fields;
+
+  fields.append(begin);
+  for (const char * p = begin; p < end; p++) {
+    if (*p == ',')
+      fields.append(p + 1);
+  }
+  if (fields.size() != columnCount)
+    return false;
+  fields.append(end + 1);
+
+  int year, month, day, hour, minute;
+  double seconds;
+  if (!parseDate(fields[0], fields[1] - 1, year, month, day) ||
+      !parseTime(fields[1], fields[2] - 1, hour, minute, seconds))
+    return false;
+
+  // Local time conversions are slow, they are only done once per hour
+  qint64 hourKey = ((qint64)year * 10000 + month * 100 + day) * 100 + hour;
+  if (hourKey != chunk.hourKey) {
+    QDateTime dt(QDate(year, month, day), QTime(hour, 0));
+    if (!dt.isValid())
+      return false;
+    chunk.hourKey = hourKey;
+    chunk.hourTime = dt.toMSecsSinceEpoch() / 1000;
+  }
+
+  for (int column = 2; column < columnCount; column++) {
+    if (chunk.flags[column] & FLAG_TEXT)
+      continue;
+
+    const char * s = fields[column];
+    const char * e = fields[column + 1] - 1;
+    double value = 0;
+    bool isFloat;
+    if (s == e) {
+      // empty cells are neither text nor numbers
+    }
+    else if (parseNumber(s, e, value, isFloat)) {
+      chunk.flags[column] |= FLAG_NUMBER | (isFloat ? FLAG_FLOAT : 0);
+    }
+    else {
+      // a text column: no value is stored for any of its rows
+      chunk.flags[column] |= FLAG_TEXT;
+      chunk.values[column].clear();
+      chunk.values[column].squeeze();
+      continue;
+    }
+    chunk.values[column].append(value);
+  }
+
+  chunk.offsets.append(begin - data);
+  chunk.timestamps.append(chunk.hourTime + minute * 60 + seconds);
+  return true;
+}
+
+const char * LogEngine::lineEnd(qint64 offset) const
+{
+  const char * eol = (const char *)memchr(data + offset, '\n', size - offset);
+  return eol ? eol : data + size;
+}
+
+QDateTime LogEngine::dateTime(int row) const
+{
+  return QDateTime::fromMSecsSinceEpoch(qRound64(timestamps.at(row) * 1000));
+}
+
+QByteArray LogEngine::line(int row) const
+{
+  const char * begin = data + offsets.at(row);
+  const char * end = lineEnd(offsets.at(row));
+  while (end > begin && isBlank(end[-1]))
+    end--;
+  return QByteArray(begin, end - begin);
+}
+
+QByteArray LogEngine::headerLine() const
+{
+  return data ? QByteArray(data, lineEnd(0) - data).trimmed() : QByteArray();
+}
+
+QString LogEngine::cell(int row, int column) const
+{
+  const char * p = data + offsets.at(row);
+  const char * end = lineEnd(offsets.at(row));
+  for (; column > 0 && p < end; p++) {
+    if (*p == ',')
+      column--;
+  }
+
+  const char * cellEnd = p;
+  while (cellEnd < end && *cellEnd != ',')
+    cellEnd++;
+  while (cellEnd > p && isBlank(cellEnd[-1]))
+    cellEnd--;
+  return QString::fromUtf8(p, cellEnd - p);
+}
+
+QStringList LogEngine::record(int row) const
+{
+  return QString::fromUtf8(line(row)).split(',');
+}
+
+QVector<int> LogEngine::getSessions(int maxGap) const
+{
+  QVector<int> sessions;
+  qint64 last = 0;
+  for (int row = 0; row < timestamps.size(); row++) {
+    qint64 time = qRound64(timestamps[row] * 1000);
+    if (row == 0 || (time - last) / 1000 > maxGap) {
+      sessions.append(row);
+    }
+    last = time;
+  }
+  return sessions;
+}
+
+int LogEngine::findRow(double time, int first, int last) const
+{
+  return std::lower_bound(timestamps.constBegin() + first, timestamps.constBegin() + last + 1, time) - timestamps.constBegin();
+}
+
+void LogEngine::buildLevels(const Column & column) const
+{
+  const int bucketSize = 1 << LEVEL_SHIFT;
+  QVector<MinMax> level;
+
+  level.reserve(column.values.size() / bucketSize + 1);
+  for (int row = 0; row < column.values.size(); row++) {
+    double value = column.values.at(row);
+    if (row % bucketSize == 0) {
+      level.append({value, value, row, row});
+      continue;
+    }
+    MinMax & bucket = level.last();
+    if (value < bucket.min) {
+      bucket.min = value;
+      bucket.minRow = row;
+    }
+    if (value > bucket.max) {
+      bucket.max = value;
+      bucket.maxRow = row;
+    }
+  }
+  column.levels.append(level);
+
+  while (column.levels.last().size() > LEVEL_MIN_BUCKETS) {
+    const QVector<MinMax> & previous = column.levels.last();
+    QVector<MinMax> next;
+    next.reserve(previous.size() / bucketSize + 1);
+    for (int i = 0; i < previous.size(); i++) {
+      const MinMax & src = previous.at(i);
+      if (i % bucketSize == 0) {
+        next.append(src);
+        continue;
+      }
+      MinMax & bucket = next.last();
+      if (src.min < bucket.min) {
+        bucket.min = src.min;
+        bucket.minRow = src.minRow;
+      }
+      if (src.max > bucket.max) {
+        bucket.max = src.max;
+        bucket.maxRow = src.maxRow;
+      }
+    }
+    column.levels.append(next);
+  }
+}
+
+void LogEngine::appendPlotData(const Column & column, int first, int last, int level, QVector<double> & x, QVector<double> & y) const
+{
+  if (first > last)
+    return;
+
+  if (level < 0) {
+    for (int row = first; row <= last; row++) {
+      x.append(timestamps.at(row));
+      y.append(column.values.at(row));
+    }
+    return;
+  }
+
+  const int shift = (level + 1) * LEVEL_SHIFT;
+  const int firstBucket = (first + (1 << shift) - 1) >> shift;
+  const int lastBucket = ((last + 1) >> shift) - 1;
+  if (firstBucket > lastBucket) {
+    appendPlotData(column, first, last, level - 1, x, y);
+    return;
+  }
+
+  // partial buckets at both ends are drawn with the finer levels
+  appendPlotData(column, first, (firstBucket << shift) - 1, level - 1, x, y);
+
+  const QVector<MinMax> & buckets = column.levels.at(level);
+  for (int b = firstBucket; b <= lastBucket; b++) {
+    const MinMax & bucket = buckets.at(b);
+    int row = qMin(bucket.minRow, bucket.maxRow);
+    x.append(timestamps.at(row));
+    y.append(column.values.at(row));
+    if (bucket.minRow != bucket.maxRow) {
+      row = qMax(bucket.minRow, bucket.maxRow);
+      x.append(timestamps.at(row));
+      y.append(column.values.at(row));
+    }
+  }
+
+  appendPlotData(column, (lastBucket + 1) << shift, last, level - 1, x, y);
+}
+
+void LogEngine::getPlotData(int column, int first, int last, int pixels, QVector<double> & x, QVector<double> & y) const
+{
+  const Column & c = columns.at(column);
+  const int count = last - first + 1;
+
+  x.clear();
+  y.clear();
+  if (count <= 0)
+    return;
+
+  if (c.values.isEmpty()) {
+    // text columns have no values, drawn as 0 like their cells in value()
+    x << timestamps.at(first) << timestamps.at(last);
+    y << 0 << 0;
+    return;
+  }
+
+  if (pixels <= 0 || count <= 2 * pixels) {
+    appendPlotData(c, first, last, -1, x, y);
+    return;
+  }
+
+  if (c.levels.isEmpty())
+    buildLevels(c);
+
+  // coarsest level with at least one bucket per pixel
+  int level = 0;
+  while (level + 1 < c.levels.size() && (count >> ((level + 2) * LEVEL_SHIFT)) >= pixels)
+    level++;
+
+  x.reserve(4 * pixels);
+  y.reserve(4 * pixels);
+  appendPlotData(c, first, last, level, x, y);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _LOGENGINE_H_
+#define _LOGENGINE_H_
+
+#include <QtCore>
+
+/*
+ * Telemetry log (CSV) parsed once into columns of numbers.
+ *
+ * The file stays memory-mapped: the text of a cell is only extracted when it
+ * is displayed. Numeric values are kept as doubles (integers included, they
+ * are exact) so that plotting never goes through strings again.
+ */
+class LogEngine
+{
+  Q_DECLARE_TR_FUNCTIONS(LogEngine)
+
+  public:
+    enum ColumnType {
+      COLUMN_TIMESTAMP,
+      COLUMN_INTEGER,
+      COLUMN_NUMBER,
+      COLUMN_TEXT
+    };
+
+    LogEngine();
+    ~LogEngine();
+
+    bool open(const QString & filename);
+    void close();
+
+    QString error() const { return _error; }
+    int totalLines() const { return lines; }
+    int invalidLines() const { return invalid; }
+
+    int rowCount() const { return offsets.size(); }
+    int columnCount() const { return names.size(); }
+    const QStringList & columnNames() const { return names; }
+    ColumnType columnType(int column) const { return columns.at(column).type; }
+
+    // seconds since the epoch, local time
+    double timestamp(int row) const { return timestamps.at(row); }
+    QDateTime dateTime(int row) const;
+    // numeric value of a cell, 0 when it is not a number. Text columns have
+    // no values stored, their cells are only read from the file.
+    double value(int row, int column) const { return columns.at(column).values.value(row); }
+
+    QString cell(int row, int column) const;
+    QStringList record(int row) const;
+    QByteArray line(int row) const;
+    QByteArray headerLine() const;
+
+    // first row of each flight session, sessions are split on gaps in the timestamps
+    QVector<int> getSessions(int maxGap = 60) const;
+
+    // true when the timestamps never go backwards, findRow() can then be used
+    bool isMonotonic() const { return monotonic; }
+    int findRow(double time, int first, int last) const;
+
+    // points to draw rows [first, last] of a column on a given number of pixels:
+    // only the minimum and maximum of each pixel are kept
+    void getPlotData(int column, int first, int last, int pixels, QVector<double> & x, QVector<double> & y) const;
+
+  protected:
+    struct MinMax {
+      double min;
+      double max;
+      int minRow;
+      int maxRow;
+    };
+
+    struct Column {
+      ColumnType type;
+      QVector<double> values;  // empty for the text and timestamp columns
+      // decimation pyramid, built when the column is first plotted
+      mutable QVector<QVector<MinMax>> levels;
+    };
+
+    struct Chunk;
+
+    QFile file;
+    const char * data;
+    qint64 size;
+    qint64 bodyStart;
+    QString _error;
+    int lines;
+    int invalid;
+    bool monotonic;
+
+    QStringList names;
+    QVector<qint64> offsets;
+    QVector<double> timestamps;
+    QVector<Column> columns;
+
+    void parseChunk(Chunk & chunk) const;
+    bool parseRecord(const char * begin, const char * end, Chunk & chunk) const;
+    const char * lineEnd(qint64 offset) const;
+    void buildLevels(const Column & column) const;
+    void appendPlotData(const Column & column, int first, int last, int level, QVector<double> & x, QVector<double> & y) const;
+};
+
+#endif // _LOGENGINE_H_
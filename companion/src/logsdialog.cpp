@@ -29,6 +29,44 @@
 #include <unistd.h>
 #endif
 
+LogTableModel::LogTableModel(const LogEngine & logEngine, QObject *parent) :
+  QAbstractTableModel(parent),
+  logEngine(logEngine)
+{
+}
+
+void LogTableModel::reload()
+{
+  beginResetModel();
+  endResetModel();
+}
+
+QVariant LogTableModel::data(const QModelIndex &index, int role) const
+{
+  if (!index.isValid() || role != Qt::DisplayRole)
+    return QVariant();
+
+  return logEngine.cell(index.row(), index.column());
+}
+
+int LogTableModel::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : logEngine.rowCount();
+}
+
+int LogTableModel::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : logEngine.columnCount();
+}
+
+QVariant LogTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section < logEngine.columnCount())
+    return logEngine.columnNames().at(section);
+
+  return QVariant();
+}
+
 LogsDialog::LogsDialog(QWidget *parent) :
   QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint),
   ui(new Ui::LogsDialog),
@@ -37,9 +75,9 @@ LogsDialog::LogsDialog(QWidget *parent) :
   cursorB(0),
   cursorLine(0)
 {
-  csvlog.clear();
-
   ui->setupUi(this);
+  logModel = new LogTableModel(logEngine, this);
+  ui->logTable->setModel(logModel);
   setWindowIcon(CompanionIcon("logs.png"));
 
   plotLock=false;
@@ -110,13 +148,15 @@ LogsDialog::LogsDialog(QWidget *parent) :
 
   // make left axes transfer its range to right axes:
   connect(axisRect->axis(QCPAxis::atLeft), SIGNAL(rangeChanged(QCPRange)), this, SLOT(yAxisChangeRanges(QCPRange)));
+  // resample the graphs to the visible range when zooming or panning:
+  connect(axisRect->axis(QCPAxis::atBottom), SIGNAL(rangeChanged(QCPRange)), this, SLOT(xAxisChangeRange(QCPRange)));
 
   // connect some interaction slots:
   connect(ui->customPlot, SIGNAL(titleDoubleClick(QMouseEvent*, QCPPlotTitle*)), this, SLOT(titleDoubleClick(QMouseEvent*, QCPPlotTitle*)));
   connect(ui->customPlot, SIGNAL(axisDoubleClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)), this, SLOT(axisLabelDoubleClick(QCPAxis*,QCPAxis::SelectablePart)));
   connect(ui->customPlot, SIGNAL(legendDoubleClick(QCPLegend*,QCPAbstractLegendItem*,QMouseEvent*)), this, SLOT(legendDoubleClick(QCPLegend*,QCPAbstractLegendItem*)));
   connect(ui->FieldsTW, SIGNAL(itemSelectionChanged()), this, SLOT(plotLogs()));
-  connect(ui->logTable, SIGNAL(itemSelectionChanged()), this, SLOT(plotLogs()));
+  connect(ui->logTable->selectionModel(), SIGNAL(selectionChanged(QItemSelection, QItemSelection)), this, SLOT(plotLogs()));
   connect(ui->Reset_PB, SIGNAL(clicked()), this, SLOT(plotLogs()));
   connect(ui->SaveSession_PB, SIGNAL(clicked()), this, SLOT(saveSession()));
 }
@@ -236,18 +276,19 @@ void LogsDialog::selectionChanged()
   }
 }
 
-QList<QStringList> LogsDialog::filterGePoints(const QList<QStringList> & input)
+QList<QStringList> LogsDialog::filterGePoints()
 {
   QList<QStringList> result;
 
-  int n = input.count();
+  int n = logEngine.rowCount();
   if (n == 0) {
     return result;
   }
 
+  const QStringList & header = logEngine.columnNames();
   int gpscol = 0;
-  for (int i=1; i<input.at(0).count(); i++) {
-    if (input.at(0).at(i) == "GPS") {
+  for (int i=1; i<header.count(); i++) {
+    if (header.at(i) == "GPS") {
       gpscol=i;
     }
   }
@@ -258,16 +299,17 @@ The columns for altitude \"GAlt\" and for speed \"GSpd\" are optional"));
     return result;
   }
 
-  result.append(input.at(0));
-  bool rangeSelected = ui->logTable->selectionModel()->selectedRows().length() > 0;
+  result.append(header);
+  QItemSelectionModel * selection = ui->logTable->selectionModel();
+  bool rangeSelected = selection->hasSelection();
 
   GpsGlitchFilter glitchFilter;
   GpsLatLonFilter latLonFilter;
 
-  for (int i = 1; i < n; i++) {
-    if ((ui->logTable->item(i-1, 1)->isSelected() && rangeSelected) || !rangeSelected) {
+  for (int i = 0; i < n; i++) {
+    if ((selection->isRowSelected(i, QModelIndex()) && rangeSelected) || !rangeSelected) {
 
-      GpsCoord coord = extractGpsCoordinates(input.at(i).at(gpscol));
+      GpsCoord coord = extractGpsCoordinates(logEngine.cell(i, gpscol));
 
       // glitch filter
       if ( glitchFilter.isGlitch(coord) ) {
@@ -282,18 +324,18 @@ The columns for altitude \"GAlt\" and for speed \"GSpd\" are optional"));
       }
 
       // qDebug() << "point " << latitude << longitude;
-      result.append(input.at(i));
+      result.append(logEngine.record(i));
     }
   }
 
-  // qDebug() << "filterGePoints(): filtered from" << input.count() << "to " << result.count() << "points";
+  // qDebug() << "filterGePoints(): filtered from" << n << "to " << result.count() << "points";
   return result;
 }
 
 void LogsDialog::exportToGoogleEarth()
 {
   // filter data points
-  QList<QStringList> dataPoints = filterGePoints(csvlog);
+  QList<QStringList> dataPoints = filterGePoints();
   int n = dataPoints.count(); // number of points to export
   if (n==0) return;
 
@@ -572,37 +614,25 @@ void LogsDialog::on_fileOpen_BT_clicked()
     g.logDir(fileName);
     ui->FileName_LE->setText(fileName);
     if (cvsFileParse()) {
-      ui->FieldsTW->clear();
-      ui->logTable->clear();
       ui->FieldsTW->setShowGrid(false);
       ui->FieldsTW->setContentsMargins(0,0,0,0);
-      ui->FieldsTW->setRowCount(csvlog.at(0).count()-2);
+      ui->FieldsTW->setRowCount(logEngine.columnCount()-2);
       ui->FieldsTW->setColumnCount(1);
       ui->FieldsTW->setHorizontalHeaderLabels(QStringList(tr("Available fields")));
       ui->logTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-      for (int i=2; i<csvlog.at(0).count(); i++) {
-        QTableWidgetItem* item= new QTableWidgetItem(csvlog.at(0).at(i));
+      for (int i=2; i<logEngine.columnCount(); i++) {
+        QTableWidgetItem* item= new QTableWidgetItem(logEngine.columnNames().at(i));
         ui->FieldsTW->setItem(i-2, 0, item);
       }
       ui->FieldsTW->resizeRowsToContents();
-      ui->logTable->setColumnCount(csvlog.at(0).count());
-      ui->logTable->setRowCount(csvlog.count()-1);
-      ui->logTable->setHorizontalHeaderLabels(csvlog.at(0));
-
-      QAbstractItemModel *model = ui->logTable->model();
-      for (int i=1; i<csvlog.count(); i++) {
-        for (int j=0; j<csvlog.at(0).count(); j++) {
-          model->setData(model->index(i - 1, j, QModelIndex()), csvlog.at(i).at(j));
-        }
-      }
 
       ui->logTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
       QVarLengthArray<int> sizes;
-      for (int i = 0; i < ui->logTable->columnCount(); i++) {
+      for (int i = 0; i < logModel->columnCount(); i++) {
         sizes.append(ui->logTable->columnWidth(i));
       }
       ui->logTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
-      for (int i = 0; i < ui->logTable->columnCount(); i++) {
+      for (int i = 0; i < logModel->columnCount(); i++) {
         ui->logTable->setColumnWidth(i, sizes.at(i));
       }
     }
@@ -614,100 +644,54 @@ void LogsDialog::saveSession()
   int index = ui->sessions_CB->currentIndex();
   // ignore index 0 is its all sessions combined
   if(index > 0) {
-    int n = csvlog.count();
-    QList<QStringList> sessionCsvLog;
-    // add CSV headers from first row of source file
-    sessionCsvLog.push_back(csvlog[0]);
-    // find session breaks
-    int currentSession = 0;
-    QDateTime lastvalue;
-    for (int i = 1; i < n; i++) {
-      QDateTime tmp = getRecordTimeStamp(i);
-      if (!lastvalue.isValid() || lastvalue.secsTo(tmp) > 60) {
-        currentSession++;
-      }
-      lastvalue = tmp;
-      if(currentSession == index) {
-        // add records to filtered list
-        sessionCsvLog.push_back(csvlog[i]);
-      }
-      else if (currentSession > index) {
-        break;
-      }
+    int first = ui->sessions_CB->itemData(index, Qt::UserRole).toInt();
+    int last = logEngine.rowCount() - 1;
+    if (index < ui->sessions_CB->count() - 1) {
+      last = ui->sessions_CB->itemData(index + 1, Qt::UserRole).toInt() - 1;
     }
-    // save the filtered records to a new file
+    // save the session records to a new file
     QString newFilename = logFilename;
     newFilename.append(QString("-Session%1.csv").arg(index));
     QString filename = QFileDialog::getSaveFileName(this, "Save log", newFilename, "CSV files (.csv);", 0, 0); // getting the filename (full path)
     QFile data(filename);
     if(data.open(QFile::WriteOnly |QFile::Truncate)) {
-      QTextStream output(&data);
-      int numRecords = sessionCsvLog.count();
-      for(int i = 0; i < numRecords; i++){
-        output << sessionCsvLog[i].join(",") << '\n';
+      // add CSV headers from first row of source file
+      data.write(logEngine.headerLine() + '\n');
+      for (int row = first; row <= last; row++) {
+        data.write(logEngine.line(row) + '\n');
       }
     }
-    sessionCsvLog.clear();
   }
 }
 
 bool LogsDialog::cvsFileParse()
 {
-  QFile file(ui->FileName_LE->text());
-  int errors=0;
-  int lines=-1;
-
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) { // reading HEX TEXT file
-    return false;
-  }
-  else {
-    csvlog.clear();
-    logFilename.clear();
-    QTextStream inputStream(&file);
-    QString buffer = file.readLine();
-
-    if (buffer.startsWith("Date,Time")) {
-      file.reset();
-    }
-    else {
-      return false;
-    }
+  plotLock = true;
 
-    int numfields=-1;
-    while (!file.atEnd()) {
-      QString line = file.readLine().trimmed();
-      QStringList columns = line.split(',');
-      if (numfields==-1) {
-        numfields=columns.count();
-      }
-      if (columns.count()==numfields) {
-        csvlog.append(columns);
-      }
-      else {
-        errors++;
-      }
-      lines++;
+  // the table and graphs refer to the mapped file, clear them first
+  removeAllGraphs();
+  plots.coords.clear();
+  ui->FieldsTW->clear();
+  ui->FieldsTW->setRowCount(0);
+  logEngine.close();
+  logModel->reload();
+  logFilename.clear();
+
+  bool result = logEngine.open(ui->FileName_LE->text());
+  if (result) {
+    logModel->reload();
+    logFilename = QFileInfo(ui->FileName_LE->text()).baseName();
+
+    // a single invalid line is usually the last record, cut when logging stopped
+    if (logEngine.invalidLines() > 1) {
+      QMessageBox::warning(this, CPN_STR_APP_NAME, tr("The selected logfile contains %1 invalid lines out of  %2 total lines").arg(logEngine.invalidLines()).arg(logEngine.totalLines()));
     }
 
-    logFilename = QFileInfo(file.fileName()).baseName();
-  }
-
-  file.close();
-  if (errors > 1) {
-    QMessageBox::warning(this, CPN_STR_APP_NAME, tr("The selected logfile contains %1 invalid lines out of  %2 total lines").arg(errors).arg(lines));
+    setFlightSessions();
   }
 
-  int n = csvlog.count();
-  if (n == 1) {
-    csvlog.clear();
-    return false;
-  }
-
-  plotLock = true;
-  setFlightSessions();
   plotLock = false;
-
-  return true;
+  return result;
 }
 
 struct FlightSession {
@@ -715,14 +699,6 @@ struct FlightSession {
   QDateTime end;
 };
 
-QDateTime LogsDialog::getRecordTimeStamp(int index)
-{
-  QString tstamp = csvlog.at(index).at(0) + " " + csvlog.at(index).at(1);
-  if (csvlog.at(index).at(1).contains("."))
-    return QDateTime::fromString(tstamp, "yyyy-MM-dd HH:mm:ss.zzz");
-  return QDateTime::fromString(tstamp, "yyyy-MM-dd HH:mm:ss");
-}
-
 QString LogsDialog::generateDuration(const QDateTime & start, const QDateTime & end)
 {
   int secs = start.secsTo(end);
@@ -740,35 +716,26 @@ void LogsDialog::setFlightSessions()
   ui->sessions_CB->clear();
   ui->SaveSession_PB->setEnabled(false);
 
-  int n = csvlog.count();
+  int n = logEngine.rowCount();
   // qDebug() << "records" << n;
 
   // find session breaks
-  QList<int> sessions;
-  QDateTime lastvalue;
-  for (int i = 1; i < n; i++) {
-    QDateTime tmp = getRecordTimeStamp(i);
-    if (!lastvalue.isValid() || lastvalue.secsTo(tmp) > 60) {
-      sessions.push_back(i-1);
-      // qDebug() << "session index" << i-1;
-    }
-    lastvalue = tmp;
-  }
-  sessions.push_back(n-1);
+  QVector<int> sessions = logEngine.getSessions();
+  sessions.push_back(n);
 
   //now construct a list of sessions with their times
   //total time
   int noSesions = sessions.size()-1;
   QString label = QString("%1 ").arg(noSesions);
   label += tr(noSesions > 1 ? "sessions" : "session");
-  label += " <" + tr("time span") + generateDuration(getRecordTimeStamp(1), getRecordTimeStamp(n-1)) + ">";
+  label += " <" + tr("time span") + generateDuration(logEngine.dateTime(0), logEngine.dateTime(n-1)) + ">";
   ui->sessions_CB->addItem(label);
 
   // add individual sessions
   if (sessions.size() > 2) {
     for (int i = 1; i < sessions.size(); i++) {
-      QDateTime sessionStart = getRecordTimeStamp(sessions.at(i-1)+1);
-      QDateTime sessionEnd = getRecordTimeStamp(sessions.at(i));
+      QDateTime sessionStart = logEngine.dateTime(sessions.at(i-1));
+      QDateTime sessionEnd = logEngine.dateTime(sessions.at(i)-1);
       QString label = sessionStart.toString("HH:mm:ss") + " <" + tr("duration ") + generateDuration(sessionStart, sessionEnd) + ">";
       ui->sessions_CB->addItem(label, sessions.at(i-1));
       // qDebug() << "added label" << label << sessions.at(i-1);
@@ -788,13 +755,13 @@ void LogsDialog::on_sessions_CB_currentIndexChanged(int index)
     if (index < ui->sessions_CB->count() - 1) {
       bottom = ui->sessions_CB->itemData(index + 1, Qt::UserRole).toInt();
     } else {
-      bottom = ui->logTable->rowCount();
+      bottom = logModel->rowCount();
     }
 
     QModelIndex topLeft = ui->logTable->model()->index(
       ui->sessions_CB->itemData(index, Qt::UserRole).toInt(), 0 , QModelIndex());
     QModelIndex bottomRight = ui->logTable->model()->index(
-      bottom - 1, ui->logTable->columnCount() - 1, QModelIndex());
+      bottom - 1, logModel->columnCount() - 1, QModelIndex());
 
     QItemSelection selection(topLeft, bottomRight);
     ui->logTable->selectionModel()->select(selection, QItemSelectionModel::Select);
@@ -818,70 +785,62 @@ void LogsDialog::plotLogs()
     return;
   }
 
-  plotsCollection plots;
-
   QModelIndexList selection = ui->logTable->selectionModel()->selectedRows();
-  int rowCount = selection.length();
-  bool hasLogSelection;
-  QVarLengthArray<int> selectedRows;
 
-  if (rowCount) {
-    hasLogSelection = true;
+  plots.coords.clear();
+  plots.rows.clear();
+  plots.firstRow = 0;
+  plots.lastRow = logEngine.rowCount() - 1;
+
+  if (selection.length()) {
     foreach (QModelIndex index, selection) {
-      selectedRows.append(index.row());
+      plots.rows.append(index.row());
+    }
+    std::sort(plots.rows.begin(), plots.rows.end());
+    plots.firstRow = plots.rows.first();
+    plots.lastRow = plots.rows.last();
+    // contiguous rows (e.g. a session) are plotted as a range
+    if (plots.lastRow - plots.firstRow + 1 == plots.rows.size()) {
+      plots.rows.clear();
     }
-    std::sort(selectedRows.begin(), selectedRows.end());
-  } else {
-    hasLogSelection = false;
-    rowCount = ui->logTable->rowCount();
   }
 
+  int rowCount = plots.rows.isEmpty() ? plots.lastRow - plots.firstRow + 1 : plots.rows.size();
+  auto rowAt = [&](int i) {
+    return plots.rows.isEmpty() ? plots.firstRow + i : plots.rows.at(i);
+  };
+
   plots.min_x = QDateTime::currentDateTime().toTime_t();
   plots.max_x = 0;
 
+  for (int i = 0; i < rowCount; i++) {
+    double time = logEngine.timestamp(rowAt(i));
+    if (plots.min_x > time) plots.min_x = time;
+    if (plots.max_x < time) plots.max_x = time;
+  }
+
   foreach (QTableWidgetItem *plot, ui->FieldsTW->selectedItems()) {
     coords_t plotCoords;
-    int plotColumn = plot->row() + 2; // Date and Time first
+    plotCoords.column = plot->row() + 2; // Date and Time first
 
     plotCoords.min_y = INVALID_MIN;
     plotCoords.max_y = INVALID_MAX;
+    plotCoords.maxRow = rowAt(0);
+    plotCoords.factor = 1;
     plotCoords.yaxis = firstLeft;
     plotCoords.name = plot->text();
 
-    for (int row = 0; row < rowCount; row++) {
-      QTableWidgetItem *logValue;
-      double y;
-      double time;
-      QString time_str;
-
-      if (hasLogSelection) {
-        logValue = ui->logTable->item(selectedRows.at(row), plotColumn);
-        time_str = ui->logTable->item(selectedRows.at(row), 0)->text() +
-          QString(" ") + ui->logTable->item(selectedRows.at(row), 1)->text();
-      } else {
-        logValue = ui->logTable->item(row, plotColumn);
-        time_str = ui->logTable->item(row, 0)->text() + QString(" ") +
-          ui->logTable->item(row, 1)->text();
-      }
-
-      y = logValue->text().toDouble();
-      plotCoords.y.push_back(y);
+    double maxValue = -100000;
+    for (int i = 0; i < rowCount; i++) {
+      int row = rowAt(i);
+      double y = logEngine.value(row, plotCoords.column);
 
       if (plotCoords.min_y > y) plotCoords.min_y = y;
       if (plotCoords.max_y < y) plotCoords.max_y = y;
-
-      if (time_str.contains('.')) {
-        time = QDateTime::fromString(time_str, "yyyy-MM-dd HH:mm:ss.zzz")
-          .toTime_t();
-        time += time_str.mid(time_str.indexOf('.')).toDouble();
-      } else {
-        time = QDateTime::fromString(time_str, "yyyy-MM-dd HH:mm:ss")
-          .toTime_t();
+      if (maxValue < y) {
+        maxValue = y;
+        plotCoords.maxRow = row;
       }
-      plotCoords.x.push_back(time);
-
-      if (plots.min_x > time) plots.min_x = time;
-      if (plots.max_x < time) plots.max_x = time;
     }
 
     double range_inc = (plotCoords.max_y - plotCoords.min_y) / 100;
@@ -956,11 +915,7 @@ void LogsDialog::plotLogs()
 
     for (int i = 0; i < plots.coords.size(); i++) {
       plots.coords[i].yaxis = firstLeft;
-
-      double factor = 100 / (plots.coords.at(i).max_y - plots.coords.at(i).min_y);
-      for (int j = 0; j < plots.coords.at(i).y.count(); j++) {
-        plots.coords[i].y[j] = factor * (plots.coords.at(i).y.at(j) - plots.coords.at(i).min_y);
-      }
+      plots.coords[i].factor = 100 / (plots.coords.at(i).max_y - plots.coords.at(i).min_y);
     }
   } else {
     for (int i = firstRight; i < AXES_LIMIT; i++) {
@@ -1045,8 +1000,7 @@ void LogsDialog::plotLogs()
         break;
     }
 
-    ui->customPlot->graph(i)->setData(plots.coords.at(i).x,
-      plots.coords.at(i).y);
+    setPlotData(plots.coords.at(i), ui->customPlot->graph(i));
     pen.setColor(colors.at(i % colors.size()));
     ui->customPlot->graph(i)->setPen(pen);
 
@@ -1066,6 +1020,50 @@ void LogsDialog::plotLogs()
   ui->customPlot->replot();
 }
 
+void LogsDialog::setPlotData(const coords_t & c, QCPGraph * graph)
+{
+  QVector<double> x, y;
+
+  if (plots.rows.isEmpty()) {
+    // only the visible rows, decimated to the plot width
+    int first = plots.firstRow;
+    int last = plots.lastRow;
+    if (logEngine.isMonotonic()) {
+      QCPRange range = axisRect->axis(QCPAxis::atBottom)->range();
+      first = qMax(first, logEngine.findRow(range.lower, first, last) - 1);
+      last = qMin(last, logEngine.findRow(range.upper, first, last));
+    }
+    logEngine.getPlotData(c.column, first, last, axisRect->width(), x, y);
+  }
+  else {
+    foreach (int row, plots.rows) {
+      x.append(logEngine.timestamp(row));
+      y.append(logEngine.value(row, c.column));
+    }
+  }
+
+  if (plots.tooManyRanges) {
+    for (int i = 0; i < y.size(); i++) {
+      y[i] = c.factor * (y.at(i) - c.min_y);
+    }
+  }
+
+  graph->setData(x, y);
+}
+
+void LogsDialog::xAxisChangeRange(QCPRange range)
+{
+  Q_UNUSED(range);
+
+  // the selected rows are always drawn in full
+  if (!plots.rows.isEmpty() || ui->customPlot->graphCount() != plots.coords.size())
+    return;
+
+  for (int i = 0; i < plots.coords.size(); i++) {
+    setPlotData(plots.coords.at(i), ui->customPlot->graph(i));
+  }
+}
+
 void LogsDialog::yAxisChangeRanges(QCPRange range)
 {
   if (axisRect->axis(QCPAxis::atRight)->visible()) {
@@ -1110,21 +1108,7 @@ void LogsDialog::yAxisChangeRanges(QCPRange range)
 
 
 void LogsDialog::addMaxAltitudeMarker(const coords_t & c, QCPGraph * graph) {
-  // find max altitude
-  int positionIndex = 0;
-  double maxAlt = -100000;
-
-  for(int i=0; i<c.x.count(); ++i) {
-    double alt = c.y.at(i);
-    if (alt > maxAlt) {
-      maxAlt = alt;
-      positionIndex = i;
-      // qDebug() << "max alt: " << maxAlt << "@" << result;
-    }
-  }
-  // qDebug() << "max alt: " << maxAlt << "@" << positionIndex;
-
-  // add max altitude marker
+  // add max altitude marker, found while collecting the plot
   tracerMaxAlt = new QCPItemTracer(ui->customPlot);
   ui->customPlot->addItem(tracerMaxAlt);
   tracerMaxAlt->setGraph(graph);
@@ -1133,7 +1117,7 @@ void LogsDialog::addMaxAltitudeMarker(const coords_t & c, QCPGraph * graph) {
   tracerMaxAlt->setPen(QPen(Qt::blue));
   tracerMaxAlt->setBrush(Qt::NoBrush);
   tracerMaxAlt->setSize(7);
-  tracerMaxAlt->setGraphKey(c.x.at(positionIndex));
+  tracerMaxAlt->setGraphKey(logEngine.timestamp(c.maxRow));
   tracerMaxAlt->updatePosition();
 }
 
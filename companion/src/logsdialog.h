@@ -24,6 +24,7 @@
 #include <QtCore>
 #include <QDialog>
 #include "qcustomplot.h"
+#include "logengine.h"
 
 #define INVALID_MIN 999999
 #define INVALID_MAX -999999
@@ -32,6 +33,22 @@ namespace Ui {
   class LogsDialog;
 }
 
+class LogTableModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public:
+  explicit LogTableModel(const LogEngine & logEngine, QObject *parent = nullptr);
+  void reload();
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+  const LogEngine & logEngine;
+};
+
 class LogsDialog : public QDialog
 {
   Q_OBJECT
@@ -45,9 +62,12 @@ class LogsDialog : public QDialog
   };
 
   struct coords_t {
-    QVector<double> x, y;
+    int column;
     double min_y;
     double max_y;
+    int maxRow;
+    // applied to the values when several ranges share the same axis
+    double factor;
     yaxes_t yaxis;
     QString name;
   };
@@ -62,6 +82,10 @@ class LogsDialog : public QDialog
     double min_x;
     double max_x;
     bool tooManyRanges;
+    // rows plotted: a range, or the rows selected in the table
+    int firstRow;
+    int lastRow;
+    QVector<int> rows;
   };
 
 public:
@@ -82,9 +106,12 @@ private slots:
   void on_sessions_CB_currentIndexChanged(int index);
   void on_mapsButton_clicked();
   void yAxisChangeRanges(QCPRange range);
+  void xAxisChangeRange(QCPRange range);
 
 private:
-  QList<QStringList> csvlog;
+  LogEngine logEngine;
+  LogTableModel *logModel;
+  plotsCollection plots;
   Ui::LogsDialog *ui;
   QCPAxisRect *axisRect;
   QCPLegend *rightLegend;
@@ -103,12 +130,12 @@ private:
   QCPItemStraightLine * cursorLine;
 
   bool cvsFileParse();
-  QList<QStringList> filterGePoints(const QList<QStringList> & input);
+  QList<QStringList> filterGePoints();
   void exportToGoogleEarth();
-  QDateTime getRecordTimeStamp(int index);
   QString generateDuration(const QDateTime & start, const QDateTime & end);
   void setFlightSessions();
 
+  void setPlotData(const coords_t & c, QCPGraph * graph);
   void addMaxAltitudeMarker(const coords_t & c, QCPGraph * graph);
   void countNumberOfThrows(const coords_t & c, QCPGraph * graph);
   void addCursor(QCPItemTracer ** cursor, QCPGraph * graph, const QColor & color);
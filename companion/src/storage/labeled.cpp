@@ -23,8 +23,37 @@
 #include "firmwares/edgetx/edgetxinterface.h"
 #include "miniz.c"    //  Can only be included once!
 
+#if defined(QT_CONCURRENT)
+  #include <QtConcurrent>
+#endif
 #include <regex>
 
+namespace {
+
+// One model file, read or written sequentially by the storage backend
+// but converted from/to YAML in parallel
+struct YamlModelFile {
+  QString path;
+  std::string filename;
+  int index = 0;
+  QByteArray data;
+  QString error;
+};
+
+template <class Function>
+void mapYamlModelFiles(QVector<YamlModelFile> & files, Function function)
+{
+#if defined(QT_CONCURRENT)
+  QtConcurrent::blockingMap(files, function);
+#else
+  for (auto & file : files) {
+    function(file);
+  }
+#endif
+}
+
+}
+
 bool LabelsStorageFormat::load(RadioData & radioData)
 {
   StorageType st = getStorageType(filename);
@@ -257,13 +286,17 @@ bool LabelsStorageFormat::loadYaml(RadioData & radioData)
   if (hasLabels)
     radioData.models.resize(modelFiles.size());
 
+  // Read all the files first, the storage backends are not thread safe
+  QVector<YamlModelFile> files;
+  std::vector<bool> usedSlots(radioData.models.size(), false);
+
   for (const auto& mc : modelFiles) {
     qDebug() << "Filename: " << mc.filename.c_str();
 
     if (!hasLabels) {
       if (mc.modelIdx >= 0 && mc.modelIdx < (int)radioData.models.size()) {
         modelIdx = mc.modelIdx;
-        if (!radioData.models[modelIdx].isEmpty()) {
+        if (usedSlots[modelIdx]) {
           qDebug() << QString("Warning: file %1 skipped as slot %2 already used").arg(mc.filename.c_str()).arg(mc.modelIdx + 1);
           continue;
         }
@@ -274,38 +307,52 @@ bool LabelsStorageFormat::loadYaml(RadioData & radioData)
       }
     }
 
-    QByteArray modelBuffer;
-    QString filename = "MODELS/" + QString::fromStdString(mc.filename);
-    if (!loadFile(modelBuffer, filename)) {
-      setError(tr("Cannot extract ") + filename);
+    YamlModelFile file;
+    file.path = "MODELS/" + QString::fromStdString(mc.filename);
+    file.filename = mc.filename;
+    file.index = modelIdx;
+    if (!loadFile(file.data, file.path)) {
+      setError(tr("Cannot extract ") + file.path);
       return false;
     }
 
-    // Please note:
-    //  ModelData() use memset to clear everything to 0
-    //
-    auto& model = radioData.models[modelIdx];
+    files.append(file);
+    usedSlots[modelIdx] = true;
+    modelIdx++;
+  }
 
+  // Please note:
+  //  ModelData() use memset to clear everything to 0
+  //
+  auto& models = radioData.models;
+  mapYamlModelFiles(files, [&models](YamlModelFile& file) {
     try {
-      if (!loadModelFromYaml(model,modelBuffer)) {
-        setError(tr("Cannot load ") + filename);
-        return false;
+      if (!loadModelFromYaml(models[file.index], file.data)) {
+        file.error = tr("Cannot load ") + file.path;
       }
     } catch(const std::runtime_error& e) {
-      setError(tr("Cannot load ") + filename + ":\n" + QString(e.what()));
+      file.error = tr("Cannot load ") + file.path + ":\n" + QString(e.what());
+    }
+    file.data.clear();
+  });
+
+  // Errors are reported for the first failing file, whatever the thread scheduling
+  for (const auto& file : files) {
+    if (!file.error.isEmpty()) {
+      setError(file.error);
       return false;
     }
 
-    model.modelIndex = modelIdx;
-    strncpy(model.filename, mc.filename.c_str(), sizeof(model.filename)-1);
+    auto& model = models[file.index];
+    model.modelIndex = file.index;
+    strncpy(model.filename, file.filename.c_str(), sizeof(model.filename)-1);
 
     if (hasLabels && !strncmp(radioData.generalSettings.currModelFilename,
                                   model.filename, sizeof(model.filename))) {
-      radioData.generalSettings.currModelIndex = modelIdx;
+      radioData.generalSettings.currModelIndex = file.index;
     }
 
     model.used = true;
-    modelIdx++;
   }
 
   // Add the labels in the models
@@ -357,7 +404,9 @@ bool LabelsStorageFormat::writeYaml(const RadioData & radioData)
   }
 
   EtxModelfiles modelFiles;
-  for (const auto& model : radioData.models) {
+  QVector<YamlModelFile> files;
+  for (unsigned i = 0; i < radioData.models.size(); i++) {
+    const auto& model = radioData.models[i];
 
     if (model.isEmpty())
       continue;
@@ -374,9 +423,20 @@ bool LabelsStorageFormat::writeYaml(const RadioData & radioData)
                           .arg(model.modelIndex, 2, 10, QLatin1Char('0'));
     }
 
-    QByteArray modelData;
-    writeModelToYaml(model, modelData);
-    if (!writeFile(modelData, modelFilename)) {
+    YamlModelFile file;
+    file.path = modelFilename;
+    file.index = i;
+    files.append(file);
+  }
+
+  const auto& models = radioData.models;
+  mapYamlModelFiles(files, [&models](YamlModelFile& file) {
+    writeModelToYaml(models[file.index], file.data);
+  });
+
+  // Write the files in order, the storage backends are not thread safe
+  for (const auto& file : files) {
+    if (!writeFile(file.data, file.path)) {
       return false;
     }
   }
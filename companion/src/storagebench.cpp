@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Times loading and saving of a synthetic radio profile through the
+// same storage code as Companion, e.g.
+//   storage-bench --models 500 --runs 3 /tmp/profile.etx
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include "storage.h"
+#include "firmwares/opentx/opentxinterface.h"
+
+static void initRadioData(RadioData & radioData, int count)
+{
+  radioData.generalSettings.init();
+  radioData.models.resize(count);
+  for (int i = 0; i < count; i++) {
+    ModelData & model = radioData.models[i];
+    model.setDefaultValues(i, radioData.generalSettings);
+    model.modelIndex = i;
+    snprintf(model.filename, sizeof(model.filename), "model%d.yml", i + 1);
+  }
+  strncpy(radioData.generalSettings.currModelFilename, radioData.models[0].filename,
+          sizeof(radioData.generalSettings.currModelFilename) - 1);
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QTextStream out(stdout);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Companion models storage benchmark");
+  parser.addHelpOption();
+  parser.addOptions({
+    {"models", "Number of models in the profile (default 500).", "count", "500"},
+    {"runs", "Number of load/save runs (default 3).", "count", "3"},
+    {"radio", "Radio firmware flavour, with model labels (default tx16s).", "flavour", "tx16s"},
+  });
+#if defined(QT_CONCURRENT)
+  parser.addOption({"threads", "Maximum number of worker threads (default: all cores).", "count"});
+#endif
+  parser.addPositionalArgument("path", "Profile to write: an .etx file or an existing SD card folder (default: temporary folder).");
+  parser.process(app);
+
+  QLoggingCategory::setFilterRules("*.debug=false");
+  registerStorageFactories();
+  registerOpenTxFirmwares();
+
+  Firmware * firmware = Firmware::getFirmwareForFlavour(parser.value("radio"));
+  if (!firmware || !firmware->getCapability(HasModelLabels)) {
+    out << "Unsupported radio " << parser.value("radio") << "\n";
+    return 1;
+  }
+  Firmware::setCurrentVariant(firmware);
+
+#if defined(QT_CONCURRENT)
+  if (parser.isSet("threads"))
+    QThreadPool::globalInstance()->setMaxThreadCount(parser.value("threads").toInt());
+#endif
+
+  QTemporaryDir tmpDir;
+  QString path = tmpDir.path();
+  if (!parser.positionalArguments().isEmpty())
+    path = parser.positionalArguments().first();
+
+  int count = parser.value("models").toInt();
+  int runs = parser.value("runs").toInt();
+  RadioData radioData;
+  initRadioData(radioData, count);
+
+#if defined(QT_CONCURRENT)
+  out << count << " models, " << QThreadPool::globalInstance()->maxThreadCount()
+      << " threads, " << path << "\n";
+#else
+  out << count << " models, serial, " << path << "\n";
+#endif
+
+  QElapsedTimer timer;
+  for (int run = 0; run < runs; run++) {
+    Storage storage(path);
+
+    timer.start();
+    if (!storage.write(radioData)) {
+      out << "Save failed: " << storage.error() << "\n";
+      return 1;
+    }
+    qint64 saveTime = timer.elapsed();
+
+    RadioData loaded;
+    timer.start();
+    if (!storage.load(loaded)) {
+      out << "Load failed: " << storage.error() << "\n";
+      return 1;
+    }
+    qint64 loadTime = timer.elapsed();
+
+    int used = 0;
+    for (const auto & model : loaded.models) {
+      if (!model.isEmpty())
+        used++;
+    }
+    if (used != count) {
+      out << "Loaded " << used << " models instead of " << count << "\n";
+      return 1;
+    }
+
+    out << "run " << run + 1 << ": save " << saveTime << " ms, load " << loadTime << " ms\n";
+    out.flush();
+  }
+
+  unregisterStorageFactories();
+  unregisterOpenTxFirmwares();
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "gtests.h"
+#include "logengine.h"
+
+#include <QTemporaryDir>
+
+static QString writeLog(const QTemporaryDir & dir, const QByteArray & content)
+{
+  QString filename = dir.path() + "/log.csv";
+  QFile file(filename);
+  file.open(QIODevice::WriteOnly);
+  file.write(content);
+  file.close();
+  return filename;
+}
+
+TEST(LogEngine, parse)
+{
+  QTemporaryDir dir;
+  LogEngine log;
+
+  ASSERT_TRUE(log.open(writeLog(dir,
+    "Date,Time,Alt(m),RSSI(dB),GPS\r\n"
+    "2023-05-14,10:00:00.100,12.5,80,45.100000 7.200000\r\n"
+    "2023-05-14,10:00:00.200,-3,81,45.100001 7.200001\r\n"
+    "2023-05-14,10:00\r\n"
+    "\r\n"
+    "2023-05-14,10:02:00.200,7.25,82,\r\n")));
+
+  EXPECT_EQ(3, log.rowCount());
+  EXPECT_EQ(5, log.columnCount());
+  EXPECT_EQ(4, log.totalLines());
+  EXPECT_EQ(1, log.invalidLines());
+  EXPECT_EQ(QString("RSSI(dB)"), log.columnNames().at(3));
+
+  EXPECT_EQ(LogEngine::COLUMN_TIMESTAMP, log.columnType(1));
+  EXPECT_EQ(LogEngine::COLUMN_NUMBER, log.columnType(2));
+  EXPECT_EQ(LogEngine::COLUMN_INTEGER, log.columnType(3));
+  EXPECT_EQ(LogEngine::COLUMN_TEXT, log.columnType(4));
+
+  EXPECT_EQ(12.5, log.value(0, 2));
+  EXPECT_EQ(-3, log.value(1, 2));
+  EXPECT_EQ(82, log.value(2, 3));
+  EXPECT_NEAR(0.1, log.timestamp(1) - log.timestamp(0), 0.0001);
+  EXPECT_EQ(QDateTime::fromString("2023-05-14 10:00:00.100", "yyyy-MM-dd HH:mm:ss.zzz"), log.dateTime(0));
+
+  EXPECT_EQ(QString("45.100001 7.200001"), log.cell(1, 4));
+  EXPECT_EQ(QString(""), log.cell(2, 4));
+  EXPECT_EQ(QByteArray("2023-05-14,10:02:00.200,7.25,82,"), log.line(2));
+
+  QVector<int> sessions = log.getSessions();
+  ASSERT_EQ(2, sessions.size());
+  EXPECT_EQ(2, sessions.at(1));
+}
+
+TEST(LogEngine, decimation)
+{
+  QTemporaryDir dir;
+  QByteArray content = "Date,Time,Alt(m)\n";
+  for (int i = 0; i < 100000; i++) {
+    int value = (i * 7919) % 1000;
+    content += QString("2023-05-14,%1:%2:%3.%4,%5\n")
+      .arg(10 + i / 36000).arg(i / 600 % 60, 2, 10, QChar('0'))
+      .arg(i / 10 % 60, 2, 10, QChar('0')).arg(i % 10 * 100, 3, 10, QChar('0'))
+      .arg(value).toUtf8();
+  }
+
+  LogEngine log;
+  ASSERT_TRUE(log.open(writeLog(dir, content)));
+  ASSERT_EQ(100000, log.rowCount());
+  EXPECT_TRUE(log.isMonotonic());
+  EXPECT_EQ(5000, log.findRow(log.timestamp(5000), 0, log.rowCount() - 1));
+
+  QVector<double> x, y;
+  log.getPlotData(2, 123, 87654, 500, x, y);
+  EXPECT_GE(x.size(), 500);
+  EXPECT_LT(x.size(), 4000);
+  EXPECT_EQ(x.size(), y.size());
+  EXPECT_EQ(log.timestamp(123), x.first());
+  EXPECT_EQ(log.timestamp(87654), x.last());
+
+  double min = 1000, max = -1;
+  for (int row = 123; row <= 87654; row++) {
+    min = qMin(min, log.value(row, 2));
+    max = qMax(max, log.value(row, 2));
+  }
+  EXPECT_EQ(min, *std::min_element(y.begin(), y.end()));
+  EXPECT_EQ(max, *std::max_element(y.begin(), y.end()));
+  for (int i = 1; i < x.size(); i++) {
+    EXPECT_LT(x.at(i - 1), x.at(i));
+  }
+}
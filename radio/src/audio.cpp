@@ -499,6 +499,7 @@ void playModelName()
 
 AudioQueue audioQueue __DMA;      // to place it in the RAM section on Horus, to have file buffers in RAM for DMA access
 AudioBuffer audioBuffers[AUDIO_BUFFER_COUNT] __DMA;
+static AudioMixBuffer mixBuffer;
 
 AudioQueue::AudioQueue()
   : buffersFifo(),
@@ -512,6 +513,7 @@ AudioQueue::AudioQueue()
 }
 
 #define CODEC_ID_PCM_S16LE  1
+#define CODEC_ID_IMA_ADPCM  0x11
 
 #if !defined(SIMU)
 void audioTask(void * pdata)
@@ -537,9 +539,32 @@ void audioTask(void * pdata)
 }
 #endif
 
-inline void mixSample(audio_data_t * result, int sample, unsigned int fade)
+inline void mixSample(int32_t * result, int sample, unsigned int fade)
 {
-  *result = limit(AUDIO_DATA_MIN, *result + ((sample >> fade) >> (16-AUDIO_BITS_PER_SAMPLE)), AUDIO_DATA_MAX);
+  *result += (sample >> fade);
+}
+
+inline audio_data_t saturateSample(int32_t sample)
+{
+#if defined(__ARM_FEATURE_SAT)
+  if (AUDIO_DATA_MIN < 0)
+    return __SSAT(sample, AUDIO_BITS_PER_SAMPLE);
+  else
+    return __USAT(sample, AUDIO_BITS_PER_SAMPLE);
+#else
+  return limit<int32_t>(AUDIO_DATA_MIN, sample, AUDIO_DATA_MAX);
+#endif
+}
+
+void audioMixOutput(audio_data_t * output, const int32_t * mix, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t sample = mix[i] >> (16-AUDIO_BITS_PER_SAMPLE);
+#if defined(SOFTWARE_VOLUME)
+    sample = (sample * currentSpeakerVolume) / VOLUME_LEVEL_MAX;
+#endif
+    output[i] = saturateSample(sample + AUDIO_DATA_SILENCE);
+  }
 }
 
 #if defined(SDCARD)
@@ -547,29 +572,304 @@ inline void mixSample(audio_data_t * result, int sample, unsigned int fade)
 #define RIFF_CHUNK_SIZE 12
 uint8_t wavBuffer[AUDIO_BUFFER_SIZE*2] __DMA;
 
-int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+static_assert(WAV_READAHEAD_SIZE == 0 || WAV_READAHEAD_SIZE >= AUDIO_BUFFER_SIZE*2 + 4, "WAV_READAHEAD_SIZE too small for one audio buffer");
+
+#if defined(AUDIO_PROMPTS_CACHE)
+static uint8_t audioPromptsCacheData[AUDIO_PROMPTS_CACHE_SLOTS][AUDIO_PROMPTS_CACHE_SLOT_SIZE] __SDRAM;
+
+AudioPromptsCache audioPromptsCache;
+
+AudioPromptsCache::AudioPromptsCache()
+{
+  for (int i = 0; i < AUDIO_PROMPTS_CACHE_SLOTS; i++) {
+    slots[i].data = audioPromptsCacheData[i];
+  }
+  clear();
+}
+
+void AudioPromptsCache::clear()
+{
+  for (auto & slot : slots) {
+    slot.file[0] = '\0';
+    slot.state = SLOT_EMPTY;
+    slot.lastUse = 0;
+    slot.owner = nullptr;
+  }
+  useCounter = 0;
+  memclear(&stats, sizeof(stats));
+}
+
+AudioPromptsCache::Slot * AudioPromptsCache::find(const char * file, const WavContext * owner)
+{
+  for (auto & slot : slots) {
+    if (slot.state == SLOT_VALID && !strcmp(slot.file, file)) {
+      slot.lastUse = ++useCounter;
+      slot.owner = owner;
+      stats.noHits++;
+      return &slot;
+    }
+  }
+  stats.noMisses++;
+  return nullptr;
+}
+
+AudioPromptsCache::Slot * AudioPromptsCache::allocate(const char * file, uint32_t size, const WavContext * owner)
+{
+  if (size > AUDIO_PROMPTS_CACHE_SLOT_SIZE)
+    return nullptr;
+
+  Slot * result = nullptr;
+  for (auto & slot : slots) {
+    if (slot.state == SLOT_FILLING && !strcmp(slot.file, file))
+      return nullptr;   // already being filled by the other context
+    if (slot.owner == nullptr && (!result || slot.state == SLOT_EMPTY || (result->state != SLOT_EMPTY && slot.lastUse < result->lastUse)))
+      result = &slot;
+  }
+
+  if (result) {
+    strcpy(result->file, file);
+    result->state = SLOT_FILLING;
+    result->size = size;
+    result->lastUse = ++useCounter;
+    result->owner = owner;
+  }
+  return result;
+}
+
+void AudioPromptsCache::release(const WavContext * owner)
+{
+  for (auto & slot : slots) {
+    if (slot.owner == owner) {
+      slot.owner = nullptr;
+      if (slot.state == SLOT_FILLING)
+        slot.state = SLOT_EMPTY;
+    }
+  }
+}
+
+int AudioPromptsCache::getHitRate() const
+{
+  uint32_t all = stats.noHits + stats.noMisses;
+  if (all == 0) return 0;
+  return (stats.noHits * 1000) / all;
+}
+#endif
+
+// Returns up to 'size' bytes of data (less only at the end of the data),
+// taken from the cached prompt, or from the read-ahead buffer which is
+// refilled from the file once it holds less than 'size' bytes. Without
+// read-ahead, the data is read into wavBuffer.
+// Returns -1 on error.
+int WavContext::readData(const uint8_t ** data, uint16_t size)
+{
+#if defined(AUDIO_PROMPTS_CACHE)
+  if (state.cacheSlot && state.cacheSlot->state == AudioPromptsCache::SLOT_VALID) {
+    uint32_t count = min<uint32_t>(size, state.size);
+    *data = state.cacheSlot->data + state.cachePos;
+    state.cachePos += count;
+    state.size -= count;
+    return count;
+  }
+#endif
+
+#if WAV_READAHEAD_SIZE > 0
+  uint16_t remaining = state.bufferLen - state.bufferPos;
+  if (remaining < size && state.size > 0) {
+    // the remaining bytes are moved to end on a 32 bits boundary, where
+    // the new data is read (SD card DMA transfers need aligned buffers)
+    uint16_t start = -remaining & 3;
+    memmove(readAhead + start, readAhead + state.bufferPos, remaining);
+    state.bufferPos = start;
+    state.bufferLen = start + remaining;
+
+    // end the read on a sector boundary when possible, so that the next
+    // reads start on a sector, and FatFs transfers the whole sectors
+    // straight into the buffer
+    uint32_t position = f_tell(&state.file);
+    uint32_t count = WAV_READAHEAD_SIZE - state.bufferLen;
+    uint32_t aligned = ((position + count) & ~(uint32_t)(FF_MIN_SS - 1)) - position;
+    if (remaining + aligned >= size && aligned < count)
+      count = aligned;
+    if (count > state.size)
+      count = state.size;
+
+    UINT read = 0;
+    if (f_read(&state.file, readAhead + state.bufferLen, count, &read) != FR_OK)
+      return -1;
+    state.bufferLen += read;
+    state.size = (read == count ? state.size - read : 0);
+  }
+
+  uint16_t count = min<uint16_t>(size, state.bufferLen - state.bufferPos);
+  *data = readAhead + state.bufferPos;
+  state.bufferPos += count;
+#else
+  UINT count = 0;
+  if (state.size > 0) {
+    uint32_t size32 = min<uint32_t>(size, state.size);
+    if (f_read(&state.file, wavBuffer, size32, &count) != FR_OK)
+      return -1;
+    state.size = (count == size32 ? state.size - count : 0);
+  }
+  *data = wavBuffer;
+#endif
+
+#if defined(AUDIO_PROMPTS_CACHE)
+  if (state.cacheSlot) {
+    if (state.cachePos + count <= state.cacheSlot->size) {
+      memcpy(state.cacheSlot->data + state.cachePos, *data, count);
+      state.cachePos += count;
+    }
+  }
+#endif
+
+  return count;
+}
+
+// Checks the format read from the header (or the cached prompt) and
+// prepares the decoding
+bool WavContext::setupCodec()
+{
+  state.bufferPos = 0;
+  state.bufferLen = 0;
+
+  if (state.freq == 0 || state.freq > WAV_MAX_SAMPLE_RATE)
+    return false;
+
+  if (state.codec == CODEC_ID_PCM_S16LE && state.freq * (AUDIO_SAMPLE_RATE / state.freq) == AUDIO_SAMPLE_RATE) {
+    // samples are repeated, as this is cheaper than interpolating them
+    state.resampleRatio = (AUDIO_SAMPLE_RATE / state.freq);
+    state.readSize = 2*AUDIO_BUFFER_SIZE / state.resampleRatio;
+    return true;
+  }
+
+  if (state.codec == CODEC_ID_PCM_S16LE || (state.codec == CODEC_ID_IMA_ADPCM && state.blockAlign > IMA_ADPCM_BLOCK_HEADER_SIZE)) {
+    state.resampleRatio = 0;
+    state.blockPos = 0;
+    state.decodedPos = 0;
+    state.decodedLen = 0;
+    state.resampler.init(state.freq, AUDIO_SAMPLE_RATE);
+    return true;
+  }
+
+  return false;
+}
+
+// Decodes the next samples into 'decoded'. Returns the number of samples,
+// 0 at the end of the data, -1 on error.
+int WavContext::decodeSamples()
+{
+  const uint8_t * data;
+  int count;
+
+  if (state.codec == CODEC_ID_IMA_ADPCM) {
+    if (state.blockPos == 0) {
+      count = readData(&data, IMA_ADPCM_BLOCK_HEADER_SIZE);
+      if (count < IMA_ADPCM_BLOCK_HEADER_SIZE)
+        return min(count, 0);
+      decoded[0] = state.adpcm.decodeHeader(data);
+      state.blockPos = IMA_ADPCM_BLOCK_HEADER_SIZE;
+      return 1;
+    }
+    count = readData(&data, min<uint16_t>(WAV_DECODED_SAMPLES / 2, state.blockAlign - state.blockPos));
+    for (int i = 0; i < count; i++) {
+      decoded[2*i] = state.adpcm.decode(data[i] & 0x0F);
+      decoded[2*i+1] = state.adpcm.decode(data[i] >> 4);
+    }
+    state.blockPos += count;
+    if (state.blockPos >= state.blockAlign)
+      state.blockPos = 0;
+    return count < 0 ? count : 2*count;
+  }
+
+  count = readData(&data, WAV_DECODED_SAMPLES * 2);
+  if (count > 0) {
+    count /= 2;
+    memcpy(decoded, data, count * 2);
+  }
+  return count;
+}
+
+// Mixes one buffer of data whose rate is a divisor of AUDIO_SAMPLE_RATE.
+// Returns the number of samples mixed, less than a buffer at the end of the
+// data, -1 on error.
+int WavContext::mixRepeated(AudioMixBuffer * buffer, int volume, unsigned int fade)
+{
+  const uint8_t * data;
+  int count = readData(&data, state.readSize);
+  if (count < 0)
+    return count;
+
+  int32_t * samples = buffer->data;
+  count /= 2;
+  for (int i=0; i<count; i++) {
+    // the data may start at an odd address after a refill
+    int16_t sample;
+    memcpy(&sample, data + 2 * i, sizeof(sample));
+    for (uint8_t j=0; j<state.resampleRatio; j++) {
+      mixSample(samples++, sample, fade+2-volume);
+    }
+  }
+  return samples - buffer->data;
+}
+
+// Mixes one buffer of resampled data. Returns the number of samples mixed,
+// less than a buffer at the end of the data, -1 on error.
+int WavContext::mixResampled(AudioMixBuffer * buffer, int volume, unsigned int fade)
+{
+  int32_t * samples = buffer->data;
+  int32_t * end = samples + AUDIO_BUFFER_SIZE;
+
+  while (samples < end) {
+    while (state.resampler.needsInput()) {
+      if (state.decodedPos == state.decodedLen) {
+        int count = decodeSamples();
+        if (count <= 0)
+          return count < 0 ? count : samples - buffer->data;
+        state.decodedPos = 0;
+        state.decodedLen = count;
+      }
+      state.resampler.push(decoded[state.decodedPos++]);
+    }
+    mixSample(samples++, state.resampler.next(), fade+2-volume);
+  }
+
+  return samples - buffer->data;
+}
+
+int WavContext::mixBuffer(AudioMixBuffer * buffer, int volume, unsigned int fade)
 {
   FRESULT result = FR_OK;
   UINT read = 0;
 
   if (fragment.file[1]) {
+#if defined(AUDIO_PROMPTS_CACHE)
+    audioPromptsCache.release(this);
+    state.cacheSlot = audioPromptsCache.find(fragment.file, this);
+    if (state.cacheSlot) {
+      fragment.file[1] = 0;
+      state.codec = state.cacheSlot->codec;
+      state.freq = state.cacheSlot->freq;
+      state.blockAlign = state.cacheSlot->blockAlign;
+      state.size = state.cacheSlot->size;
+      state.cachePos = 0;
+      setupCodec();
+    }
+    else
+#endif
     result = f_open(&state.file, fragment.file, FA_OPEN_EXISTING | FA_READ);
-    fragment.file[1] = 0;
-    if (result == FR_OK) {
+    if (fragment.file[1] && result == FR_OK) {
       result = f_read(&state.file, wavBuffer, RIFF_CHUNK_SIZE+8, &read);
       if (result == FR_OK && read == RIFF_CHUNK_SIZE+8 && !memcmp(wavBuffer, "RIFF", 4) && !memcmp(wavBuffer+8, "WAVEfmt ", 8)) {
         uint32_t size = *((uint32_t *)(wavBuffer+16));
         result = (size < 256 ? f_read(&state.file, wavBuffer, size+8, &read) : FR_DENIED);
         if (result == FR_OK && read == size+8) {
           state.codec = ((uint16_t *)wavBuffer)[0];
-          state.freq = ((uint16_t *)wavBuffer)[2];
+          state.freq = ((uint32_t *)wavBuffer)[1];
+          state.blockAlign = ((uint16_t *)wavBuffer)[6];
           uint32_t *wavSamplesPtr = (uint32_t *)(wavBuffer + size);
           uint32_t size = wavSamplesPtr[1];
-          if (state.freq != 0 && state.freq * (AUDIO_SAMPLE_RATE / state.freq) == AUDIO_SAMPLE_RATE) {
-            state.resampleRatio = (AUDIO_SAMPLE_RATE / state.freq);
-            state.readSize = (state.codec == CODEC_ID_PCM_S16LE ? 2*AUDIO_BUFFER_SIZE : AUDIO_BUFFER_SIZE) / state.resampleRatio;
-          }
-          else {
+          if (((uint16_t *)wavBuffer)[1] != 1 || !setupCodec()) {
             result = FR_DENIED;
           }
           while (result == FR_OK && memcmp(wavSamplesPtr, "data", 4) != 0) {
@@ -582,6 +882,17 @@ int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
             }
           }
           state.size = size;
+#if defined(AUDIO_PROMPTS_CACHE)
+          if (result == FR_OK) {
+            state.cacheSlot = audioPromptsCache.allocate(fragment.file, size, this);
+            state.cachePos = 0;
+            if (state.cacheSlot) {
+              state.cacheSlot->codec = state.codec;
+              state.cacheSlot->freq = state.freq;
+              state.cacheSlot->blockAlign = state.blockAlign;
+            }
+          }
+#endif
         }
         else {
           result = FR_DENIED;
@@ -591,34 +902,27 @@ int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
         result = FR_DENIED;
       }
     }
+    fragment.file[1] = 0;
   }
 
   if (result == FR_OK) {
-    read = 0;
-    result = f_read(&state.file, wavBuffer, state.readSize, &read);
-    if (result == FR_OK) {
-      if (read > state.size) {
-        read = state.size;
-      }
-      state.size -= read;
-
-      if (read != state.readSize) {
+    int count = (state.resampleRatio ? mixRepeated(buffer, volume, fade) : mixResampled(buffer, volume, fade));
+    if (count >= 0) {
+      if (count < AUDIO_BUFFER_SIZE) {
+#if defined(AUDIO_PROMPTS_CACHE)
+        if (state.cacheSlot && state.cacheSlot->state == AudioPromptsCache::SLOT_FILLING) {
+          // only prompts read up to the end of their data are kept
+          state.cacheSlot->state = (state.cachePos == state.cacheSlot->size ? AudioPromptsCache::SLOT_VALID : AudioPromptsCache::SLOT_EMPTY);
+          f_close(&state.file);
+        }
+        else if (!state.cacheSlot)
+#endif
         f_close(&state.file);
         fragment.clear();
       }
-
-      audio_data_t * samples = buffer->data;
-      if (state.codec == CODEC_ID_PCM_S16LE) {
-        read /= 2;
-        for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, ((int16_t *)wavBuffer)[i], fade+2-volume);
-          }
-        }
-      }
-
-      return samples - buffer->data;
+      return count;
     }
+    result = FR_DISK_ERR;
   }
 
   if (result != FR_OK) {
@@ -627,7 +931,7 @@ int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
   return 0;
 }
 #else
-int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+int WavContext::mixBuffer(AudioMixBuffer * buffer, int volume, unsigned int fade)
 {
   return 0;
 }
@@ -643,7 +947,7 @@ inline float evalVolumeRatio(int freq, int volume)
   return result;
 }
 
-int ToneContext::mixBuffer(AudioBuffer * buffer, int volume, unsigned int fade)
+int ToneContext::mixBuffer(AudioMixBuffer * buffer, int volume, unsigned int fade)
 {
   int duration = 0;
   int result = 0;
@@ -740,13 +1044,10 @@ void AudioQueue::wakeup()
     unsigned int fade = 0;
     int size = 0;
 
-    // write silence in the buffer
-    for (uint32_t i=0; i<AUDIO_BUFFER_SIZE; i++) {
-      buffer->data[i] = AUDIO_DATA_SILENCE; /* silence */
-    }
+    memclear(&mixBuffer, sizeof(mixBuffer));
 
     // mix the priority context (only tones)
-    result = priorityContext.mixBuffer(buffer, g_eeGeneral.beepVolume, fade);
+    result = priorityContext.mixBuffer(&mixBuffer, g_eeGeneral.beepVolume, fade);
     if (result > 0) {
       size = result;
       fade += 1;
@@ -758,14 +1059,14 @@ void AudioQueue::wakeup()
       normalContext.setFragment(fragmentsFifo.get());
       RTOS_UNLOCK_MUTEX(audioMutex);
     }
-    result = normalContext.mixBuffer(buffer, g_eeGeneral.beepVolume, g_eeGeneral.wavVolume, fade);
+    result = normalContext.mixBuffer(&mixBuffer, g_eeGeneral.beepVolume, g_eeGeneral.wavVolume, fade);
     if (result > 0) {
       size = max(size, result);
       fade += 1;
     }
 
     // mix the vario context
-    result = varioContext.mixBuffer(buffer, g_eeGeneral.varioVolume, fade);
+    result = varioContext.mixBuffer(&mixBuffer, g_eeGeneral.varioVolume, fade);
     if (result > 0) {
       size = max(size, result);
       fade += 1;
@@ -773,7 +1074,7 @@ void AudioQueue::wakeup()
 
     // mix the background context
     if (isFunctionActive(FUNCTION_BACKGND_MUSIC) && !isFunctionActive(FUNCTION_BACKGND_MUSIC_PAUSE)) {
-      result = backgroundContext.mixBuffer(buffer, g_eeGeneral.backgroundVolume, fade);
+      result = backgroundContext.mixBuffer(&mixBuffer, g_eeGeneral.backgroundVolume, fade);
       if (result > 0) {
         size = max(size, result);
       }
@@ -786,16 +1087,14 @@ void AudioQueue::wakeup()
 
 #if defined(SOFTWARE_VOLUME)
       if (currentSpeakerVolume > 0) {
-        for (uint32_t i=0; i<buffer->size; ++i) {
-          int32_t tmpSample = (int32_t) ((uint32_t) (buffer->data[i]) - AUDIO_DATA_SILENCE);  // conversion from uint16_t
-          buffer->data[i] = (int16_t) (((tmpSample * currentSpeakerVolume) / VOLUME_LEVEL_MAX) + AUDIO_DATA_SILENCE);
-        }
+        audioMixOutput(buffer->data, mixBuffer.data, AUDIO_BUFFER_SIZE);
         buffersFifo.audioPushBuffer();
       }
       else {
         break;
       }
 #else
+      audioMixOutput(buffer->data, mixBuffer.data, AUDIO_BUFFER_SIZE);
       buffersFifo.audioPushBuffer();
 #endif
     }
@@ -925,6 +1224,12 @@ void AudioQueue::stopSD()
 {
   sdAvailableSystemAudioFiles.reset();
   stopAll();
+#if defined(AUDIO_PROMPTS_CACHE)
+  // the files may be changed while the SD card is not mounted
+  RTOS_LOCK_MUTEX(audioMutex);
+  audioPromptsCache.clear();
+  RTOS_UNLOCK_MUTEX(audioMutex);
+#endif
   playTone(0, 0, 100, PLAY_NOW);        // insert a 100ms pause
 }
 
@@ -27,6 +27,7 @@
 #include "ff.h"
 #include "opentx_types.h"
 #include "dataconstants.h"
+#include "audio_codecs.h"
 
 /*
   Implements a bit field, number of bits is set by the template,
@@ -79,7 +80,9 @@ constexpr uint8_t AUDIO_FILENAME_MAXLEN = (AUDIO_LUA_FILENAME_MAXLEN > AUDIO_MOD
 #define AUDIO_BUFFER_DURATION          (10)
 #define AUDIO_BUFFER_SIZE              (AUDIO_SAMPLE_RATE*AUDIO_BUFFER_DURATION/1000)
 
-#if defined(SIMU) && defined(SIMU_AUDIO)
+#if defined(AUDIO_BUFFER_COUNT)
+  // set by the build, more buffers ride through longer stalls of the audio task
+#elif defined(SIMU) && defined(SIMU_AUDIO)
   #define AUDIO_BUFFER_COUNT           (10) // simulator needs more buffers for smooth audio
 #elif defined(PCBX12S)
   #define AUDIO_BUFFER_COUNT           (2)  // smaller than Taranis since there is also a buffer on the ADC chip
@@ -87,6 +90,34 @@ constexpr uint8_t AUDIO_FILENAME_MAXLEN = (AUDIO_LUA_FILENAME_MAXLEN > AUDIO_MOD
   #define AUDIO_BUFFER_COUNT           (3)
 #endif
 
+// WAV data is read ahead in large chunks, so that the SD card is accessed
+// once every few audio buffers with whole sectors. Each prompt context has
+// its own buffer, B&W targets can't spare the RAM and read each audio
+// buffer when it is mixed.
+#if defined(WAV_READAHEAD_SIZE)
+  // set by the build
+#elif defined(SDRAM)
+  #define WAV_READAHEAD_SIZE           (4096)
+#else
+  #define WAV_READAHEAD_SIZE           (0)
+#endif
+
+// Samples decoded at once ahead of the resampler (files whose rate is
+// not a divisor of AUDIO_SAMPLE_RATE, IMA-ADPCM files)
+#define WAV_DECODED_SAMPLES            (64)
+#define WAV_MAX_SAMPLE_RATE            (48000)
+
+// Recently played prompts are kept in RAM on targets with SDRAM
+#if !defined(AUDIO_PROMPTS_CACHE_SLOTS)
+  #define AUDIO_PROMPTS_CACHE_SLOTS     (16)
+#endif
+#if !defined(AUDIO_PROMPTS_CACHE_SLOT_SIZE)
+  #define AUDIO_PROMPTS_CACHE_SLOT_SIZE (64*1024)
+#endif
+#if defined(SDRAM) && AUDIO_PROMPTS_CACHE_SLOTS > 0
+  #define AUDIO_PROMPTS_CACHE
+#endif
+
 #define BEEP_MIN_FREQ                  (150)
 #define BEEP_MAX_FREQ                  (15000)
 #define BEEP_DEFAULT_FREQ              (2250)
@@ -130,6 +161,15 @@ struct AudioBuffer {
 
 extern AudioBuffer audioBuffers[AUDIO_BUFFER_COUNT];
 
+// The voices (tones, prompts, vario, background music) are added in 32 bits
+// at 16 bits resolution, each one shifted by its volume and ducking. The
+// result is converted to the DAC format with one saturation per sample.
+struct AudioMixBuffer {
+  int32_t data[AUDIO_BUFFER_SIZE];
+};
+
+void audioMixOutput(audio_data_t * output, const int32_t * mix, uint32_t count);
+
 enum FragmentTypes {
   FRAGMENT_EMPTY,
   FRAGMENT_TONE,
@@ -197,7 +237,7 @@ class ToneContext {
       return fragment.type == FRAGMENT_EMPTY;
     }
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int mixBuffer(AudioMixBuffer * buffer, int volume, unsigned int fade);
 
     void setFragment(uint16_t freq, uint16_t duration, uint16_t pause, uint8_t repeat, int8_t freqIncr, bool reset, uint8_t id=0)
     {
@@ -218,12 +258,61 @@ class ToneContext {
 
 };
 
+#if defined(AUDIO_PROMPTS_CACHE)
+class WavContext;
+
+struct AudioPromptsCacheStats {
+  uint32_t noHits;
+  uint32_t noMisses;
+};
+
+// LRU cache of the data of the recently played prompts: a slot is filled
+// while the file is played, and only used once the whole file was read
+class AudioPromptsCache {
+  public:
+    enum SlotState {
+      SLOT_EMPTY,
+      SLOT_FILLING,
+      SLOT_VALID
+    };
+
+    struct Slot {
+      char file[AUDIO_FILENAME_MAXLEN+1];
+      uint8_t state;
+      uint8_t codec;
+      uint16_t blockAlign;
+      uint32_t freq;
+      uint32_t size;
+      uint32_t lastUse;
+      const WavContext * owner;   // slots played or filled are not evicted
+      uint8_t * data;
+    };
+
+    AudioPromptsCache();
+
+    Slot * find(const char * file, const WavContext * owner);
+    Slot * allocate(const char * file, uint32_t size, const WavContext * owner);
+    void release(const WavContext * owner);
+    void clear();
+
+    const AudioPromptsCacheStats & getStats() const { return stats; }
+    int getHitRate() const;
+
+  private:
+    Slot slots[AUDIO_PROMPTS_CACHE_SLOTS];
+    uint32_t useCounter;
+    AudioPromptsCacheStats stats;
+};
+
+extern AudioPromptsCache audioPromptsCache;
+#endif
+
 class WavContext {
   public:
 
     inline void clear() { fragment.clear(); };
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int mixBuffer(AudioMixBuffer * buffer, int volume, unsigned int fade);
     bool hasPromptId(uint8_t id) const { return fragment.id == id; };
 
     void setFragment(const char * filename, uint8_t repeat, uint8_t id)
@@ -246,9 +335,33 @@ class WavContext {
       uint8_t  codec;
       uint32_t freq;
       uint32_t size;
-      uint8_t  resampleRatio;
+      uint8_t  resampleRatio;     // 0 when the rate is converted by the resampler
       uint16_t readSize;
+      uint16_t bufferPos;         // next byte to play in readAhead
+      uint16_t bufferLen;         // bytes available in readAhead
+      uint16_t blockAlign;        // IMA-ADPCM block size
+      uint16_t blockPos;          // position in the current IMA-ADPCM block
+      uint8_t  decodedPos;        // next sample to resample in decoded
+      uint8_t  decodedLen;
+      ImaAdpcmDecoder adpcm;
+      LinearResampler resampler;
+#if defined(AUDIO_PROMPTS_CACHE)
+      AudioPromptsCache::Slot * cacheSlot;  // slot played, or filled while playing the file
+      uint32_t cachePos;
+#endif
     } state;
+
+#if WAV_READAHEAD_SIZE > 0
+    // WavContext only lives in audioQueue, which is in the __DMA section
+    uint8_t readAhead[WAV_READAHEAD_SIZE] __ALIGNED(4);
+#endif
+    int16_t decoded[WAV_DECODED_SAMPLES];
+
+    bool setupCodec();
+    int readData(const uint8_t ** data, uint16_t size);
+    int decodeSamples();
+    int mixRepeated(AudioMixBuffer * buffer, int volume, unsigned int fade);
+    int mixResampled(AudioMixBuffer * buffer, int volume, unsigned int fade);
 };
 
 class MixedContext {
@@ -279,7 +392,7 @@ class MixedContext {
     bool isFile() const { return fragment.type == FRAGMENT_FILE; };
     bool hasPromptId(uint8_t id) const { return fragment.id == id; };
 
-    int mixBuffer(AudioBuffer *buffer, int toneVolume, int wavVolume, unsigned int fade)
+    int mixBuffer(AudioMixBuffer * buffer, int toneVolume, int wavVolume, unsigned int fade)
     {
       if (isTone())
         return tone.mixBuffer(buffer, toneVolume, fade);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "audio_codecs.h"
+
+static const int16_t imaStepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+  19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+  130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+  337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+  2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+  5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t imaIndexTable[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+int16_t ImaAdpcmDecoder::decodeHeader(const uint8_t * header)
+{
+  predictor = int16_t(header[0] | (header[1] << 8));
+  index = (header[2] > 88 ? 88 : header[2]);
+  return predictor;
+}
+
+int16_t ImaAdpcmDecoder::decode(uint8_t nibble)
+{
+  int32_t step = imaStepTable[index];
+  int32_t diff = step >> 3;
+  if (nibble & 1) diff += step >> 2;
+  if (nibble & 2) diff += step >> 1;
+  if (nibble & 4) diff += step;
+
+  int32_t value = (nibble & 8) ? predictor - diff : predictor + diff;
+  if (value > INT16_MAX) value = INT16_MAX;
+  else if (value < INT16_MIN) value = INT16_MIN;
+  predictor = value;
+
+  int32_t newIndex = index + imaIndexTable[nibble & 0x0F];
+  index = (newIndex < 0 ? 0 : (newIndex > 88 ? 88 : newIndex));
+
+  return predictor;
+}
+
+unsigned imaAdpcmDecodeBlock(const uint8_t * block, unsigned size, int16_t * samples)
+{
+  if (size < IMA_ADPCM_BLOCK_HEADER_SIZE)
+    return 0;
+
+  ImaAdpcmDecoder decoder;
+  int16_t * output = samples;
+  *output++ = decoder.decodeHeader(block);
+  for (unsigned i = IMA_ADPCM_BLOCK_HEADER_SIZE; i < size; i++) {
+    *output++ = decoder.decode(block[i] & 0x0F);
+    *output++ = decoder.decode(block[i] >> 4);
+  }
+  return output - samples;
+}
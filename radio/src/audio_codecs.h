@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _AUDIO_CODECS_H_
+#define _AUDIO_CODECS_H_
+
+#include <inttypes.h>
+
+#define IMA_ADPCM_BLOCK_HEADER_SIZE    4
+
+// IMA-ADPCM (WAV format 0x11) mono decoder. Each block starts with a header
+// holding the first sample and the step index, followed by 4 bits samples,
+// least significant nibble first.
+class ImaAdpcmDecoder {
+  public:
+    // returns the first sample of the block
+    int16_t decodeHeader(const uint8_t * header);
+
+    int16_t decode(uint8_t nibble);
+
+  private:
+    int16_t predictor;
+    uint8_t index;
+};
+
+// decodes a whole block, returns the number of samples
+unsigned imaAdpcmDecodeBlock(const uint8_t * block, unsigned size, int16_t * samples);
+
+// Streaming linear interpolation resampler, for any ratio between the input
+// and output rates. The position between the last two input samples is kept
+// in 16.16 fixed point, the remainder of the step is accumulated apart, so
+// that the output does not drift over long files.
+class LinearResampler {
+  public:
+    static constexpr uint32_t ONE = 1 << 16;
+
+    void init(uint32_t inputRate, uint32_t outputRate)
+    {
+      step = (uint64_t(inputRate) << 16) / outputRate;
+      stepRemainder = (uint64_t(inputRate) << 16) % outputRate;
+      rate = outputRate;
+      remainder = 0;
+      phase = 2 * ONE;  // the first output sample is the first input sample
+      previous = current = 0;
+    }
+
+    bool needsInput() const
+    {
+      return phase >= ONE;
+    }
+
+    void push(int16_t sample)
+    {
+      previous = current;
+      current = sample;
+      phase -= ONE;
+    }
+
+    int16_t next()
+    {
+      int16_t result = previous + (((current - previous) * int32_t(phase >> 1)) >> 15);
+      phase += step;
+      remainder += stepRemainder;
+      if (remainder >= rate) {
+        remainder -= rate;
+        phase += 1;
+      }
+      return result;
+    }
+
+  private:
+    uint32_t step;
+    uint32_t stepRemainder;
+    uint32_t rate;
+    uint32_t remainder;
+    uint32_t phase;
+    int16_t previous;
+    int16_t current;
+};
+
+#endif // _AUDIO_CODECS_H_
@@ -34,6 +34,8 @@
 
 #include "tasks.h"
 #include "tasks/mixer_task.h"
+#include "mixer_scheduler.h"
+#include "mixer_stats.h"
 
 #include "cli.h"
 
@@ -1369,11 +1371,21 @@ int cliDisplay(const char ** argv)
     printAudioVars();
   }
 #endif
+#if defined(AUDIO_PROMPTS_CACHE)
+  else if (!strcmp(argv[1], "ac")) {
+    const AudioPromptsCacheStats & stats = audioPromptsCache.getStats();
+    uint32_t hitRate = audioPromptsCache.getHitRate();
+    cliSerialPrint("Audio prompts cache stats: r: %u, h: %u(%0.1f%%), m: %u", (stats.noHits + stats.noMisses), stats.noHits, hitRate*0.1f, stats.noMisses);
+  }
+#endif
 #if defined(DISK_CACHE)
   else if (!strcmp(argv[1], "dc")) {
     DiskCacheStats stats = diskCache.getStats();
     uint32_t hitRate = diskCache.getHitRate();
     cliSerialPrint("Disk Cache stats: w:%u r: %u, h: %u(%0.1f%%), m: %u", stats.noWrites, (stats.noHits + stats.noMisses), stats.noHits, hitRate*0.1f, stats.noMisses);
+#if defined(DISK_CACHE_WRITEBACK)
+    cliSerialPrint("Disk Cache write-back: dirty: %u, flushes: %u (%u writes)", stats.noDirty, stats.noFlushes, stats.noFlushWrites);
+#endif
   }
 #endif
   else if (toLongLongInt(argv, 1, &address) > 0) {
@@ -1449,6 +1461,29 @@ int cliShowJitter(const char ** argv)
 }
 #endif
 
+int cliLatency(const char ** argv)
+{
+  if (!strcmp(argv[1], "reset")) {
+    mixerLatencyReset();
+    return 0;
+  }
+
+  cliSerialPrint("Mixer period %uus", (unsigned)getMixerSchedulerPeriod());
+  for (int i = 0; i < MIXER_LATENCY_COUNT; i++) {
+    const LatencyHistogram & histogram = mixerLatency[i];
+    cliSerialPrint("%s: n=%u min=%uus max=%uus last=%uus 50%%<%uus 99%%<%uus",
+                   mixerLatencyNames[i], (unsigned)histogram.getCount(),
+                   histogram.getMin(), histogram.getMax(), histogram.getLast(),
+                   (unsigned)histogram.getPercentile(50), (unsigned)histogram.getPercentile(99));
+    for (int j = 0; j < LATENCY_HISTOGRAM_BUCKETS; j++) {
+      if (histogram.getBucket(j)) {
+        cliSerialPrint("  <%6uus %u", (unsigned)LatencyHistogram::getBucketLimit(j), (unsigned)histogram.getBucket(j));
+      }
+    }
+  }
+  return 0;
+}
+
 #if defined(INTERNAL_GPS)
 int cliGps(const char ** argv)
 {
@@ -1625,6 +1660,7 @@ const CliCommand cliCommands[] = {
   { "repeat", cliRepeat, "<interval> <command>" },
 #endif
   { "help", cliHelp, "[<command>]" },
+  { "latency", cliLatency, "[reset]" },
 #if defined(JITTER_MEASURE)
   { "jitter", cliShowJitter, "" },
 #endif
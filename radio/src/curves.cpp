@@ -77,6 +77,10 @@ void loadCurves()
   if (showWarning) {
     POPUP_WARNING("Invalid curve data repaired", "check your curves, logic switches");
   }
+
+#if defined(CURVES_LUT)
+  curvesLutInvalidate();
+#endif
 }
 
 int8_t * curveAddress(uint8_t idx)
@@ -228,6 +232,38 @@ int32_t compute_tangent(CurveHeader* crv, const int8_t* points, int i)
   return m;
 }
 
+#if defined(CURVES_LUT)
+// Tangents of the smooth curves, computed on first use instead of twice per
+// hermite_spline() call. They are computed again after curvesLutInvalidate(),
+// called when the model is loaded and by storageDirty(EE_MODEL): every curve
+// edit (menus, Lua, moveCurve()) marks the model dirty.
+static int32_t curveTangents[MAX_CURVES][MAX_POINTS_PER_CURVE];
+static bool curveTangentsValid[MAX_CURVES];
+
+void curvesLutInvalidate()
+{
+  memclear(curveTangentsValid, sizeof(curveTangentsValid));
+}
+
+static const int32_t * getCurveTangents(uint8_t idx)
+{
+  int32_t * tangents = curveTangents[idx];
+
+  if (!curveTangentsValid[idx]) {
+    // set first: an edit while computing invalidates the result again
+    curveTangentsValid[idx] = true;
+    CurveHeader & crv = g_model.curves[idx];
+    int8_t * points = curveAddress(idx);
+    uint8_t count = STD_CURVE_POINTS(crv.points);
+    for (uint8_t i = 0; i < count; i++) {
+      tangents[i] = compute_tangent(&crv, points, i);
+    }
+  }
+
+  return tangents;
+}
+#endif
+
 /* The following is a hermite cubic spline.
    The basis functions can be found here:
    http://en.wikipedia.org/wiki/Cubic_Hermite_spline
@@ -239,6 +275,9 @@ int16_t hermite_spline(int16_t x, uint8_t idx)
   int8_t *points = curveAddress(idx);
   uint8_t count = STD_CURVE_POINTS(crv.points);
   bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+#if defined(CURVES_LUT)
+  const int32_t * tangents = getCurveTangents(idx);
+#endif
 
   if (x < -RESX)
     x = -RESX;
@@ -259,8 +298,13 @@ int16_t hermite_spline(int16_t x, uint8_t idx)
     if (x >= p0x && x <= p3x) {
       int32_t p0y = calc100toRESX(points[i]);
       int32_t p3y = calc100toRESX(points[i+1]);
+#if defined(CURVES_LUT)
+      int32_t m0 = tangents[i];
+      int32_t m3 = tangents[i+1];
+#else
       int32_t m0 = compute_tangent(&crv, points, i);
       int32_t m3 = compute_tangent(&crv, points, i+1);
+#endif
       int32_t y;
       int32_t h = p3x - p0x;
       int32_t t = (h > 0 ? (MMULT * (x - p0x)) / h : 0);
@@ -37,6 +37,11 @@ void curveClear(uint8_t index);
 void curveMirror(uint8_t index);
 bool isCurveUsed(uint8_t index);
 void loadCurves();
+#if defined(CURVES_LUT)
+void curvesLutInvalidate();
+#endif
+int16_t hermite_spline(int16_t x, uint8_t idx);
+int32_t compute_tangent(CurveHeader* crv, const int8_t* points, int i);
 int8_t * curveAddress(uint8_t idx);
 bool moveCurve(uint8_t index, int8_t shift);
 int8_t getCurveX(int noPoints, int point);
@@ -25,6 +25,7 @@
 
 #if defined(SIMU)
 traceCallbackFunc traceCallback = 0;
+bool traceStdout = true;
 #endif
 
 #if defined(SIMU)
@@ -37,8 +38,10 @@ void debugPrintf(const char * format, ...)
   va_start(arglist, format);
   vsnprintf(tmp, PRINTF_BUFFER_SIZE, format, arglist);
   va_end(arglist);
-  fputs(tmp, stdout);
-  fflush(stdout);
+  if (traceStdout) {
+    fputs(tmp, stdout);
+    fflush(stdout);
+  }
   if (traceCallback) {
     traceCallback(tmp);
   }
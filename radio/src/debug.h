@@ -36,6 +36,8 @@ EXTERN_C(extern volatile uint32_t g_tmr10ms);
 #if defined(SIMU)
   typedef void (*traceCallbackFunc)(const char * text);
   extern traceCallbackFunc traceCallback;
+  // traces are printed to stdout unless cleared, e.g. when it holds data
+  extern bool traceStdout;
   EXTERN_C(void debugPrintf(const char * format, ...));
 #elif defined(SEMIHOSTING)
   #include <stdio.h>
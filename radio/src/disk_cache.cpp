@@ -85,24 +85,42 @@ bool DiskCacheBlock::empty() const
 DiskCache::DiskCache():
   lastBlock(0)
 {
-  stats.noHits = 0;
-  stats.noMisses = 0;
-  stats.noWrites = 0;
+  memset(&stats, 0, sizeof(stats));
   blocks = new DiskCacheBlock[DISK_CACHE_BLOCKS_NUM];
+#if defined(DISK_CACHE_WRITEBACK)
+  dirtyData = new uint8_t[DISK_CACHE_DIRTY_SECTORS * BLOCK_SIZE];
+  dirtyCount = 0;
+#endif
 }
 
+// Pending writes are dropped: only to be used when the card has changed,
+// otherwise flush() first
 void DiskCache::clear()
 {
   lastBlock = 0;
-  stats.noHits = 0;
-  stats.noMisses = 0;
-  stats.noWrites = 0;
+  memset(&stats, 0, sizeof(stats));
   for (int n=0; n<DISK_CACHE_BLOCKS_NUM; ++n) {
     blocks[n].free();
   }
+#if defined(DISK_CACHE_WRITEBACK)
+  dirtyCount = 0;
+#endif
 }
 
 DRESULT DiskCache::read(BYTE drv, BYTE * buff, DWORD sector, UINT count)
+{
+  DRESULT res = readBlocks(drv, buff, sector, count);
+#if defined(DISK_CACHE_WRITEBACK)
+  // sectors waiting in the write-back buffer are newer than the disk and
+  // the read cache blocks
+  if (res == RES_OK && dirtyCount > 0) {
+    readDirty(buff, sector, count);
+  }
+#endif
+  return res;
+}
+
+DRESULT DiskCache::readBlocks(BYTE drv, BYTE * buff, DWORD sector, UINT count)
 {
   // TODO: check if not caching first sectors would improve anything
   // if (sector < 1000) {
@@ -154,9 +172,109 @@ DRESULT DiskCache::write(BYTE drv, const BYTE* buff, DWORD sector, UINT count)
   for(int n=0; n < DISK_CACHE_BLOCKS_NUM; ++n) {
     blocks[n].free(sector, count);
   }
+#if defined(DISK_CACHE_WRITEBACK)
+  if (count <= DISK_CACHE_DIRTY_SECTORS) {
+    return writeBack(drv, buff, sector, count);
+  }
+  // big writes go straight to the disk, after the older pending ones
+  DRESULT res = flush(drv);
+  if (res != RES_OK) {
+    return res;
+  }
+#endif
   return __disk_write(drv, buff, sector, count);  
 }
 
+#if defined(DISK_CACHE_WRITEBACK)
+DRESULT DiskCache::writeBack(BYTE drv, const BYTE* buff, DWORD sector, UINT count)
+{
+  for (UINT i=0; i<count; ++i, ++sector, buff += BLOCK_SIZE) {
+    // a sector written again before the flush (FAT, directory) is only
+    // updated in the buffer
+    uint8_t slot = 0;
+    while (slot < dirtyCount && dirtySectors[slot] != sector) {
+      ++slot;
+    }
+    if (slot == dirtyCount) {
+      if (dirtyCount == DISK_CACHE_DIRTY_SECTORS) {
+        DRESULT res = flush(drv);
+        if (res != RES_OK) {
+          return res;
+        }
+        slot = 0;
+      }
+      TRACE_DISK_CACHE("\tdirty sector %u in slot %u", (uint32_t)sector, slot);
+      dirtySectors[slot] = sector;
+      dirtyCount = slot + 1;
+      ++stats.noDirty;
+    }
+    memcpy(dirtyData + slot * BLOCK_SIZE, buff, BLOCK_SIZE);
+  }
+  return RES_OK;
+}
+
+void DiskCache::readDirty(BYTE* buff, DWORD sector, UINT count) const
+{
+  for (uint8_t slot=0; slot<dirtyCount; ++slot) {
+    DWORD offset = dirtySectors[slot] - sector;
+    if (offset < count) {
+      memcpy(buff + offset * BLOCK_SIZE, dirtyData + slot * BLOCK_SIZE, BLOCK_SIZE);
+    }
+  }
+}
+#endif
+
+DRESULT DiskCache::flush(BYTE drv)
+{
+#if defined(DISK_CACHE_WRITEBACK)
+  if (dirtyCount == 0) {
+    return RES_OK;
+  }
+
+  ++stats.noFlushes;
+
+  // write the sectors in ascending order
+  uint8_t order[DISK_CACHE_DIRTY_SECTORS];
+  for (uint8_t i=0; i<dirtyCount; ++i) {
+    uint8_t slot = i;
+    uint8_t j = i;
+    while (j > 0 && dirtySectors[order[j-1]] > dirtySectors[slot]) {
+      order[j] = order[j-1];
+      --j;
+    }
+    order[j] = slot;
+  }
+
+  DRESULT res = RES_OK;
+  for (uint8_t i=0; i<dirtyCount; ) {
+    // adjacent sectors held in adjacent slots (sequential file writes) go
+    // out as a single multi-block write
+    uint8_t first = order[i];
+    uint8_t n = 1;
+    while (i + n < dirtyCount && order[i + n] == first + n &&
+           dirtySectors[first + n] == dirtySectors[first] + n) {
+      ++n;
+    }
+    TRACE_DISK_CACHE("\tflush(%u, %u)", (uint32_t)dirtySectors[first], n);
+    ++stats.noFlushWrites;
+    DRESULT result = __disk_write(drv, dirtyData + first * BLOCK_SIZE, dirtySectors[first], n);
+    if (result != RES_OK) {
+      res = result;
+    }
+    // read blocks filled while the sectors were pending are stale now
+    for (int b=0; b<DISK_CACHE_BLOCKS_NUM; ++b) {
+      blocks[b].free(dirtySectors[first], n);
+    }
+    i += n;
+  }
+
+  dirtyCount = 0;
+  return res;
+#else
+  return RES_OK;
+#endif
+}
+
 const DiskCacheStats & DiskCache::getStats() const 
 { 
   return stats; 
@@ -28,6 +28,7 @@
 // tunable parameters
 #define DISK_CACHE_BLOCKS_NUM      32   // no cache blocks
 #define DISK_CACHE_BLOCK_SECTORS   16   // no sectors
+#define DISK_CACHE_DIRTY_SECTORS   32   // no sectors held back by the write-back mode
 
 #define DISK_CACHE_BLOCK_SIZE   (DISK_CACHE_BLOCK_SECTORS * BLOCK_SIZE)
 
@@ -52,6 +53,9 @@ struct DiskCacheStats
   uint32_t noHits;
   uint32_t noMisses;
   uint32_t noWrites;
+  uint32_t noDirty;         // sectors entering the write-back buffer
+  uint32_t noFlushes;       // write-back buffer flushes
+  uint32_t noFlushWrites;   // disk writes issued by the flushes
 };
 
 class DiskCache
@@ -60,14 +64,26 @@ class DiskCache
     DiskCache();
     DRESULT read(BYTE drv, BYTE* buff, DWORD sector, UINT count);
     DRESULT write(BYTE drv, const BYTE* buff, DWORD sector, UINT count);
+    DRESULT flush(BYTE drv);
     const DiskCacheStats & getStats() const;
     int getHitRate() const;
     void clear();
 
   private:
+    DRESULT readBlocks(BYTE drv, BYTE* buff, DWORD sector, UINT count);
+#if defined(DISK_CACHE_WRITEBACK)
+    DRESULT writeBack(BYTE drv, const BYTE* buff, DWORD sector, UINT count);
+    void readDirty(BYTE* buff, DWORD sector, UINT count) const;
+#endif
+
     DiskCacheStats stats;
     uint32_t lastBlock;
     DiskCacheBlock * blocks;
+#if defined(DISK_CACHE_WRITEBACK)
+    uint8_t * dirtyData;
+    DWORD dirtySectors[DISK_CACHE_DIRTY_SECTORS];
+    uint8_t dirtyCount;
+#endif
 };
 
 extern DiskCache diskCache;
@@ -213,6 +213,7 @@ void evalFunctions(const CustomFunctionData * functions, CustomFunctionsContext
               uint8_t item = CFN_PARAM(cfn) - FUNC_RESET_PARAM_FIRST_TELEM;
               if (item < MAX_TELEMETRY_SENSORS) {
                 telemetryItems[item].clear();
+                telemetryItemChanged(item);
               }
             }
             break;
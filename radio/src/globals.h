@@ -86,6 +86,17 @@ extern int32_t chans[MAX_OUTPUT_CHANNELS];
 extern int16_t ex_chans[MAX_OUTPUT_CHANNELS]; // Outputs (before LIMITS) of the last perMain
 extern int16_t channelOutputs[MAX_OUTPUT_CHANNELS];
 
+// Channels published by the mixer at the end of each cycle, for the
+// readers running in other tasks (UI, logs)
+struct ChannelsSnapshot {
+  int16_t outputs[MAX_OUTPUT_CHANNELS]; // channelOutputs
+  int16_t mixes[MAX_OUTPUT_CHANNELS];   // ex_chans
+};
+
+// copies the last complete set of channels without locking the mixer,
+// returns its sequence number
+uint32_t getChannelsSnapshot(ChannelsSnapshot & snapshot);
+
 typedef uint16_t BeepANACenter;
 extern BeepANACenter bpanaCenter;
 
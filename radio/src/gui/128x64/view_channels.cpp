@@ -78,11 +78,15 @@ void menuChannelsViewCommon(event_t event)
 
   int16_t limits = 512 * 2;
 
+  // all the channels from the same mixer cycle
+  ChannelsSnapshot channels;
+  getChannelsSnapshot(channels);
+
   // Channels
   for (uint8_t line = 0; line < 8; line++) {
     LimitData * ld = limitAddress(ch);
     const uint8_t y = 9 + line * 7;
-    const int32_t val = reusableBuffer.viewChannels.mixersView ? ex_chans[ch] : channelOutputs[ch];
+    const int32_t val = reusableBuffer.viewChannels.mixersView ? channels.mixes[ch] : channels.outputs[ch];
     const uint8_t lenLabel = ZLEN(g_model.limitData[ch].name);
 
     // Channel name if present, number if not
@@ -21,6 +21,7 @@
 
 #include "opentx.h"
 #include "tasks.h"
+#include "mixer_stats.h"
 
 #if defined(BLUETOOTH)
   #include "bluetooth_driver.h"
@@ -137,6 +138,7 @@ void menuStatisticsDebug(event_t event)
       maxLuaDuration = 0;
 #endif
       maxMixerDuration  = 0;
+      mixerLatencyReset();
       break;
 
     case EVT_KEY_FIRST(KEY_UP):
@@ -207,6 +209,12 @@ void menuStatisticsDebug(event_t event)
   lcdDrawText(lcdLastRightPos, y, STR_MS);
   y += FH;
 
+  lcdDrawTextAlignedLeft(y, "Jitter us");
+  lcdDrawNumber(MENU_DEBUG_COL1_OFS, y, mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getPercentile(99), LEFT);
+  lcdDrawText(lcdLastRightPos, y, "/");
+  lcdDrawNumber(lcdLastRightPos, y, mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getMax(), LEFT);
+  y += FH;
+
   lcdDrawTextAlignedLeft(y, STR_FREE_STACK);
   lcdDrawNumber(MENU_DEBUG_COL1_OFS, y, menusStack.available(), LEFT);
   lcdDrawText(lcdLastRightPos, y, "/");
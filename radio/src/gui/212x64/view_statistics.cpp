@@ -21,6 +21,7 @@
 
 #include "opentx.h"
 #include "tasks.h"
+#include "mixer_stats.h"
 
 #define STATS_1ST_COLUMN               FW/2
 #define STATS_2ND_COLUMN               12*FW+FW/2
@@ -131,6 +132,7 @@ void menuStatisticsDebug(event_t event)
       maxLuaDuration = 0;
 #endif
       maxMixerDuration  = 0;
+      mixerLatencyReset();
       break;
 
     case EVT_KEY_FIRST(KEY_UP):
@@ -185,6 +187,14 @@ void menuStatisticsDebug(event_t event)
   lcdDrawText(lcdLastRightPos, y, STR_MS);
   y += FH;
 
+  lcdDrawTextAlignedLeft(y, "Mix jitter");
+  lcdDrawText(MENU_DEBUG_COL1_OFS, y+1, "[99%]", SMLSIZE);
+  lcdDrawNumber(lcdLastRightPos, y, mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getPercentile(99), LEFT);
+  lcdDrawText(lcdLastRightPos+2, y+1, "[max]", SMLSIZE);
+  lcdDrawNumber(lcdLastRightPos, y, mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getMax(), LEFT);
+  lcdDrawText(lcdLastRightPos, y, "us");
+  y += FH;
+
   lcdDrawTextAlignedLeft(y, STR_FREE_STACK);
   lcdDrawText(MENU_DEBUG_COL1_OFS, y+1, "[M]", SMLSIZE);
   lcdDrawNumber(lcdLastRightPos, y, menusStack.available(), LEFT);
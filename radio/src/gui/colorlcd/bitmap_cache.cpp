@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "opentx.h"
+#include "bitmap_cache.h"
+
+void bitmapCacheGetFilename(const char * filename, coord_t width,
+                            coord_t height, char * cacheFilename)
+{
+  // two different polynomials give a 32 bits hash of the path and size
+  const uint16_t size[2] = { (uint16_t)width, (uint16_t)height };
+  uint32_t len = strlen(filename);
+  uint16_t high = crc16(CRC_1021, (const uint8_t *)filename, len);
+  high = crc16(CRC_1021, (const uint8_t *)size, sizeof(size), high);
+  uint16_t low = crc16(CRC_1189, (const uint8_t *)filename, len);
+  low = crc16(CRC_1189, (const uint8_t *)size, sizeof(size), low);
+
+  char * s = strAppend(cacheFilename, BITMAPS_CACHE_PATH PATH_SEPARATOR);
+  s = strAppendUnsigned(s, high, 4, 16);
+  s = strAppendUnsigned(s, low, 4, 16);
+  strAppend(s, ".bin");
+}
+
+static bool bitmapCacheReadPath(FIL * file, const char * filename,
+                                uint16_t pathLength)
+{
+  if (pathLength != strlen(filename))
+    return false;
+
+  // compared by chunks, to keep the stack usage low
+  char buffer[64];
+  while (pathLength > 0) {
+    UINT size = min<UINT>(pathLength, sizeof(buffer));
+    UINT read;
+    if (f_read(file, buffer, size, &read) != FR_OK || read != size ||
+        memcmp(buffer, filename, size))
+      return false;
+    filename += size;
+    pathLength -= size;
+  }
+  return true;
+}
+
+static BitmapBuffer * bitmapCacheRead(const char * cacheFilename,
+                                      const char * filename,
+                                      const FILINFO & source)
+{
+  FIL file;
+  if (f_open(&file, cacheFilename, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    return nullptr;
+
+  BitmapCacheHeader header;
+  UINT read;
+  BitmapBuffer * bitmap = nullptr;
+
+  if (f_read(&file, &header, sizeof(header), &read) == FR_OK &&
+      read == sizeof(header) &&
+      !memcmp(header.magic, BITMAP_CACHE_MAGIC, sizeof(header.magic)) &&
+      header.version == BITMAP_CACHE_VERSION &&
+      header.sourceSize == source.fsize &&
+      header.sourceDate == ((uint32_t)source.fdate << 16 | source.ftime) &&
+      f_size(&file) == sizeof(header) + header.pathLength + header.width * header.height * sizeof(pixel_t) &&
+      bitmapCacheReadPath(&file, filename, header.pathLength)) {
+    bitmap = new BitmapBuffer(header.format, header.width, header.height);
+    if (bitmap && bitmap->getData()) {
+      // one sequential read straight into the pixels
+      UINT size = header.width * header.height * sizeof(pixel_t);
+      if (f_read(&file, bitmap->getData(), size, &read) != FR_OK || read != size) {
+        delete bitmap;
+        bitmap = nullptr;
+      }
+    }
+  }
+
+  f_close(&file);
+  return bitmap;
+}
+
+// Deletes the oldest cache files until 'needed' more bytes fit in
+// BITMAP_CACHE_MAX_SIZE. Cache files are only written on a miss, after a
+// much longer decoding, so the directory is simply scanned each time.
+static void bitmapCacheEvict(uint32_t needed)
+{
+  while (true) {
+    DIR dir;
+    if (f_opendir(&dir, BITMAPS_CACHE_PATH) != FR_OK)
+      return;
+
+    FILINFO fno;
+    uint32_t total = 0;
+    uint32_t oldestDate = UINT32_MAX;
+    char oldest[FF_MAX_LFN + 1] = "";
+
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != '\0') {
+      if (fno.fattrib & AM_DIR)
+        continue;
+      total += fno.fsize;
+      uint32_t date = (uint32_t)fno.fdate << 16 | fno.ftime;
+      if (date <= oldestDate) {
+        oldestDate = date;
+        strcpy(oldest, fno.fname);
+      }
+    }
+    f_closedir(&dir);
+
+    if (total + needed <= BITMAP_CACHE_MAX_SIZE || oldest[0] == '\0')
+      return;
+
+    char path[sizeof(BITMAPS_CACHE_PATH) + FF_MAX_LFN + 1];
+    strAppend(strAppend(path, BITMAPS_CACHE_PATH PATH_SEPARATOR), oldest);
+    if (f_unlink(path) != FR_OK)
+      return;
+  }
+}
+
+static void bitmapCacheWrite(const char * cacheFilename,
+                             const char * filename,
+                             const FILINFO & source,
+                             const BitmapBuffer * bitmap)
+{
+  UINT pathLength = strlen(filename);
+  UINT size = bitmap->width() * bitmap->height() * sizeof(pixel_t);
+  if (sizeof(BitmapCacheHeader) + pathLength + size > BITMAP_CACHE_MAX_SIZE)
+    return;
+
+  if (sdCheckAndCreateDirectory(BITMAPS_CACHE_PATH) != nullptr)
+    return;
+
+  // an older version of the same bitmap is replaced
+  f_unlink(cacheFilename);
+  bitmapCacheEvict(sizeof(BitmapCacheHeader) + pathLength + size);
+
+  FIL file;
+  if (f_open(&file, cacheFilename, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return;
+
+  BitmapCacheHeader header;
+  memcpy(header.magic, BITMAP_CACHE_MAGIC, sizeof(header.magic));
+  header.version = BITMAP_CACHE_VERSION;
+  header.format = bitmap->getFormat();
+  header.width = bitmap->width();
+  header.height = bitmap->height();
+  header.pathLength = pathLength;
+  header.sourceSize = source.fsize;
+  header.sourceDate = (uint32_t)source.fdate << 16 | source.ftime;
+
+  UINT written;
+  bool ok = f_write(&file, &header, sizeof(header), &written) == FR_OK && written == sizeof(header) &&
+            f_write(&file, filename, pathLength, &written) == FR_OK && written == pathLength &&
+            f_write(&file, bitmap->getData(), size, &written) == FR_OK && written == size;
+  f_close(&file);
+
+  if (!ok) {
+    // most probably the card is full, do not leave a partial file
+    f_unlink(cacheFilename);
+  }
+}
+
+static BitmapBuffer * scaleBitmap(BitmapBuffer * bitmap, coord_t width,
+                                  coord_t height)
+{
+  float vscale = float(height) / bitmap->height();
+  float hscale = float(width) / bitmap->width();
+  float scale = vscale < hscale ? vscale : hscale;
+  if (scale >= 1.0f)
+    return bitmap;
+
+  coord_t w = bitmap->width() * scale;
+  coord_t h = bitmap->height() * scale;
+  if (w <= 0 || h <= 0)
+    return bitmap;
+
+  BitmapBuffer * scaled = new BitmapBuffer(bitmap->getFormat(), w, h);
+  if (scaled && scaled->getData()) {
+    scaled->clear();
+    scaled->drawBitmap(0, 0, bitmap, 0, 0, 0, 0, scale);
+    delete bitmap;
+    return scaled;
+  }
+
+  delete scaled;
+  return bitmap;
+}
+
+BitmapBuffer * loadCachedBitmap(const char * filename, coord_t width,
+                                coord_t height)
+{
+  FILINFO source;
+  if (f_stat(filename, &source) != FR_OK)
+    return nullptr;
+
+  char cacheFilename[BITMAP_CACHE_FILENAME_LEN];
+  bitmapCacheGetFilename(filename, width, height, cacheFilename);
+
+  BitmapBuffer * bitmap = bitmapCacheRead(cacheFilename, filename, source);
+  if (bitmap)
+    return bitmap;
+
+  bitmap = BitmapBuffer::loadBitmap(filename);
+  if (!bitmap)
+    return nullptr;
+
+  if (width > 0 && height > 0)
+    bitmap = scaleBitmap(bitmap, width, height);
+
+  bitmapCacheWrite(cacheFilename, filename, source, bitmap);
+  return bitmap;
+}
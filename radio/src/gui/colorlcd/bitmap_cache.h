@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "definitions.h"
+#include "sdcard.h"
+#include "bitmapbuffer.h"
+
+// Decoded bitmaps are stored in BITMAPS_CACHE_PATH, one file per source path
+// and target size, holding the raw RGB565 / ARGB4444 pixels behind a small
+// header and the source path. The source size and date are part of the
+// header, so a modified picture is decoded again and its cache file
+// rewritten. The path is compared too, as file names are only a hash of it.
+//
+// The oldest files are deleted when the cache grows over
+// BITMAP_CACHE_MAX_SIZE.
+
+#define BITMAPS_CACHE_PATH      BITMAPS_PATH PATH_SEPARATOR "CACHE"
+#define BITMAP_CACHE_MAGIC      "EBMC"
+#define BITMAP_CACHE_VERSION    2
+
+#if !defined(BITMAP_CACHE_MAX_SIZE)
+  #define BITMAP_CACHE_MAX_SIZE (8 * 1024 * 1024)
+#endif
+
+// BITMAPS_CACHE_PATH "/XXXXXXXX.bin"
+#define BITMAP_CACHE_FILENAME_LEN  (sizeof(BITMAPS_CACHE_PATH) + 13)
+
+PACK(struct BitmapCacheHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t format;
+  uint16_t width;
+  uint16_t height;
+  uint16_t pathLength;  // source path, stored after the header
+  uint32_t sourceSize;
+  uint32_t sourceDate;  // FatFs date << 16 | time
+});
+
+// Loads a bitmap through the cache. With a non zero width and height, the
+// bitmap is scaled down to fit them (keeping its aspect ratio, as done by
+// drawScaledBitmap()) before being cached, so that it can then be drawn
+// with a plain drawBitmap().
+BitmapBuffer * loadCachedBitmap(const char * filename, coord_t width = 0,
+                                coord_t height = 0);
+
+// Full path of the cache file for a source path and target size
+void bitmapCacheGetFilename(const char * filename, coord_t width,
+                            coord_t height, char * cacheFilename);
@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "opentx.h"
+#include "frame_profiler.h"
+#include "window.h"
+#include "widgets/window_base.h"
+
+#if defined(UI_FRAME_PROFILER) && !defined(BOOT)
+
+#define FRAME_PROFILER_PERIOD_MS   1000
+#define FRAME_PROFILER_CLASSES     8
+#define FRAME_PROFILER_TOP         3
+
+struct FrameProfilerClass {
+  const lv_obj_class_t * cls;
+  const char * name;
+};
+
+// the classes an invalidated area is reported with, LVGL classes
+// have no name: objects of other classes are reported with their
+// nearest known base class
+static const FrameProfilerClass knownClasses[] = {
+  { &window_base_class, "window" },
+#if LV_USE_LABEL
+  { &lv_label_class, "label" },
+#endif
+#if LV_USE_BTN
+  { &lv_btn_class, "btn" },
+#endif
+#if LV_USE_IMG
+  { &lv_img_class, "img" },
+#endif
+#if LV_USE_CANVAS
+  { &lv_canvas_class, "canvas" },
+#endif
+#if LV_USE_LINE
+  { &lv_line_class, "line" },
+#endif
+#if LV_USE_BAR
+  { &lv_bar_class, "bar" },
+#endif
+#if LV_USE_SLIDER
+  { &lv_slider_class, "slider" },
+#endif
+#if LV_USE_SWITCH
+  { &lv_switch_class, "switch" },
+#endif
+#if LV_USE_CHECKBOX
+  { &lv_checkbox_class, "checkbox" },
+#endif
+#if LV_USE_TEXTAREA
+  { &lv_textarea_class, "textarea" },
+#endif
+#if LV_USE_TABLE
+  { &lv_table_class, "table" },
+#endif
+#if LV_USE_BTNMATRIX
+  { &lv_btnmatrix_class, "btnmatrix" },
+#endif
+#if LV_USE_ROLLER
+  { &lv_roller_class, "roller" },
+#endif
+#if LV_USE_KEYBOARD
+  { &lv_keyboard_class, "keyboard" },
+#endif
+  { &lv_obj_class, "obj" },
+};
+
+struct FrameProfilerStats {
+  uint32_t frames;
+  uint32_t overBudget;
+  uint32_t fullScreen;
+  uint32_t areas;
+  uint32_t maxAreas;
+  uint32_t pixels;
+  uint32_t maxPixels;
+  uint32_t flushedAreas;
+  uint32_t flushedPixels;
+  uint32_t renderUs;
+  uint32_t maxRenderUs;
+  uint32_t flushUs;
+  uint32_t maxFlushUs;
+  // invalidated pixels / areas per reported class
+  uint32_t classPixels[DIM(knownClasses)];
+  uint16_t classAreas[DIM(knownClasses)];
+  // largest invalidated area
+  lv_area_t worstArea;
+  uint32_t worstPixels;
+  const char * worstClass;
+#if defined(DEBUG_WINDOWS)
+  std::string worstWindow;
+#endif
+};
+
+static FrameProfilerStats stats;
+static uint32_t periodStart = 0;
+
+// current frame, counted on its first flush
+static bool frameCounted = false;
+static uint32_t frameAreas = 0;
+static uint32_t framePixels = 0;
+static uint32_t flushStart = 0;
+static uint32_t flushTicks = 0;
+
+static lv_timer_cb_t refrTimerCb = nullptr;
+
+static inline uint32_t profilerTicks()
+{
+#if defined(SIMU)
+  return (uint32_t)simuTimerMicros();
+#else
+  return ticksNow();
+#endif
+}
+
+static inline uint32_t profilerTicksToUs(uint32_t ticks)
+{
+#if defined(SIMU)
+  return ticks;
+#else
+  return ticks / SYSTEM_TICKS_1US;
+#endif
+}
+
+static uint8_t getClassIndex(const lv_obj_t * obj)
+{
+  for (auto cls = lv_obj_get_class(obj); cls; cls = cls->base_class) {
+    for (uint8_t i = 0; i < DIM(knownClasses); i++) {
+      if (knownClasses[i].cls == cls) return i;
+    }
+  }
+  return DIM(knownClasses) - 1;
+}
+
+// smallest visible object covering the area: objects are clipped by
+// their parent like LVGL does when invalidating them
+static lv_obj_t * findObject(lv_obj_t * obj, const lv_area_t * clip,
+                             const lv_area_t * area)
+{
+  if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) return nullptr;
+
+  lv_area_t objArea;
+  lv_obj_get_coords(obj, &objArea);
+  lv_coord_t ext = _lv_obj_get_ext_draw_size(obj);
+  lv_area_increase(&objArea, ext, ext);
+  if (!_lv_area_intersect(&objArea, &objArea, clip)) return nullptr;
+  if (!_lv_area_is_in(area, &objArea, 0)) return nullptr;
+
+  lv_area_t childClip;
+  lv_obj_get_coords(obj, &childClip);
+  if (lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) childClip = objArea;
+  if (_lv_area_intersect(&childClip, &childClip, clip)) {
+    // last children are drawn on top
+    for (int32_t i = lv_obj_get_child_cnt(obj) - 1; i >= 0; i--) {
+      auto found = findObject(lv_obj_get_child(obj, i), &childClip, area);
+      if (found) return found;
+    }
+  }
+
+  return obj;
+}
+
+static lv_obj_t * findInvalidatingObject(lv_disp_t * disp,
+                                         const lv_area_t * area)
+{
+  lv_area_t screen = {0, 0, (lv_coord_t)(lv_disp_get_hor_res(disp) - 1),
+                      (lv_coord_t)(lv_disp_get_ver_res(disp) - 1)};
+
+  // same order as the layers are drawn, top first
+  lv_obj_t * layers[] = {lv_disp_get_layer_sys(disp),
+                         lv_disp_get_layer_top(disp),
+                         lv_disp_get_scr_act(disp)};
+
+  for (auto layer : layers) {
+    if (!layer) continue;
+    auto obj = findObject(layer, &screen, area);
+    // layers cover the whole screen, skip them unless a child is found
+    if (obj && (obj != layer || layer == lv_disp_get_scr_act(disp)))
+      return obj;
+  }
+
+  return nullptr;
+}
+
+// called by LVGL for each invalidated area, after it has been clipped
+// to the screen: the area is left untouched. Only used to attribute the
+// area to a class, the areas may still be joined or dropped afterwards.
+static void profilerRounder(lv_disp_drv_t *, lv_area_t * area)
+{
+  auto disp = lv_disp_get_default();
+
+  uint32_t pixels = lv_area_get_size(area);
+  auto obj = findInvalidatingObject(disp, area);
+  uint8_t index = obj ? getClassIndex(obj) : DIM(knownClasses) - 1;
+  stats.classPixels[index] += pixels;
+  if (stats.classAreas[index] < UINT16_MAX) stats.classAreas[index] += 1;
+
+  if (pixels > stats.worstPixels) {
+    stats.worstPixels = pixels;
+    stats.worstArea = *area;
+    stats.worstClass = knownClasses[index].name;
+#if defined(DEBUG_WINDOWS)
+    stats.worstWindow.clear();
+    for (auto o = obj; o; o = lv_obj_get_parent(o)) {
+      if (lv_obj_get_class(o) == &window_base_class) {
+        auto window = (Window *)lv_obj_get_user_data(o);
+        if (window) stats.worstWindow = window->getName();
+        break;
+      }
+    }
+#endif
+  }
+}
+
+static void traceSummary(uint32_t elapsed)
+{
+  if (stats.frames > 0) {
+    TRACE("frames: %d in %dms, %d over budget, %d full screen", stats.frames,
+          elapsed, stats.overBudget, stats.fullScreen);
+    TRACE("  invalidated: avg %d areas / %dpx, max %d areas / %dpx",
+          stats.areas / stats.frames, stats.pixels / stats.frames,
+          stats.maxAreas, stats.maxPixels);
+    TRACE("  flushed: avg %d areas / %dpx", stats.flushedAreas / stats.frames,
+          stats.flushedPixels / stats.frames);
+    TRACE("  render: avg %dus max %dus, flush: avg %dus max %dus",
+          stats.renderUs / stats.frames, stats.maxRenderUs,
+          stats.flushUs / stats.frames, stats.maxFlushUs);
+
+    bool reported[DIM(knownClasses)] = {};
+    for (uint8_t n = 0; n < FRAME_PROFILER_TOP; n++) {
+      int8_t top = -1;
+      for (uint8_t i = 0; i < DIM(knownClasses); i++) {
+        if (!reported[i] && stats.classPixels[i] > 0 &&
+            (top < 0 || stats.classPixels[i] > stats.classPixels[top]))
+          top = i;
+      }
+      if (top < 0) break;
+      reported[top] = true;
+      TRACE("  #%d %s: %d areas / %dpx per frame", n + 1,
+            knownClasses[top].name, stats.classAreas[top] / stats.frames,
+            stats.classPixels[top] / stats.frames);
+    }
+
+    if (stats.worstPixels > 0) {
+      const lv_area_t& area = stats.worstArea;
+#if defined(DEBUG_WINDOWS)
+      TRACE("  largest area: {%d,%d,%d,%d} %s %s", area.x1, area.y1,
+            area.x2 - area.x1 + 1, area.y2 - area.y1 + 1, stats.worstClass,
+            stats.worstWindow.c_str());
+#else
+      TRACE("  largest area: {%d,%d,%d,%d} %s", area.x1, area.y1,
+            area.x2 - area.x1 + 1, area.y2 - area.y1 + 1, stats.worstClass);
+#endif
+    }
+  }
+
+  stats = FrameProfilerStats();
+}
+
+// wraps LVGL refresh timer: one call is one frame
+static void profilerRefrTimer(lv_timer_t * timer)
+{
+  frameCounted = false;
+  frameAreas = 0;
+  framePixels = 0;
+  flushTicks = 0;
+
+  uint32_t start = profilerTicks();
+  refrTimerCb(timer);
+  uint32_t refrTicks = profilerTicks() - start;
+
+  // nothing flushed: nothing rendered
+  if (frameCounted) {
+    uint32_t renderUs = profilerTicksToUs(refrTicks - flushTicks);
+    uint32_t flushUs = profilerTicksToUs(flushTicks);
+
+    stats.frames += 1;
+    stats.areas += frameAreas;
+    stats.maxAreas = max(stats.maxAreas, frameAreas);
+    stats.pixels += framePixels;
+    stats.maxPixels = max(stats.maxPixels, framePixels);
+    if (framePixels > FRAME_PROFILER_PIXELS_BUDGET) stats.overBudget += 1;
+    if (framePixels >= LCD_W * LCD_H) stats.fullScreen += 1;
+    stats.renderUs += renderUs;
+    stats.maxRenderUs = max(stats.maxRenderUs, renderUs);
+    stats.flushUs += flushUs;
+    stats.maxFlushUs = max(stats.maxFlushUs, flushUs);
+  }
+
+  uint32_t now = RTOS_GET_MS();
+  if (now - periodStart >= FRAME_PROFILER_PERIOD_MS) {
+    traceSummary(now - periodStart);
+    periodStart = now;
+  }
+}
+
+void frameProfilerInit(lv_disp_t * disp)
+{
+  disp->driver->rounder_cb = profilerRounder;
+
+  if (disp->refr_timer && !refrTimerCb) {
+    refrTimerCb = disp->refr_timer->timer_cb;
+    lv_timer_set_cb(disp->refr_timer, profilerRefrTimer);
+  }
+
+  periodStart = RTOS_GET_MS();
+}
+
+void frameProfilerFlushBegin()
+{
+  // the areas actually redrawn, once LVGL has joined them
+  lv_disp_t * disp = _lv_refr_get_disp_refreshing();
+  if (!frameCounted && disp) {
+    frameCounted = true;
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+      if (disp->inv_area_joined[i]) continue;
+      frameAreas += 1;
+      framePixels += lv_area_get_size(&disp->inv_areas[i]);
+    }
+  }
+
+  flushStart = profilerTicks();
+}
+
+void frameProfilerFlushEnd(uint32_t areas, uint32_t pixels)
+{
+  flushTicks += profilerTicks() - flushStart;
+  stats.flushedAreas += areas;
+  stats.flushedPixels += pixels;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct _lv_disp_t;
+typedef _lv_disp_t lv_disp_t;
+
+// Frame profiler (UI_FRAME_PROFILER builds, simulator included).
+//
+// Every LVGL refresh is recorded as a frame: the number of invalidated areas
+// and pixels (once joined by LVGL, as seen by the first flush), the render
+// time (refresh minus flush) and the flush time. Invalidated areas are also
+// attributed to the class of the smallest visible object covering them, as
+// LVGL does not tell who invalidated an area.
+//
+// A summary is traced once per second, with the classes that invalidated
+// the most pixels and the largest area seen.
+
+// frames invalidating more pixels are counted as over budget
+#define FRAME_PROFILER_PIXELS_BUDGET   (LCD_W * LCD_H / 4)
+
+#if defined(UI_FRAME_PROFILER) && !defined(BOOT)
+
+// hooks the display rounder callback and refresh timer
+void frameProfilerInit(lv_disp_t * disp);
+
+// called by the flush callback around the copy of the areas
+void frameProfilerFlushBegin();
+void frameProfilerFlushEnd(uint32_t areas, uint32_t pixels);
+
+#else
+
+inline void frameProfilerInit(lv_disp_t *) {}
+inline void frameProfilerFlushBegin() {}
+inline void frameProfilerFlushEnd(uint32_t, uint32_t) {}
+
+#endif
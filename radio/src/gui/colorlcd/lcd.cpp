@@ -20,6 +20,7 @@
  */
 
 #include "lcd.h"
+#include "frame_profiler.h"
 #include <lvgl/lvgl.h>
 
 pixel_t LCD_FIRST_FRAME_BUFFER[DISPLAY_BUFFER_SIZE] __SDRAM;
@@ -78,6 +79,30 @@ static void _copy_screen_area(uint16_t* dst, uint16_t* src, const lv_area_t& cop
 }
 #endif
 
+// Merge the areas when copying the merged area costs less than copying
+// them separately. LVGL only joins overlapping areas when the joined area
+// is smaller, leaving side by side areas (e.g. the cells of a row) as
+// separate copies.
+int lcdMergeAreas(lv_area_t* areas, int count)
+{
+  for (int i = 0; i < count; i++) {
+    for (int j = i + 1; j < count; j++) {
+      lv_area_t joined;
+      _lv_area_join(&joined, &areas[i], &areas[j]);
+      if (lv_area_get_size(&joined) >
+          lv_area_get_size(&areas[i]) + lv_area_get_size(&areas[j]))
+        continue;
+
+      areas[i] = joined;
+      areas[j] = areas[--count];
+      // the grown area may now be merged with any other one: start over
+      i = -1;
+      break;
+    }
+  }
+  return count;
+}
+
 static void flushLcd(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
 {
 #if !defined(LCD_VERTICAL_INVERT)
@@ -101,6 +126,7 @@ static void flushLcd(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_
   if (lcd_flush_cb) {
     refr_disp = disp_drv;
 
+    frameProfilerFlushBegin();
 
     rect_t copy_area = {area->x1, area->y1,
                         area->x2 - area->x1 + 1,
@@ -117,20 +143,32 @@ static void flushLcd(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_
       dst = LCD_FIRST_FRAME_BUFFER;
 
     lv_disp_t* disp = _lv_refr_get_disp_refreshing();
+
+    lv_area_t refr_areas[LV_INV_BUF_SIZE];
+    int count = 0;
     for(int i = 0; i < disp->inv_p; i++) {
       if(disp->inv_area_joined[i]) continue;
+      refr_areas[count++] = disp->inv_areas[i];
+    }
+    count = lcdMergeAreas(refr_areas, count);
 
-      const lv_area_t& refr_area = disp->inv_areas[i];
+    uint32_t pixels = 0;
+    for(int i = 0; i < count; i++) {
+      const lv_area_t& refr_area = refr_areas[i];
 
       auto area_w = refr_area.x2 - refr_area.x1 + 1;
       auto area_h = refr_area.y2 - refr_area.y1 + 1;
 
       DMACopyBitmap(dst, LCD_W, LCD_H, refr_area.x1, refr_area.y1,
                     src, LCD_W, LCD_H, refr_area.x1, refr_area.y1,
-                    area_w, area_h);      
+                    area_w, area_h);
+      pixels += area_w * area_h;
     }
-    
+
+    frameProfilerFlushEnd(count, pixels);
     lv_disp_flush_ready(disp_drv);
+#else
+    frameProfilerFlushEnd(1, copy_area.w * copy_area.h);
 #endif
   } else {
     lv_disp_flush_ready(disp_drv);
@@ -171,6 +209,7 @@ void lcdInitDisplayDriver()
 
   // Register the driver and save the created display object
   disp = lv_disp_drv_register(&disp_drv);
+  frameProfilerInit(disp);
 
   // remove all styles on default screen (makes it transparent as well)
   lv_obj_remove_style_all(lv_scr_act());
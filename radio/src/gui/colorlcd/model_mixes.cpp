@@ -82,6 +82,7 @@ void insertMix(uint8_t idx, uint8_t channel)
     }
   }
   mix->weight = 100;
+  mixerPlanInvalidate();
   mixerTaskStart();
   storageDirty(EE_MODEL);
 }
@@ -92,6 +93,7 @@ void deleteMix(uint8_t idx)
   MixData * mix = mixAddress(idx);
   memmove(mix, mix + 1, (MAX_MIXERS - (idx + 1)) * sizeof(MixData));
   memclear(&g_model.mixData[MAX_MIXERS - 1], sizeof(MixData));
+  mixerPlanInvalidate();
   mixerTaskStart();
   storageDirty(EE_MODEL);
 }
@@ -116,6 +118,7 @@ void copyMix(uint8_t source, uint8_t dest, int8_t ch)
   memmove(mix + 1, mix, trailingMixes * sizeof(MixData));
   memcpy(mix, &sourceMix, sizeof(MixData));
   mix->destCh = ch;
+  mixerPlanInvalidate();
   mixerTaskStart();
   storageDirty(EE_MODEL);
 }
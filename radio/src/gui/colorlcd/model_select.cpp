@@ -27,6 +27,7 @@
 
 #include "libopenui.h"
 #include "listbox.h"
+#include "bitmap_cache.h"
 #include "model_templates.h"
 #include "opentx.h"
 #include "standalone_lua.h"
@@ -276,7 +277,7 @@ class ModelButton : public Button
                        COLOR_THEME_SECONDARY1 | CENTERED);
     } else {
       GET_FILENAME(filename, BITMAPS_PATH, modelCell->modelBitmap, "");
-      const BitmapBuffer *bitmap = BitmapBuffer::loadBitmap(filename);
+      const BitmapBuffer *bitmap = loadCachedBitmap(filename, width(), height());
       if (bitmap) {
         buffer->drawScaledBitmap(bitmap, 0, 0, width(), height());
         delete bitmap;
@@ -23,6 +23,7 @@
 #include "tabsgroup.h"
 #include "bitmaps.h"
 #include "theme_manager.h"
+#include "bitmap_cache.h"
 
 #include <memory>
 using std::unique_ptr;
@@ -166,7 +167,7 @@ class Theme480: public OpenTxTheme
       if (backgroundBitmap != nullptr)
         delete backgroundBitmap;
       OpenTxTheme::setBackgroundImageFileName(fileName);  // set the filename
-      backgroundBitmap = BitmapBuffer::loadBitmap(backgroundImageFileName);
+      backgroundBitmap = loadCachedBitmap(backgroundImageFileName);
     }
 
     void load() const override
@@ -175,7 +176,7 @@ class Theme480: public OpenTxTheme
       ThemePersistance::instance()->loadDefaultTheme();
       OpenTxTheme::load();
       if (!backgroundBitmap) {
-        backgroundBitmap = BitmapBuffer::loadBitmap(getFilePath("background.png"));
+        backgroundBitmap = loadCachedBitmap(getFilePath("background.png"));
       }
       update();
     }
@@ -26,6 +26,7 @@
 
 #include "tasks.h"
 #include "tasks/mixer_task.h"
+#include "mixer_stats.h"
 
 static const lv_coord_t col_dsc[] = {LV_GRID_FR(1), LV_GRID_FR(1),
                                      LV_GRID_FR(1), LV_GRID_FR(1),
@@ -261,6 +262,25 @@ void DebugViewPage::build(FormWindow* window)
   line = form->newLine(&grid);
   line->padAll(2);
 
+  // Mixer period jitter (us)
+  new StaticText(line, rect_t{}, "Mixer jitter", 0, COLOR_THEME_PRIMARY1);
+#if LCD_H > LCD_W
+  line = form->newLine(&grid);
+  line->padAll(0);
+  line->padLeft(10);
+#endif
+  new DebugInfoNumber<uint32_t>(
+      line, rect_t{0, 0, DBG_B_WIDTH, DBG_B_HEIGHT},
+      [] { return mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getPercentile(99); },
+      COLOR_THEME_PRIMARY1, "99% us ", nullptr);
+  new DebugInfoNumber<uint32_t>(
+      line, rect_t{0, 0, DBG_B_WIDTH, DBG_B_HEIGHT},
+      [] { return mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getMax(); },
+      COLOR_THEME_PRIMARY1, "max us ", nullptr);
+
+  line = form->newLine(&grid);
+  line->padAll(2);
+
   // Free mem
   static std::string pad_STR_BYTES = " " + std::string(STR_BYTES);
   new StaticText(line, rect_t{}, STR_FREE_MEM_LABEL, 0, COLOR_THEME_PRIMARY1);
@@ -387,6 +407,7 @@ void DebugViewPage::build(FormWindow* window)
   auto btn = new TextButton(line, rect_t{0, 0, 0, 24}, STR_MENUTORESET,
                             [=]() -> uint8_t {
                               maxMixerDuration = 0;
+                              mixerLatencyReset();
 #if defined(LUA)
                               maxLuaInterval = 0;
                               maxLuaDuration = 0;
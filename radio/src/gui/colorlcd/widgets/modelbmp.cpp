@@ -21,6 +21,7 @@
 
 #include "opentx.h"
 #include "widgets_container_impl.h"
+#include "bitmap_cache.h"
 
 #include <memory>
 
@@ -111,17 +112,14 @@ class ModelBitmapWidget: public Widget
 
       buffer->clear();
       if (!filename.empty()) {
-        std::unique_ptr<BitmapBuffer> bitmap(BitmapBuffer::loadBitmap(fullpath.c_str()));
+        coord_t h = (rect.h >= 96 && rect.w >= 120) ? height() - 38 : height();
+        std::unique_ptr<BitmapBuffer> bitmap(loadCachedBitmap(fullpath.c_str(), width(), h));
         if (!bitmap) {
           TRACE("could not load bitmap '%s'", filename.c_str());
           return;
         }
 
-        if (rect.h >= 96 && rect.w >= 120) {
-          buffer->drawScaledBitmap(bitmap.get(), 0, 0, width(), height() - 38);
-        } else {
-          buffer->drawScaledBitmap(bitmap.get(), 0, 0, width(), height());
-        }
+        buffer->drawScaledBitmap(bitmap.get(), 0, 0, width(), h);
       }
     }
 };
@@ -54,6 +54,7 @@ void deleteMix(uint8_t idx)
   MixData * mix = mixAddress(idx);
   memmove(mix, mix+1, (MAX_MIXERS-(idx+1))*sizeof(MixData));
   memclear(&g_model.mixData[MAX_MIXERS-1], sizeof(MixData));
+  mixerPlanInvalidate();
   mixerTaskStart();
   storageDirty(EE_MODEL);
 }
@@ -73,6 +74,7 @@ void insertMix(uint8_t idx)
     }
   }
   mix->weight = 100;
+  mixerPlanInvalidate();
   mixerTaskStart();
   storageDirty(EE_MODEL);
 }
@@ -82,6 +84,7 @@ void copyMix(uint8_t idx)
   mixerTaskStop();
   MixData * mix = mixAddress(idx);
   memmove(mix+1, mix, (MAX_MIXERS-(idx+1))*sizeof(MixData));
+  mixerPlanInvalidate();
   mixerTaskStart();
   storageDirty(EE_MODEL);
 }
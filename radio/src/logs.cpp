@@ -22,6 +22,10 @@
 #include "opentx.h"
 #include "ff.h"
 
+#if defined(LOGS_BINARY)
+  #include "logs_binary.h"
+#endif
+
 #if defined(LIBOPENUI)
   #include "libopenui.h"
 #endif
@@ -96,6 +100,7 @@ void initLoggingTimer() {                                       // called cyclic
 #endif
 
 void writeHeader();
+uint32_t getLogicalSwitchesStates(uint8_t first);
 
 #if defined(PCBFRSKY) || defined(PCBNV14)
   int getSwitchState(uint8_t swtch) {
@@ -107,6 +112,326 @@ void writeHeader();
   #define GET_3POS_STATE(sw) (switchState(SW_ ## sw ## 0) ? -1 : (switchState(SW_ ## sw ## 2) ? 1 : 0))
 #endif
 
+#if defined(LOGS_BINARY)
+// Records are encoded into one of two RAM buffers by the logging tick. A full
+// buffer is handed over to logsFlush(), called from the menus task, so that
+// the SD card write latency never delays the next record. When both buffers
+// are busy, the record is dropped.
+#define LOGS_BINARY_BUFFER_SIZE       (2 * LOGS_BINARY_SECTOR_SIZE)
+#define LOGS_BINARY_PREALLOC_SIZE     (64 * 1024)
+#define LOGS_BINARY_MAX_COLUMNS       (1 + MAX_TELEMETRY_SENSORS + NUM_STICKS + NUM_POTS + NUM_SLIDERS + NUM_SWITCHES + 1 + MAX_OUTPUT_CHANNELS + 1)
+
+static uint8_t logsBuffers[2][LOGS_BINARY_BUFFER_SIZE] __DMA;
+static uint16_t logsBufferPos;
+static uint8_t logsBufferActive;
+static volatile int8_t logsBufferPending = -1;
+static volatile bool logsCloseRequested;
+static uint8_t logsRecordCrc;
+static uint16_t logsRecordSize;
+static uint32_t logsFilePos;
+static uint32_t logsFileAllocated;
+
+// the sensors logged in the current file, fixed when the file is opened
+static uint8_t logsSensors[MAX_TELEMETRY_SENSORS];
+static uint8_t logsSensorsCount;
+
+static uint8_t logsBinaryColumnSize(uint8_t type)
+{
+  switch (type) {
+    case LOGS_BINARY_COLUMN_TIME_RTC:
+      return 5;
+    case LOGS_BINARY_COLUMN_GPS:
+    case LOGS_BINARY_COLUMN_LSW:
+      return 8;
+    case LOGS_BINARY_COLUMN_DATETIME:
+      return 7;
+    case LOGS_BINARY_COLUMN_TEXT:
+      return TELEMETRY_SENSOR_TEXT_LENGTH;
+    case LOGS_BINARY_COLUMN_INT8:
+      return 1;
+    case LOGS_BINARY_COLUMN_INT16:
+    case LOGS_BINARY_COLUMN_VBAT:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+static uint8_t logsBinarySensorColumn(const TelemetrySensor & sensor)
+{
+  if (sensor.unit == UNIT_GPS)
+    return LOGS_BINARY_COLUMN_GPS;
+  else if (sensor.unit == UNIT_DATETIME)
+    return LOGS_BINARY_COLUMN_DATETIME;
+  else if (sensor.unit == UNIT_TEXT)
+    return LOGS_BINARY_COLUMN_TEXT;
+  else if (sensor.prec == 2)
+    return LOGS_BINARY_COLUMN_VALUE_PREC2;
+  else if (sensor.prec == 1)
+    return LOGS_BINARY_COLUMN_VALUE_PREC1;
+  else
+    return LOGS_BINARY_COLUMN_VALUE;
+}
+
+static FRESULT logsBinaryWriteData(const uint8_t * data, UINT size)
+{
+  if (logsFilePos + size > logsFileAllocated) {
+    // grow the file ahead of the data, so that the FAT and directory entry
+    // are not updated on each write
+    uint32_t allocated = logsFilePos + size + LOGS_BINARY_PREALLOC_SIZE;
+    FRESULT result = f_lseek(&g_oLogFile, allocated);
+    if (result == FR_OK && f_tell(&g_oLogFile) != allocated) {
+      // f_lseek() stops at the end of the free space
+      result = FR_DENIED;
+    }
+    FRESULT seek = f_lseek(&g_oLogFile, logsFilePos);
+    if (result == FR_OK) {
+      result = seek;
+    }
+    if (result != FR_OK) {
+      return result;
+    }
+    logsFileAllocated = allocated;
+  }
+
+  UINT written;
+  FRESULT result = f_write(&g_oLogFile, data, size, &written);
+  if (result == FR_OK && written != size) {
+    result = FR_DISK_ERR;
+  }
+  logsFilePos += written;
+  return result;
+}
+
+static const char * logsBinaryOpen()
+{
+  uint8_t columns[LOGS_BINARY_MAX_COLUMNS];
+  uint16_t count = 0;
+
+#if defined(RTCLOCK)
+  columns[count++] = LOGS_BINARY_COLUMN_TIME_RTC;
+#else
+  columns[count++] = LOGS_BINARY_COLUMN_TIME_10MS;
+#endif
+
+  logsSensorsCount = 0;
+  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    if (isTelemetryFieldAvailable(i)) {
+      TelemetrySensor & sensor = g_model.telemetrySensors[i];
+      if (sensor.logs) {
+        logsSensors[logsSensorsCount++] = i;
+        columns[count++] = logsBinarySensorColumn(sensor);
+      }
+    }
+  }
+
+  for (uint8_t i=0; i<NUM_STICKS+NUM_POTS+NUM_SLIDERS; i++) {
+    columns[count++] = LOGS_BINARY_COLUMN_INT16;
+  }
+
+#if defined(PCBFRSKY) || defined(PCBFLYSKY)
+  for (uint8_t i=0; i<NUM_SWITCHES; i++) {
+    if (SWITCH_EXISTS(i)) {
+      columns[count++] = LOGS_BINARY_COLUMN_INT8;
+    }
+  }
+  columns[count++] = LOGS_BINARY_COLUMN_LSW;
+  for (uint8_t channel = 0; channel < MAX_OUTPUT_CHANNELS; channel++) {
+    columns[count++] = LOGS_BINARY_COLUMN_INT16;
+  }
+#else
+  for (uint8_t i=0; i<7; i++) {
+    columns[count++] = LOGS_BINARY_COLUMN_INT8;
+  }
+#endif
+
+  columns[count++] = LOGS_BINARY_COLUMN_VBAT;
+
+  logsRecordSize = 2; // marker + crc
+  for (uint16_t i=0; i<count; i++) {
+    logsRecordSize += logsBinaryColumnSize(columns[i]);
+  }
+  if (logsRecordSize > LOGS_BINARY_BUFFER_SIZE) {
+    return STR_SDCARD_ERROR;
+  }
+
+  LogsBinaryHeader header;
+  memclear(&header, sizeof(header));
+  memcpy(header.magic, LOGS_BINARY_MAGIC, sizeof(header.magic));
+  header.version = LOGS_BINARY_VERSION;
+#if defined(RTCLOCK)
+  header.flags = LOGS_BINARY_FLAG_RTC;
+#endif
+  header.recordSize = logsRecordSize;
+  header.columnsCount = count;
+
+  UINT written;
+  FRESULT result = f_write(&g_oLogFile, &header, sizeof(header), &written);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+  result = f_write(&g_oLogFile, columns, count, &written);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+  writeHeader();
+
+  // records start on a sector boundary, so that full buffers are written
+  // as whole sectors
+  uint32_t size = f_size(&g_oLogFile);
+  header.headerSize = (size + LOGS_BINARY_SECTOR_SIZE - 1) & ~(LOGS_BINARY_SECTOR_SIZE - 1);
+  memclear(logsBuffers[0], LOGS_BINARY_SECTOR_SIZE);
+  result = f_write(&g_oLogFile, logsBuffers[0], header.headerSize - size, &written);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+  result = f_lseek(&g_oLogFile, 0);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+  result = f_write(&g_oLogFile, &header, sizeof(header), &written);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+
+  logsFilePos = logsFileAllocated = header.headerSize;
+  result = f_lseek(&g_oLogFile, logsFilePos);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+  logsBufferPos = 0;
+  logsBufferActive = 0;
+  logsBufferPending = -1;
+  return nullptr;
+}
+
+static void logsBinaryPut(const void * data, uint8_t size)
+{
+  const uint8_t * p = (const uint8_t *)data;
+  logsRecordCrc = crc8(p, size, logsRecordCrc);
+  while (size--) {
+    logsBuffers[logsBufferActive][logsBufferPos++] = *p++;
+    if (logsBufferPos == LOGS_BINARY_BUFFER_SIZE) {
+      logsBufferPending = logsBufferActive;
+      logsBufferActive ^= 1;
+      logsBufferPos = 0;
+    }
+  }
+}
+
+template <class T>
+static void logsBinaryPutValue(T value)
+{
+  logsBinaryPut(&value, sizeof(value));
+}
+
+static void logsBinaryWriteRecord()
+{
+  uint16_t available = LOGS_BINARY_BUFFER_SIZE - logsBufferPos;
+  if (logsBufferPending < 0) {
+    available += LOGS_BINARY_BUFFER_SIZE;
+  }
+  // a record filling the space left exactly would hand over the second
+  // buffer while the first one is still pending
+  if (logsRecordSize >= available) {
+    TRACE("logs: record dropped");
+    return;
+  }
+
+  logsRecordCrc = 0;
+  logsBinaryPutValue<uint8_t>(LOGS_BINARY_RECORD_MARKER);
+
+#if defined(RTCLOCK)
+  logsBinaryPutValue<uint32_t>(g_rtcTime);
+  logsBinaryPutValue<uint8_t>(g_ms100);
+#else
+  logsBinaryPutValue<uint32_t>(get_tmr10ms());
+#endif
+
+  for (uint8_t i=0; i<logsSensorsCount; i++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[logsSensors[i]];
+    TelemetryItem & telemetryItem = telemetryItems[logsSensors[i]];
+    switch (logsBinarySensorColumn(sensor)) {
+      case LOGS_BINARY_COLUMN_GPS:
+        logsBinaryPutValue<int32_t>(telemetryItem.gps.latitude);
+        logsBinaryPutValue<int32_t>(telemetryItem.gps.longitude);
+        break;
+      case LOGS_BINARY_COLUMN_DATETIME:
+        logsBinaryPut(&telemetryItem.datetime, 7);
+        break;
+      case LOGS_BINARY_COLUMN_TEXT:
+        logsBinaryPut(telemetryItem.text, TELEMETRY_SENSOR_TEXT_LENGTH);
+        break;
+      default:
+        logsBinaryPutValue<int32_t>(telemetryItem.value);
+        break;
+    }
+  }
+
+  for (uint8_t i=0; i<NUM_STICKS+NUM_POTS+NUM_SLIDERS; i++) {
+    logsBinaryPutValue<int16_t>(calibratedAnalogs[i]);
+  }
+
+#if defined(PCBFRSKY) || defined(PCBFLYSKY)
+  for (uint8_t i=0; i<NUM_SWITCHES; i++) {
+    if (SWITCH_EXISTS(i)) {
+      logsBinaryPutValue<int8_t>(getSwitchState(i));
+    }
+  }
+  logsBinaryPutValue<uint32_t>(getLogicalSwitchesStates(0));
+  logsBinaryPutValue<uint32_t>(getLogicalSwitchesStates(32));
+
+  ChannelsSnapshot channels;
+  getChannelsSnapshot(channels);
+  for (uint8_t channel = 0; channel < MAX_OUTPUT_CHANNELS; channel++) {
+    logsBinaryPutValue<int16_t>(PPM_CENTER+channels.outputs[channel]/2); // in us
+  }
+#else
+  logsBinaryPutValue<int8_t>(GET_2POS_STATE(THR));
+  logsBinaryPutValue<int8_t>(GET_2POS_STATE(RUD));
+  logsBinaryPutValue<int8_t>(GET_2POS_STATE(ELE));
+  logsBinaryPutValue<int8_t>(GET_3POS_STATE(ID));
+  logsBinaryPutValue<int8_t>(GET_2POS_STATE(AIL));
+  logsBinaryPutValue<int8_t>(GET_2POS_STATE(GEA));
+  logsBinaryPutValue<int8_t>(GET_2POS_STATE(TRN));
+#endif
+
+  logsBinaryPutValue<uint16_t>(g_vbat100mV);
+  logsBinaryPutValue<uint8_t>(logsRecordCrc);
+}
+
+void logsFlush()
+{
+  if (logsCloseRequested) {
+    logsClose();
+    return;
+  }
+
+  int8_t pending = logsBufferPending;
+  if (pending >= 0 && g_oLogFile.obj.fs) {
+    FRESULT result = logsBinaryWriteData(logsBuffers[pending], LOGS_BINARY_BUFFER_SIZE);
+    logsBufferPending = -1;
+    if (result != FR_OK) {
+      // forget the file, the next logging tick opens a new one
+      POPUP_WARNING(SDCARD_ERROR(result));
+      f_close(&g_oLogFile);
+      g_oLogFile.obj.fs = 0;
+    }
+  }
+}
+
+static void logsBinaryClose()
+{
+  logsFlush();
+  if (g_oLogFile.obj.fs) {
+    logsBinaryWriteData(logsBuffers[logsBufferActive], logsBufferPos);
+    logsBufferPos = 0;
+    // release the space preallocated beyond the last record
+    f_truncate(&g_oLogFile);
+  }
+}
+#endif
+
 void logsInit()
 {
   memset(&g_oLogFile, 0, sizeof(g_oLogFile));
@@ -168,6 +493,21 @@ const char * logsOpen()
   tmp = strAppendDate(tmp, true);
 #endif
 
+#if defined(LOGS_BINARY)
+  strcpy(tmp, LOGS_BINARY_EXT);
+
+  result = f_open(&g_oLogFile, filename, FA_CREATE_ALWAYS | FA_WRITE);
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+
+  error = logsBinaryOpen();
+  if (error) {
+    f_close(&g_oLogFile);
+    g_oLogFile.obj.fs = 0;
+  }
+  return error;
+#else
   strcpy(tmp, STR_LOGS_EXT);
 
   result = f_open(&g_oLogFile, filename, FA_OPEN_ALWAYS | FA_WRITE | FA_OPEN_APPEND);
@@ -180,20 +520,41 @@ const char * logsOpen()
   }
 
   return nullptr;
+#endif
 }
 
 void logsClose()
 {
+#if defined(LOGS_BINARY) && !defined(SIMU)
+  // no logging tick may encode into the buffers being written
+  loggingTimerStop();
+  logsCloseRequested = false;
+#endif
   if (sdMounted()) {
+#if defined(LOGS_BINARY)
+    logsBinaryClose();
+#endif
     if (f_close(&g_oLogFile) != FR_OK) {
       // close failed, forget file
       g_oLogFile.obj.fs = 0;
     }
     lastLogTime = 0;
   }
-  #if !defined(SIMU)
+#if !defined(LOGS_BINARY) && !defined(SIMU)
   loggingTimerStop();
-  #endif
+#endif
+}
+
+// Called from the logging tick. With binary logs, the menus task may be
+// writing a buffer in logsFlush() at the same time, so the file is closed
+// there instead.
+static void logsRequestClose()
+{
+#if defined(LOGS_BINARY) && !defined(SIMU)
+  logsCloseRequested = true;
+#else
+  logsClose();
+#endif
 }
 
 void writeHeader()
@@ -276,6 +637,12 @@ void logsWrite()
     return;
   }
 
+#if defined(LOGS_BINARY)
+  if (logsCloseRequested) {
+    return;
+  }
+#endif
+
   if (isFunctionActive(FUNCTION_LOGS) && logDelay100ms > 0) {
     #if defined(SIMU) || !defined(RTCLOCK)
     tmr10ms_t tmr10ms = get_tmr10ms();                                        // tmr10ms works in 10ms increments
@@ -296,6 +663,9 @@ void logsWrite()
         }
       }
 
+#if defined(LOGS_BINARY)
+      logsBinaryWriteRecord();
+#else
 #if defined(RTCLOCK)
       {
         static struct gtm utm;
@@ -363,8 +733,10 @@ void logsWrite()
       }
       f_printf(&g_oLogFile, "0x%08X%08X,", getLogicalSwitchesStates(32), getLogicalSwitchesStates(0));
 
+      ChannelsSnapshot channels;
+      getChannelsSnapshot(channels);
       for (uint8_t channel = 0; channel < MAX_OUTPUT_CHANNELS; channel++) {
-        f_printf(&g_oLogFile, "%d,", PPM_CENTER+channelOutputs[channel]/2); // in us
+        f_printf(&g_oLogFile, "%d,", PPM_CENTER+channels.outputs[channel]/2); // in us
       }
 #else
       f_printf(&g_oLogFile, "%d,%d,%d,%d,%d,%d,%d,",
@@ -385,12 +757,13 @@ void logsWrite()
         POPUP_WARNING(STR_SDCARD_ERROR);
         logsClose();
       }
+#endif
     }
   }
   else {
     error_displayed = nullptr;
     if (g_oLogFile.obj.fs) {
-      logsClose();
+      logsRequestClose();
     }
   }
 }
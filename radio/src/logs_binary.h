@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "definitions.h"
+
+// Binary log file layout (all values little endian):
+//
+//   LogsBinaryHeader
+//   columnsCount x uint8_t column type (LogsBinaryColumnType)
+//   CSV header line, as written in text mode
+//   zero padding up to headerSize (multiple of LOGS_BINARY_SECTOR_SIZE)
+//   records of recordSize bytes:
+//     LOGS_BINARY_RECORD_MARKER, column values, crc8 of marker and values
+//
+// The file is preallocated while logging and truncated on close, so a log
+// interrupted by a power loss may end with garbage: readers are expected to
+// resync on the marker and drop records with a bad crc.
+// tools/convert-binary-log.py converts it back to the CSV format.
+
+#define LOGS_BINARY_MAGIC               "ETLG"
+#define LOGS_BINARY_VERSION             1
+#define LOGS_BINARY_FLAG_RTC            0x01
+#define LOGS_BINARY_RECORD_MARKER       0xA5
+#define LOGS_BINARY_SECTOR_SIZE         512
+
+enum LogsBinaryColumnType {
+  LOGS_BINARY_COLUMN_TIME_10MS,     // uint32 10ms ticks
+  LOGS_BINARY_COLUMN_TIME_RTC,      // uint32 UTC seconds + uint8 100ms (Date and Time CSV fields)
+  LOGS_BINARY_COLUMN_VALUE,         // int32
+  LOGS_BINARY_COLUMN_VALUE_PREC1,   // int32, 1 decimal
+  LOGS_BINARY_COLUMN_VALUE_PREC2,   // int32, 2 decimals
+  LOGS_BINARY_COLUMN_GPS,           // int32 latitude + int32 longitude, 1e-6 degrees
+  LOGS_BINARY_COLUMN_DATETIME,      // uint16 year + uint8 month, day, hour, min, sec
+  LOGS_BINARY_COLUMN_TEXT,          // 16 chars, zero padded
+  LOGS_BINARY_COLUMN_INT8,
+  LOGS_BINARY_COLUMN_INT16,
+  LOGS_BINARY_COLUMN_LSW,           // uint64 logical switches states
+  LOGS_BINARY_COLUMN_VBAT,          // uint16 100mV
+};
+
+PACK(struct LogsBinaryHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t flags;
+  uint16_t recordSize;
+  uint16_t columnsCount;
+  uint16_t headerSize;
+  uint32_t reserved;
+});
@@ -27,8 +27,10 @@
 #include "opentx.h"
 #include "libopenui.h"
 #include "widget.h"
+#include "bitmap_cache.h"
 
 #include "lua_api.h"
+#include "lua_draw_list.h"
 #include "api_colorlcd.h"
 
 #define BITMAP_METATABLE "BITMAP*"
@@ -75,6 +77,90 @@ LcdFlags flagsRGB(LcdFlags flags)
     return (flags & 0xFFFF) | COLOR(COLOR_VAL(flags)) | RGB_FLAG;
 }
 
+// Bounds of the drawings recorded by the retained widgets, computed from
+// the arguments of the lcd functions
+
+static bool hasBlink(lua_State * L, int flagsIndex = 4)
+{
+  return lua_tointeger(L, flagsIndex) & BLINK;
+}
+
+static rect_t textBounds(lua_State * L, const char * s)
+{
+  LcdFlags flags = lua_tointeger(L, 4);
+  coord_t x = lua_tointeger(L, 1) + getTextHorizontalOffset(flags);
+  coord_t y = lua_tointeger(L, 2) + getTextVerticalOffset(flags);
+  coord_t h = getFontHeight(flags & 0xFFFF) + 2 * INVERT_BOX_MARGIN + 1;
+
+  // numbers, timers, sources, ...: the whole line
+  if (!s) return {-LCD_W, y - INVERT_BOX_MARGIN, 3 * LCD_W, h};
+
+  coord_t w = getTextWidth(s, 0, flags);
+  if (flags & RIGHT)
+    x -= w;
+  else if (flags & CENTERED)
+    x -= w / 2;
+
+  return {x - INVERT_BOX_MARGIN, y - INVERT_BOX_MARGIN,
+          w + 2 * INVERT_BOX_MARGIN + 1, h};
+}
+
+static rect_t rectBounds(lua_State * L, int index)
+{
+  coord_t x = lua_tointeger(L, index);
+  coord_t y = lua_tointeger(L, index + 1);
+  coord_t w = lua_tointeger(L, index + 2);
+  coord_t h = lua_tointeger(L, index + 3);
+  return {x, y, w, h};
+}
+
+static rect_t pointsBounds(lua_State * L, int count)
+{
+  coord_t xmin = LCD_W, xmax = -LCD_W, ymin = LCD_H, ymax = -LCD_H;
+  for (int i = 0; i < count; i++) {
+    coord_t x = lua_tointeger(L, 2 * i + 1);
+    coord_t y = lua_tointeger(L, 2 * i + 2);
+    xmin = min(xmin, x);
+    xmax = max(xmax, x);
+    ymin = min(ymin, y);
+    ymax = max(ymax, y);
+  }
+  return {xmin, ymin, xmax - xmin + 1, ymax - ymin + 1};
+}
+
+static rect_t circleBounds(lua_State * L, coord_t r)
+{
+  coord_t x = lua_tointeger(L, 1);
+  coord_t y = lua_tointeger(L, 2);
+  return {x - r, y - r, 2 * r + 1, 2 * r + 1};
+}
+
+static rect_t bitmapBounds(lua_State * L)
+{
+  auto b = (BitmapBuffer **)luaL_testudata(L, 1, BITMAP_METATABLE);
+  if (!b || !*b) return nullRect;
+
+  coord_t w = (*b)->width();
+  coord_t h = (*b)->height();
+  unsigned int scale = lua_tointeger(L, 4);
+  if (scale) {
+    w = w * scale / 100 + 1;
+    h = h * scale / 100 + 1;
+  }
+  coord_t x = lua_tointeger(L, 2);
+  coord_t y = lua_tointeger(L, 3);
+  return {x, y, w, h};
+}
+
+static rect_t hudBounds(lua_State * L)
+{
+  coord_t xmin = lua_tointeger(L, 3);
+  coord_t xmax = lua_tointeger(L, 4);
+  coord_t ymin = lua_tointeger(L, 5);
+  coord_t ymax = lua_tointeger(L, 6);
+  return {xmin, ymin, xmax - xmin + 1, ymax - ymin + 1};
+}
+
 /*luadoc
 @function lcd.refresh()
 
@@ -104,6 +190,9 @@ Clear the LCD screen
 */
 static int luaLcdClear(lua_State * L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdClear, LUA_DRAW_ANYWHERE);
+
   if (luaLcdAllowed && luaLcdBuffer) {
     LcdFlags flags = luaL_optunsigned(L, 1, COLOR2FLAGS(COLOR_THEME_SECONDARY3_INDEX));
     flags = flagsRGB(flags);
@@ -147,6 +236,9 @@ bottom line is 63. Drawing on an existing black pixel produces white pixel (TODO
 */
 static int luaLcdDrawPoint(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdDrawPoint, pointsBounds(L, 1));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -181,6 +273,9 @@ whole line will not be drawn (starting from OpenTX 2.1.5)
 */
 static int luaLcdDrawLine(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdDrawLine, pointsBounds(L, 2));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -276,6 +371,10 @@ Draw a text beginning at (x,y)
 */
 static int luaLcdDrawText(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawText, textBounds(L, lua_tostring(L, 3)), hasBlink(L));
+
   const char * s = luaL_checkstring(L, 3);
   LcdFlags flags = luaL_optunsigned(L, 4, 0);
   drawString(L, s, flags);
@@ -321,6 +420,10 @@ Draw text inside rectangle (x,y,w,h) with line breaks
 */
 static int luaLcdDrawTextLines(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawTextLines, rectBounds(L, 1), hasBlink(L, 6));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -377,6 +480,10 @@ Display a value formatted as time at (x,y)
 */
 static int luaLcdDrawTimer(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawTimer, textBounds(L, nullptr), hasBlink(L));
+
   char s[LEN_TIMER_STRING];
   int tme = luaL_checkinteger(L, 3);
   LcdFlags flags = luaL_optunsigned(L, 4, 0);
@@ -404,6 +511,10 @@ Display a number at (x,y)
 */
 static int luaLcdDrawNumber(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawNumber, textBounds(L, nullptr), hasBlink(L));
+
   char s[49];
   int val = luaL_checkinteger(L, 3);
   LcdFlags flags = luaL_optunsigned(L, 4, 0);
@@ -426,25 +537,47 @@ See getValue()
 
 @status current Introduced in 2.0.6, changed in 2.1.0 (only telemetry sources are valid)
 */
-static int luaLcdDrawChannel(lua_State *L)
+static int luaLcdGetChannel(lua_State *L, int index)
 {
-  if (!luaLcdAllowed || !luaLcdBuffer)
-    return 0;
-
-  int x = luaL_checkinteger(L, 1);
-  int y = luaL_checkinteger(L, 2);
   int channel = -1;
-  if (lua_isnumber(L, 3)) {
-    channel = luaL_checkinteger(L, 3);
+  if (lua_isnumber(L, index)) {
+    channel = luaL_checkinteger(L, index);
   }
   else {
-    const char * what = luaL_checkstring(L, 3);
+    const char * what = luaL_checkstring(L, index);
     LuaField field;
     bool found = luaFindFieldByName(what, field);
     if (found) {
       channel = field.id;
     }
   }
+  return channel;
+}
+
+// value drawn by lcd.drawChannel(), recorded as an input by the retained
+// widgets so that the drawing is updated when it changes
+static int luaLcdGetChannelValue(lua_State *L)
+{
+  lua_pushinteger(L, getValue(luaLcdGetChannel(L, 1)));
+  return luaRecordInput(L, luaLcdGetChannelValue, 1);
+}
+
+static int luaLcdDrawChannel(lua_State *L)
+{
+  if (luaDrawRecorder) {
+    lua_pushcfunction(L, luaLcdGetChannelValue);
+    lua_pushvalue(L, 3);
+    lua_call(L, 1, 0);
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawChannel, textBounds(L, nullptr), hasBlink(L));
+  }
+
+  if (!luaLcdAllowed || !luaLcdBuffer)
+    return 0;
+
+  int x = luaL_checkinteger(L, 1);
+  int y = luaL_checkinteger(L, 2);
+  int channel = luaLcdGetChannel(L, 3);
   LcdFlags flags = luaL_optunsigned(L, 4, 0);
   flags = flagsRGB(flags);
   getvalue_t value = getValue(channel);
@@ -469,6 +602,10 @@ displays negated switch
 */
 static int luaLcdDrawSwitch(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawSwitch, textBounds(L, nullptr), hasBlink(L));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -497,6 +634,10 @@ Displays the name of the corresponding input as defined by the source at (x,y)
 */
 static int luaLcdDrawSource(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawSource, textBounds(L, nullptr), hasBlink(L));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -522,6 +663,9 @@ Bitmap loading can fail if:
  * System is low on memory
  * Combined memory usage of all Lua script bitmaps exceeds certain value
 
+Decoded bitmaps are cached in /IMAGES/CACHE, so opening the same picture
+again is a single read of its pixels.
+
 @param name (string) full path to the bitmap on SD card (i.e. “/IMAGES/test.bmp”)
 
 @retval bitmap (object) a bitmap object that can be used with other bitmap functions
@@ -543,10 +687,10 @@ static int luaOpenBitmap(lua_State *L)
           luaExtraMemoryUsage, LUA_MEM_EXTRA_MAX);
     *b = 0;
   } else {
-    *b = BitmapBuffer::loadBitmap(filename);
+    *b = loadCachedBitmap(filename);
     if (*b == NULL && G(L)->gcrunning) {
-      luaC_fullgc(L, 1);                       /* try to free some memory... */
-      *b = BitmapBuffer::loadBitmap(filename); /* try again */
+      luaC_fullgc(L, 1);              /* try to free some memory... */
+      *b = loadCachedBitmap(filename); /* try again */
     }
   }
 
@@ -711,6 +855,9 @@ Omitting scale draws image in 1:1 scale and is faster than specifying 100 for sc
 */
 static int luaLcdDrawBitmap(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdDrawBitmap, bitmapBounds(L));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -749,6 +896,10 @@ Displays a bitmap pattern at (x,y)
 */
 static int luaLcdDrawBitmapPattern(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawBitmapPattern, LUA_DRAW_ANYWHERE);
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -786,6 +937,10 @@ Displays a bitmap pattern pie at (x,y)
 */
 static int luaLcdDrawBitmapPatternPie(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawBitmapPatternPie, LUA_DRAW_ANYWHERE);
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -825,6 +980,10 @@ Draw a rectangle from top left corner (x,y) of specified width and height
 */
 static int luaLcdDrawRectangle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawRectangle, rectBounds(L, 1));
+
   if (!luaLcdAllowed || !luaLcdBuffer) return 0;
 
   int x = luaL_checkinteger(L, 1);
@@ -861,6 +1020,10 @@ Draw a solid rectangle from top left corner (x,y) of specified width and height
 */
 static int luaLcdDrawFilledRectangle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawFilledRectangle, rectBounds(L, 1));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -896,6 +1059,9 @@ Invert a rectangle zone from top left corner (x,y) of specified width and height
 */
 static int luaLcdInvertRect(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdInvertRect, rectBounds(L, 1));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -933,6 +1099,9 @@ Draw a simple gauge that is filled based upon fill value
 */
 static int luaLcdDrawGauge(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdDrawGauge, rectBounds(L, 1));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -965,6 +1134,9 @@ Please notice that changing theme colors affects not only other Lua widgets, but
 */
 static int luaLcdSetColor(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdSetColor, LUA_DRAW_ANYWHERE);
+
   unsigned int index = COLOR_VAL(luaL_checkunsigned(L, 1));
   uint16_t color = COLOR_VAL(flagsRGB(luaL_checkunsigned(L, 2)));
 
@@ -1051,6 +1223,10 @@ Draw a circle at (x, y) of specified radius
 */
 static int luaLcdDrawCircle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawCircle, circleBounds(L, lua_tointeger(L, 3)));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1080,6 +1256,10 @@ Draw a filled circle at (x, y) of specified radius
 */
 static int luaLcdDrawFilledCircle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawFilledCircle, circleBounds(L, lua_tointeger(L, 3)));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1107,6 +1287,10 @@ Draw a triangle
 */
 static int luaLcdDrawTriangle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawTriangle, pointsBounds(L, 3));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1139,6 +1323,10 @@ Draw a filled triangle
 */
 static int luaLcdDrawFilledTriangle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawFilledTriangle, pointsBounds(L, 3));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1173,6 +1361,10 @@ Draw an arc
 */
 static int luaLcdDrawArc(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawArc, circleBounds(L, lua_tointeger(L, 3)));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1207,6 +1399,10 @@ Draw a pie slice
 */
 static int luaLcdDrawPie(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawPie, circleBounds(L, lua_tointeger(L, 3)));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1241,6 +1437,10 @@ Draw an arc
 */
 static int luaLcdDrawAnnulus(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawAnnulus, circleBounds(L, max(lua_tointeger(L, 3), lua_tointeger(L, 4))));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1275,6 +1475,10 @@ Draw a line only inside a rectangle
 */
 static int luaLcdDrawLineWithClipping(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(
+        L, luaLcdDrawLineWithClipping, pointsBounds(L, 2));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -1383,6 +1587,9 @@ Draw a rectangle in perspective
 */
 static int luaLcdDrawHudRectangle(lua_State *L)
 {
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, luaLcdDrawHudRectangle, hudBounds(L));
+
   if (!luaLcdAllowed || !luaLcdBuffer)
     return 0;
 
@@ -26,8 +26,11 @@
 #include "opentx.h"
 #include "stamp.h"
 #include "lua_api.h"
+#include "lua_cache.h"
 #include "api_filesystem.h"
 #include "hal/module_port.h"
+#include "mixer_scheduler.h"
+#include "mixer_stats.h"
 
 #if defined(LIBOPENUI)
   #include "libopenui.h"
@@ -241,7 +244,7 @@ overflows will not happen.
 static int luaGetTime(lua_State * L)
 {
   lua_pushunsigned(L, get_tmr10ms());
-  return 1;
+  return luaRecordInput(L, luaGetTime, 1);
 }
 
 void luaPushDateTime(lua_State * L, uint32_t year, uint32_t mon, uint32_t day,
@@ -291,7 +294,7 @@ static int luaGetDateTime(lua_State * L)
   struct gtm utm;
   gettime(&utm);
   luaPushDateTime(L, utm.tm_year + TM_YEAR_BASE, utm.tm_mon + 1, utm.tm_mday, utm.tm_hour, utm.tm_min, utm.tm_sec);
-  return 1;
+  return luaRecordInput(L, luaGetDateTime, 1);
 }
 
 /*luadoc
@@ -309,7 +312,7 @@ in 2038.
 static int luaGetRtcTime(lua_State * L)
 {
   lua_pushunsigned(L, g_rtcTime);
-  return 1;
+  return luaRecordInput(L, luaGetRtcTime, 1);
 }
 #endif
 
@@ -670,7 +673,7 @@ static int luaGetValue(lua_State * L)
     }
   }
   luaGetValueAndPush(L, src);
-  return 1;
+  return luaRecordInput(L, luaGetValue, 1);
 }
 
 /*luadoc
@@ -747,7 +750,7 @@ static int luaGetSourceValue(lua_State * L)
 
   if (!valid)
   {
-    return 0;
+    return luaRecordInput(L, luaGetSourceValue, 0);
   }
 
   if (src >= MIXSRC_FIRST_TELEM && src <= MIXSRC_LAST_TELEM) {
@@ -772,7 +775,7 @@ static int luaGetSourceValue(lua_State * L)
               lua_pushnil(L);
               lua_pushboolean(L, false);
               lua_pushboolean(L, false);
-              return 3;
+              return luaRecordInput(L, luaGetSourceValue, 3);
             }
             luaPushCells(L, telemetrySensor, telemetryItems[qr.quot]);
             break;
@@ -789,7 +792,7 @@ static int luaGetSourceValue(lua_State * L)
       lua_pushboolean(L, telemetryItems[qr.quot].isFresh());
     }
     else { // telemetry is not available
-      return 0;
+      return luaRecordInput(L, luaGetSourceValue, 0);
     }
   }
   else if (src == MIXSRC_TX_VOLTAGE) {
@@ -802,7 +805,7 @@ static int luaGetSourceValue(lua_State * L)
     lua_pushboolean(L, true);
     lua_pushboolean(L, true);
   }
-  return 3;
+  return luaRecordInput(L, luaGetSourceValue, 3);
 }
 
 /*luadoc
@@ -1368,7 +1371,7 @@ static int luaGetFlightMode(lua_State * L)
   strncpy(name, g_model.flightModeData[mode].name, sizeof(g_model.flightModeData[0].name));
   name[sizeof(g_model.flightModeData[0].name)] = '\0';
   lua_pushstring(L, name);
-  return 2;
+  return luaRecordInput(L, luaGetFlightMode, 2);
 }
 
 /*luadoc
@@ -1602,7 +1605,7 @@ static int luaGetGlobalTimer(lua_State * L)
   lua_pushtableinteger(L, "session", sessionTimer);
   lua_pushtableinteger(L, "throttle", s_timeCumThr);
   lua_pushtableinteger(L, "throttlepct", s_timeCum16ThrP/16);
-  return 1;
+  return luaRecordInput(L, luaGetGlobalTimer, 1);
 }
 
 #if defined(ENABLE_LUA_POPUP_INPUT)
@@ -1840,6 +1843,7 @@ static int luaSetTelemetryValue(lua_State * L)
       telemetrySensor.subId = subId;
       telemetrySensor.instance = instance;
       telemetrySensor.init(name ? name: name_buf, unit, prec);
+      telemetrySensorsIndexInvalidate();
       lua_pushboolean(L, true);
     } else {
       lua_pushboolean(L, false);
@@ -1911,7 +1915,7 @@ static int luaGetRSSI(lua_State * L)
     lua_pushunsigned(L, 0);
   lua_pushunsigned(L, g_model.rfAlarms.warning);
   lua_pushunsigned(L, g_model.rfAlarms.critical);
-  return 3;
+  return luaRecordInput(L, luaGetRSSI, 3);
 }
 
 /*luadoc
@@ -1945,17 +1949,19 @@ then the loaded script (or "chunk") is returned as a function. Otherwise, return
   which extension will be used). However, if an extension is specified, it should be ".lua" (or ".luac"), otherwise it is treated
   as part of the file name and the .lua/.luac will be appended to that.
 
-@param mode (string) (optional) Controls whether to force loading the text (.lua) or pre-compiled binary (.luac)
-  version of the script. By default ETX will load the newest version and compile a new binary if necessary (overwriting any
-  existing .luac version of the same script, and stripping some debug info like line numbers).
+@param mode (string) (optional) Controls whether to force loading the text (.lua) or pre-compiled binary
+  version of the script. By default ETX will load the compiled version kept in /SCRIPTS/CACHE if it matches the
+  size and date of the text version (or its checksum when only the date changed), and compile a new one if necessary
+  (stripping some debug info like line numbers).
+  A .luac file next to the script is only used when there is no text version.
   You can use `mode` to control the loading behavior more specifically. Possible values are:
    * `b` only binary.
    * `t` only text.
    * `T` (default on simulator) prefer text but load binary if that is the only version available.
-   * `bt` (default on radio) either binary or text, whichever is newer (binary preferred when timestamps are equal).
-   * Add `x` to avoid automatic compilation of source file to .luac version.
+   * `bt` (default on radio) either the cached binary or text, binary when it matches the text version.
+   * Add `x` to avoid automatic compilation of source file to the cache.
        Eg: "tx", "bx", or "btx".
-   * Add `c` to force compilation of source file to .luac version (even if existing version is newer than source file).
+   * Add `c` to force compilation of source file to the cache (even if the cached version matches the source file).
        Eg: "tc" or "btc" (forces "t", overrides "x").
    * Add `d` to keep extra debug info in the compiled binary.
        Eg: "td", "btd", or "tcd" (no effect with just "b" or with "x").
@@ -1991,7 +1997,11 @@ static int luaLoadScript(lua_State * L)
   const char *mode = luaL_optstring(L, 2, NULL);
   int env = (!lua_isnone(L, 3) ? 3 : 0);  // 'env' index or 0 if no 'env'
   lua_settop(L, 0);
-  if (fname != NULL && luaLoadScriptFileToState(L, fname , mode) == SCRIPT_OK) {
+  int status = (fname != NULL ? luaLoadScriptFileToState(L, fname , mode) : SCRIPT_NOFILE);
+#if defined(LUA_COMPILER)
+  luaCacheSave();
+#endif
+  if (status == SCRIPT_OK) {
     if (env != 0) {  // 'env' parameter?
       lua_pushvalue(L, env);  // environment for loaded function
       if (!lua_setupvalue(L, -2, 1))  // set it as 1st upvalue
@@ -2026,6 +2036,123 @@ static int luaGetUsage(lua_State * L)
   return 1;
 }
 
+/*luadoc
+@function getScriptStats([reset])
+
+Get the scheduler statistics of the running model, function and telemetry
+scripts. Each script runs in its own coroutine and is preempted once it has
+executed its instructions budget, the next script being run in the meantime.
+
+@param reset (optional) if true, maximum values are reset after being read
+
+@retval table one entry per script, each entry being a table with:
+ * `name` (string) script file name
+ * `type` (string) "mix", "function", "telemetry" or "standalone"
+ * `state` (number) 0 when running, otherwise the script was stopped because of an error
+ * `runs` (number) number of completed calls
+ * `preemptions` (number) number of times a call was suspended
+ * `budget` (number) instructions allowed before preemption, 0 when unlimited
+ * `instructions` (number) instructions of the last completed call, counted by 100
+ * `maxInstructions` (number)
+ * `time` (number) duration of the last completed call, in us
+ * `maxTime` (number)
+ * `memory` (number) memory allocated during the last completed call, in bytes
+ * `maxMemory` (number)
+
+@status current Introduced in 2.9.0
+*/
+static int luaGetScriptStats(lua_State * L)
+{
+  static const char * const types[] = { "mix", "function", "telemetry", "standalone", "widget" };
+  bool reset = lua_toboolean(L, 1);
+
+  lua_createtable(L, luaScriptsCount, 0);
+  for (int i = 0; i < luaScriptsCount; i++) {
+    ScriptInternalData & sid = scriptInternalData[i];
+    LuaScriptStats & stats = sid.stats;
+    uint8_t scriptClass = luaGetScriptClass(sid.reference);
+
+    lua_createtable(L, 0, 12);
+    const char * name = luaGetScriptName(i);
+    lua_pushstring(L, "name");
+    lua_pushlstring(L, name, strnlen(name, LEN_SCRIPT_FILENAME));
+    lua_settable(L, -3);
+    lua_pushtablestring(L, "type", types[scriptClass]);
+    lua_pushtableinteger(L, "state", sid.state);
+    lua_pushtableinteger(L, "runs", stats.runs);
+    lua_pushtableinteger(L, "preemptions", stats.preemptions);
+    lua_pushtableinteger(L, "budget", luaScriptBudgets[scriptClass]);
+    lua_pushtableinteger(L, "instructions", stats.instructions);
+    lua_pushtableinteger(L, "maxInstructions", stats.maxInstructions);
+    lua_pushtableinteger(L, "time", stats.time);
+    lua_pushtableinteger(L, "maxTime", stats.maxTime);
+    lua_pushtableinteger(L, "memory", stats.memory);
+    lua_pushtableinteger(L, "maxMemory", stats.maxMemory);
+    lua_rawseti(L, -2, i + 1);
+
+    if (reset) {
+      stats.maxInstructions = 0;
+      stats.maxTime = 0;
+      stats.maxMemory = 0;
+    }
+  }
+  return 1;
+}
+
+/*luadoc
+@function getMixerLatency([reset])
+
+Get the mixer task timing histograms, all durations being in us.
+
+@param reset (optional) if true, the histograms are cleared after being read
+
+@retval table with the mixer `period` (number) and one entry per measurement,
+`adcToPulses` (start of the mixer cycle to channels sent), `jitter` (difference
+between the cycle period and the mixer period) and `pulses` (channels sending
+duration), each entry being a table with:
+ * `count` (number) number of samples
+ * `min` (number)
+ * `max` (number)
+ * `last` (number)
+ * `p50` (number) upper bound of the median bucket
+ * `p99` (number) upper bound of the 99th percentile bucket
+ * `buckets` (table) sample counts, bucket `i` holding the values below `2^i` us
+
+@status current Introduced in 2.9.0
+*/
+static int luaGetMixerLatency(lua_State * L)
+{
+  static const char * const keys[MIXER_LATENCY_COUNT] = { "adcToPulses", "jitter", "pulses" };
+  bool reset = lua_toboolean(L, 1);
+
+  lua_createtable(L, 0, MIXER_LATENCY_COUNT + 1);
+  lua_pushtableinteger(L, "period", getMixerSchedulerPeriod());
+  for (int i = 0; i < MIXER_LATENCY_COUNT; i++) {
+    const LatencyHistogram & histogram = mixerLatency[i];
+    lua_pushstring(L, keys[i]);
+    lua_createtable(L, 0, 7);
+    lua_pushtableinteger(L, "count", histogram.getCount());
+    lua_pushtableinteger(L, "min", histogram.getMin());
+    lua_pushtableinteger(L, "max", histogram.getMax());
+    lua_pushtableinteger(L, "last", histogram.getLast());
+    lua_pushtableinteger(L, "p50", histogram.getPercentile(50));
+    lua_pushtableinteger(L, "p99", histogram.getPercentile(99));
+    lua_pushstring(L, "buckets");
+    lua_createtable(L, LATENCY_HISTOGRAM_BUCKETS, 0);
+    for (int j = 0; j < LATENCY_HISTOGRAM_BUCKETS; j++) {
+      lua_pushinteger(L, histogram.getBucket(j));
+      lua_rawseti(L, -2, j + 1);
+    }
+    lua_settable(L, -3);
+    lua_settable(L, -3);
+  }
+
+  if (reset) {
+    mixerLatencyReset();
+  }
+  return 1;
+}
+
 /*luadoc
 @function getAvailableMemory()
 
@@ -2354,7 +2481,7 @@ static int luaGetShmVar(lua_State * L)
   else
     lua_pushnil(L);
 
-  return 1;
+  return luaRecordInput(L, luaGetShmVar, 1);
 }
 #endif
 
@@ -2411,7 +2538,7 @@ static int luaGetLogicalSwitchValue(lua_State * L)
     lua_pushboolean(L, getSwitch(SWSRC_FIRST_LOGICAL_SWITCH + id));
   else
     lua_pushnil(L);
-  return 1;
+  return luaRecordInput(L, luaGetLogicalSwitchValue, 1);
 }
 
 /*luadoc
@@ -2500,7 +2627,7 @@ static int luaGetSwitchValue(lua_State * L)
     lua_pushboolean(L, getSwitch(idx));
   else
     lua_pushnil(L);
-  return 1;
+  return luaRecordInput(L, luaGetSwitchValue, 1);
 }
 
 /*luadoc
@@ -2693,7 +2820,7 @@ static int luaGetOutputValue(lua_State * L)
   } else {
     lua_pushinteger(L, 0);
   }
-  return 1;
+  return luaRecordInput(L, luaGetOutputValue, 1);
 }
 
 /*luadoc
@@ -2759,6 +2886,8 @@ LROT_BEGIN(etxlib, NULL, 0)
   LROT_FUNCENTRY( chdir, luaChdir )
   LROT_FUNCENTRY( loadScript, luaLoadScript )
   LROT_FUNCENTRY( getUsage, luaGetUsage )
+  LROT_FUNCENTRY( getScriptStats, luaGetScriptStats )
+  LROT_FUNCENTRY( getMixerLatency, luaGetMixerLatency )
   LROT_FUNCENTRY( getAvailableMemory, luaGetAvailableMemory )
   LROT_FUNCENTRY( resetGlobalTimer, luaResetGlobalTimer )
 #if LCD_DEPTH > 1 && !defined(COLORLCD)
@@ -1560,7 +1560,7 @@ static int luaModelGetGlobalVariable(lua_State *L)
     lua_pushinteger(L, getGVarValue(idx, phase));
   else
     lua_pushnil(L);
-  return 1;
+  return luaRecordInput(L, luaModelGetGlobalVariable, 1);
 }
 
 /*luadoc
@@ -1652,6 +1652,7 @@ static int luaModelResetSensor(lua_State *L)
   unsigned int idx = luaL_checkunsigned(L, 1);
   if (idx < MAX_TELEMETRY_SENSORS) {
     telemetryItems[idx].clear();
+    telemetryItemChanged(idx);
   }
 
   lua_pushnil(L);
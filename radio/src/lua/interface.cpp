@@ -30,6 +30,7 @@
 
 #include "lua_api.h"
 #include "lua_event.h"
+#include "lua_cache.h"
 
 #include "sdcard.h"
 #include "api_filesystem.h"
@@ -71,6 +72,40 @@ uint16_t maxLuaInterval = 0;
 uint16_t maxLuaDuration = 0;
 uint8_t instructionsPercent = 0;
 tmr10ms_t luaCycleStart;
+
+const uint16_t luaScriptBudgets[LUA_CLASS_COUNT] = {
+  LUA_BUDGET_MIX,
+  LUA_BUDGET_FUNCTION,
+  LUA_BUDGET_TELEMETRY,
+  LUA_BUDGET_STANDALONE,
+  LUA_BUDGET_WIDGET,
+};
+
+// Script being resumed by resumeLua(), if any
+static ScriptInternalData * luaRunningScript = nullptr;
+static uint16_t luaRunningBudget;
+// The cycle time is over, no other script should be resumed
+static bool luaCycleTimeout;
+
+// The 2MHz timer wraps after 32ms, longer periods use the 10ms tick
+struct LuaTimeMark {
+  uint16_t t2MHz;
+  tmr10ms_t t10ms;
+};
+
+static void luaTimeMark(LuaTimeMark & mark)
+{
+  mark.t2MHz = getTmr2MHz();
+  mark.t10ms = get_tmr10ms();
+}
+
+static uint32_t luaElapsedUs(const LuaTimeMark & mark)
+{
+  tmr10ms_t ticks = get_tmr10ms() - mark.t10ms;
+  if (ticks >= 3)
+    return ticks * 10000;
+  return (uint16_t)(getTmr2MHz() - mark.t2MHz) / 2;
+}
 char lua_warning_info[LUA_WARNING_INFO_LEN+1];
 uint8_t errorState;
 struct our_longjmp * global_lj = 0;
@@ -125,11 +160,24 @@ int custom_lua_atpanic(lua_State * L)
 static void luaHook(lua_State * L, lua_Debug *ar)
 {
   if (ar->event == LUA_HOOKCOUNT) {
+    if (luaRunningScript) {
+      luaRunningScript->stats.sliceInstructions += PERMANENT_SCRIPTS_MAX_INSTRUCTIONS;
+    }
+    // yielding across a C call (pcall, sort comparator, ...) would raise an
+    // error and kill the script, try again on the next hook instead
+    if (!lua_isyieldable(L)) {
+      return;
+    }
     if (get_tmr10ms() - luaCycleStart >= LUA_TASK_PERIOD_TICKS) {
-      lua_yield(lsScripts, 0);
+      luaCycleTimeout = true;
+      lua_yield(L, 0);
+    }
+    else if (luaRunningBudget && luaRunningScript->stats.sliceInstructions >= luaRunningBudget) {
+      // give the next script a chance once the budget is spent
+      lua_yield(L, 0);
     }
   }
-  
+
 #if defined(LUA_ALLOCATOR_TRACER)
   else if (ar->event == LUA_HOOKLINE) {
     lua_getinfo(L, "nSl", ar);
@@ -325,6 +373,11 @@ void luaDoGc(lua_State * L, bool full)
 void luaFree(lua_State * L, ScriptInternalData & sid)
 {
   PROTECT_LUA() {
+    if (sid.threadRef) {
+      luaL_unref(L, LUA_REGISTRYINDEX, sid.threadRef);
+      sid.threadRef = 0;
+      sid.thread = nullptr;
+    }
     if (sid.run) {
       luaL_unref(L, LUA_REGISTRYINDEX, sid.run);
       sid.run = 0;
@@ -353,29 +406,30 @@ static int luaDumpWriter(lua_State * L, const void* p, size_t size, void* u)
 }
 
 /*
-  @fn luaDumpState(lua_State * L, const char * filename, const FILINFO * finfo, int stripDebug)
+  @fn luaDumpState(lua_State * L, const char * filename, int stripDebug)
   Save compiled bytecode from a given Lua stack to a file.
   @param L The Lua stack to dump.
-  @param filename Full path and name of file to save to (typically with .luac extension).
-  @param finfo Can be NULL. If not NULL, sets timestamp of created file to match the one in finfo->fdate/ftime
+  @param filename Full path and name of file to save to (typically in SCRIPTS_CACHE_PATH).
   @param stripDebug This is passed directly to luaU_dump()
     1 = remove debug info from bytecode (smaller but errors are less informative)
     0 = keep debug info
+  @retval true if the file has been written
 */
-static void luaDumpState(lua_State * L, const char * filename, const FILINFO * finfo, int stripDebug)
+static bool luaDumpState(lua_State * L, const char * filename, int stripDebug)
 {
   FIL D;
   if (f_open(&D, filename, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
     lua_lock(L);
-    luaU_dump(L, getproto(L->top - 1), luaDumpWriter, &D, stripDebug);
+    int status = luaU_dump(L, getproto(L->top - 1), luaDumpWriter, &D, stripDebug);
     lua_unlock(L);
-    if (f_close(&D) == FR_OK) {
-      if (finfo != nullptr)
-        f_utime(filename, finfo);  // set the file mod time
+    if (f_close(&D) == FR_OK && status == 0) {
       TRACE("luaDumpState(%s): Saved bytecode to file.", filename);
+      return true;
     }
-  } else
-    TRACE_ERROR("luaDumpState(%s): Error: Could not open output file\n", filename);
+    f_unlink(filename);
+  }
+  TRACE_ERROR("luaDumpState(%s): Error: Could not write output file\n", filename);
+  return false;
 }
 #endif  // LUA_COMPILER
 
@@ -390,10 +444,11 @@ static void luaDumpState(lua_State * L, const char * filename, const FILINFO * f
     "b" only binary.
     "t" only text.
     "T" (default on simulator) prefer text but load binary if that is the only version available.
-    "bt" (default on radio) either binary or text, whichever is newer (binary preferred when timestamps are equal).
-    Add "x" to avoid automatic compilation of source file to .luac version.
+    "bt" (default on radio) the compiled version from the cache if it matches the text version,
+      otherwise text (or the .luac file when there is no text version).
+    Add "x" to avoid automatic compilation of source file to the cache.
       Eg: "tx", "bx", or "btx".
-    Add "c" to force compilation of source file to .luac version (even if existing version is newer than source file).
+    Add "c" to force compilation of source file to the cache (even if the cached version matches the source file).
       Eg: "tc" or "btc" (forces "t", overrides "x").
     Add "d" to keep extra debug info in the compiled binary.
       Eg: "td", "btd", or "tcd" (no effect with just "b" or with "x").
@@ -424,14 +479,15 @@ int luaLoadScriptFileToState(lua_State * L, const char * filename, const char *
   uint16_t fnamelen;
   uint8_t extlen;
   char filenameFull[LEN_FILE_PATH_MAX + FF_MAX_LFN + 1] = "\0";
-  FILINFO fnoLuaS, fnoLuaC;
-  FRESULT frLuaS, frLuaC;
+  char filenameCache[LUA_CACHE_FILENAME_LEN];
+  FILINFO fnoLuaS;
+  FRESULT frLuaS;
+  LuaCacheKey key;
 
   bool scriptNeedsCompile = false;
-  uint8_t loadFileType = 0;  // 1=text, 2=binary
+  uint8_t loadFileType = 0;  // 1=text, 2=binary, 3=cached binary
 
   memclear(&fnoLuaS, sizeof(FILINFO));
-  memclear(&fnoLuaC, sizeof(FILINFO));
 
   fnamelen = strlen(filename);
   // check if file extension is already in the file name and strip it
@@ -443,59 +499,47 @@ int luaLoadScriptFileToState(lua_State * L, const char * filename, const char *
   }
   strncat(filenameFull, filename, fnamelen);
 
-  // check if binary version exists
-  strcpy(filenameFull + fnamelen, SCRIPT_BIN_EXT);
-  frLuaC = f_stat(filenameFull, &fnoLuaC);
-
   // check if text version exists
   strcpy(filenameFull + fnamelen, SCRIPT_EXT);
   frLuaS = f_stat(filenameFull, &fnoLuaS);
 
-  // decide which version to load, text or binary
-  if (frLuaC != FR_OK && frLuaS == FR_OK) {
-    // only text version exists
-    loadFileType = 1;
-    scriptNeedsCompile = true;
-  }
-  else if (frLuaC == FR_OK && frLuaS != FR_OK) {
-    // only binary version exists
-    loadFileType = 2;
-  }
-  else if (frLuaS == FR_OK) {
-    // both versions exist, compare them
-    if (strchr(lmode, 'c') || (uint32_t)((fnoLuaC.fdate << 16) + fnoLuaC.ftime) < (uint32_t)((fnoLuaS.fdate << 16) + fnoLuaS.ftime)) {
-      // text version is newer than binary or forced by "c" mode flag, rebuild it
+  if (frLuaS == FR_OK) {
+    // look for a compiled version of the same content
+    luaCacheLoad();
+    luaCacheGetKey(filenameFull, fnoLuaS, key);
+    luaCacheGetFilename(key, filenameCache);
+    if (strchr(lmode, 'c') || !luaCacheFind(filenameFull, key)) {
+      // text version changed since it was compiled or forced by "c" mode flag, rebuild it
       scriptNeedsCompile = true;
     }
     if (scriptNeedsCompile || !strchr(lmode, 'b')) {
       // text version needs compilation or forced by mode
       loadFileType = 1;
     } else {
-      // use binary file
+      // use cached binary
+      loadFileType = 3;
+    }
+  }
+
+  if (frLuaS != FR_OK || (loadFileType == 1 && !strpbrk(lmode, "tTc"))) {
+    // check if binary version exists
+    FILINFO fnoLuaC;
+    strcpy(filenameFull + fnamelen, SCRIPT_BIN_EXT);
+    if (f_stat(filenameFull, &fnoLuaC) == FR_OK) {
       loadFileType = 2;
     }
+    else {
+      strcpy(filenameFull + fnamelen, SCRIPT_EXT);
+    }
   }
-  // else both versions are missing
 
   // skip compilation based on mode flags? ("c" overrides "x")
   if (scriptNeedsCompile && strchr(lmode, 'x') && !strchr(lmode, 'c')) {
     scriptNeedsCompile = false;
   }
 
-  if (loadFileType == 2) {
-    // change file extension to binary version
-    strcpy(filenameFull + fnamelen, SCRIPT_BIN_EXT);
-  }
-
-//  TRACE_DEBUG("luaLoadScriptFileToState(%s, %s):\n", filename, lmode);
-//  TRACE_DEBUG("\tldfile='%s'; ldtype=%u; compile=%u;\n", filenameFull, loadFileType, scriptNeedsCompile);
-//  TRACE_DEBUG("\t%-5s: %s; mtime: %04X%04X = %u/%02u/%02u %02u:%02u:%02u;\n", SCRIPT_EXT, (frLuaS == FR_OK ? "ok" : "nf"), fnoLuaS.fdate, fnoLuaS.ftime,
-//      (fnoLuaS.fdate >> 9) + 1980, (fnoLuaS.fdate >> 5) & 15, fnoLuaS.fdate & 31, fnoLuaS.ftime >> 11, (fnoLuaS.ftime >> 5) & 63, (fnoLuaS.ftime & 31) * 2);
-//  TRACE_DEBUG("\t%-5s: %s; mtime: %04X%04X = %u/%02u/%02u %02u:%02u:%02u;\n", SCRIPT_BIN_EXT, (frLuaC == FR_OK ? "ok" : "nf"), fnoLuaC.fdate, fnoLuaC.ftime,
-//      (fnoLuaC.fdate >> 9) + 1980, (fnoLuaC.fdate >> 5) & 15, fnoLuaC.fdate & 31, fnoLuaC.ftime >> 11, (fnoLuaC.ftime >> 5) & 63, (fnoLuaC.ftime & 31) * 2);
-
   // final check that file exists and is allowed by mode flags
-  if (!loadFileType || (loadFileType == 1 && !strpbrk(lmode, "tTc")) || (loadFileType == 2 && !strpbrk(lmode, "bT"))) {
+  if (!loadFileType || (loadFileType == 1 && !strpbrk(lmode, "tTc")) || (loadFileType >= 2 && !strpbrk(lmode, "bT"))) {
     TRACE_ERROR("luaLoadScriptFileToState(%s, %s): Error loading script: file not found.\n", filename, lmode);
     return SCRIPT_NOFILE;
   }
@@ -507,23 +551,37 @@ int luaLoadScriptFileToState(lua_State * L, const char * filename, const char *
 
 #endif
 
-  TRACE("luaLoadScriptFileToState(%s, %s): loading %s", filename, lmode, filenameFull);
+#if defined(LUA_COMPILER)
+  const char * filenameLoad = (loadFileType == 3 ? filenameCache : filenameFull);
+#else
+  const char * filenameLoad = filenameFull;
+#endif
+
+  TRACE("luaLoadScriptFileToState(%s, %s): loading %s", filename, lmode, filenameLoad);
 
   // we don't pass <mode> on to loadfilex() because we want lua to load whatever file we specify, regardless of content
-  lstatus = luaL_loadfilex(L, filenameFull, nullptr);
+  lstatus = luaL_loadfilex(L, filenameLoad, nullptr);
 #if defined(LUA_COMPILER)
-  // Check for bytecode encoding problem, eg. compiled for x64. Unfortunately Lua doesn't provide a unique error code for this. See Lua/src/lundump.c.
-  if (lstatus == LUA_ERRSYNTAX && loadFileType == 2 && frLuaS == FR_OK && strstr(lua_tostring(L, -1), "precompiled")) {
+  // Check for a missing or unusable cached version, or a bytecode encoding problem, eg. compiled for x64.
+  // Unfortunately Lua doesn't provide a unique error code for this. See Lua/src/lundump.c.
+  if (lstatus != LUA_OK && lstatus != LUA_ERRMEM && frLuaS == FR_OK &&
+      (loadFileType == 3 || (lstatus == LUA_ERRSYNTAX && loadFileType == 2 && strstr(lua_tostring(L, -1), "precompiled")))) {
+    if (loadFileType == 3) {
+      luaCacheRemove(key);
+    }
     loadFileType = 1;
     scriptNeedsCompile = true;
     strcpy(filenameFull + fnamelen, SCRIPT_EXT);
     TRACE_ERROR("luaLoadScriptFileToState(%s, %s): Error loading script: %s\n\tRetrying with %s\n", filename, lmode, lua_tostring(L, -1), filenameFull);
+    lua_pop(L, 1);  // error message
     lstatus = luaL_loadfilex(L, filenameFull, nullptr);
   }
   if (lstatus == LUA_OK) {
     if (scriptNeedsCompile && loadFileType == 1) {
-      strcpy(filenameFull + fnamelen, SCRIPT_BIN_EXT);
-      luaDumpState(L, filenameFull, &fnoLuaS, (strchr(lmode, 'd') ? 0 : 1));
+      sdCheckAndCreateDirectory(SCRIPTS_CACHE_PATH);
+      if (luaDumpState(L, filenameCache, (strchr(lmode, 'd') ? 0 : 1))) {
+        luaCacheAdd(filenameFull, key);
+      }
     }
     ret = SCRIPT_OK;
   }
@@ -549,7 +607,22 @@ int luaLoadScriptFileToState(lua_State * L, const char * filename, const char *
 }
 
 // Get the name of a script for error reporting etc.
-static const char * getScriptName(uint8_t idx)
+uint8_t luaGetScriptClass(uint8_t reference)
+{
+#if defined(LUA_MODEL_SCRIPTS)
+  if (reference <= SCRIPT_MIX_LAST)
+    return LUA_CLASS_MIX;
+#endif
+  if (reference <= SCRIPT_GFUNC_LAST)
+    return LUA_CLASS_FUNCTION;
+#if defined(PCBTARANIS)
+  if (reference <= SCRIPT_TELEMETRY_LAST)
+    return LUA_CLASS_TELEMETRY;
+#endif
+  return LUA_CLASS_STANDALONE;
+}
+
+const char * luaGetScriptName(uint8_t idx)
 {
   int ref = scriptInternalData[idx].reference;
 
@@ -820,7 +893,7 @@ static int luaRegisterFunction(const char * key)
   }
   else {
     if (typ != LUA_TNIL) {
-      TRACE_ERROR("luaRegisterFunction(%s): Error: '%.*s' is not a function\n", LEN_SCRIPT_FILENAME, getScriptName(luaScriptsCount - 1), key);
+      TRACE_ERROR("luaRegisterFunction(%s): Error: '%.*s' is not a function\n", LEN_SCRIPT_FILENAME, luaGetScriptName(luaScriptsCount - 1), key);
     }
     lua_pop(lsScripts, 1);
     return LUA_NOREF;
@@ -927,7 +1000,7 @@ static void luaLoadScripts(bool init, const char * filename = nullptr)
             sid.background = luaRegisterFunction("background");
             initFunction = luaRegisterFunction("init");
             if (sid.run == LUA_NOREF) {
-              snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "luaLoadScripts(%.*s): No run function\n", LEN_SCRIPT_FILENAME, getScriptName(idx));
+              snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "luaLoadScripts(%.*s): No run function\n", LEN_SCRIPT_FILENAME, luaGetScriptName(idx));
               sid.state = SCRIPT_SYNTAX_ERROR;
               initFunction = LUA_NOREF;
             }
@@ -945,7 +1018,7 @@ static void luaLoadScripts(bool init, const char * filename = nullptr)
 #endif
           }
           else {
-            snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "luaLoadScripts(%.*s): The script did not return a table\n", LEN_SCRIPT_FILENAME, getScriptName(idx));
+            snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "luaLoadScripts(%.*s): The script did not return a table\n", LEN_SCRIPT_FILENAME, luaGetScriptName(idx));
             sid.state = SCRIPT_SYNTAX_ERROR;
             initFunction = LUA_NOREF;
           }
@@ -978,6 +1051,10 @@ static void luaLoadScripts(bool init, const char * filename = nullptr)
     
   } while(++ref < SCRIPT_STANDALONE);
  
+#if defined(LUA_COMPILER)
+  luaCacheSave();
+#endif
+
   // Loading has finished - start running scripts
   luaState = INTERPRETER_START_RUNNING;
 } // luaLoadScripts
@@ -988,33 +1065,53 @@ void luaExec(const char * filename)
   luaLoadScripts(true, filename);
 }
 
+static void luaUpdateStats(ScriptInternalData & sid)
+{
+  LuaScriptStats & stats = sid.stats;
+  stats.runs++;
+  stats.instructions = stats.callInstructions;
+  stats.time = stats.callTime;
+  stats.memory = stats.callMemory;
+  if (stats.instructions > stats.maxInstructions)
+    stats.maxInstructions = stats.instructions;
+  if (stats.time > stats.maxTime)
+    stats.maxTime = stats.time;
+  if (stats.memory > stats.maxMemory)
+    stats.maxMemory = stats.memory;
+
+  uint16_t budget = luaScriptBudgets[luaGetScriptClass(sid.reference)];
+  sid.instructions = budget ? min<uint32_t>(100, 100 * stats.instructions / budget) : 0;
+}
+
+// Each script runs in its own coroutine, so that a script which yields
+// does not prevent the others from running. Mix scripts always run first
+// and in the same order, since the mixer uses their outputs. The other
+// scripts are visited round-robin, a new cycle starting after the script
+// that ran out of time in the previous one.
 static bool resumeLua(bool init, bool allowLcdUsage)
 {
-  static uint8_t idx;
+  static uint8_t nextIdx;
   static LuaEventData evt;
-  if (init) idx = 0;
+  if (init) nextIdx = 0;
 
   bool scriptWasRun = false;
   bool fullGC = !allowLcdUsage;
   static uint8_t luaDisplayStatistics = false;
- 
-  // Run in the right interactive mode
-  if (lua_status(lsScripts) == LUA_YIELD && allowLcdUsage != luaLcdAllowed) {
-#if defined(PCBTARANIS)
-    uint8_t ref = scriptInternalData[idx].reference;
-    if (luaLcdAllowed && menuHandlers[menuLevel] != menuViewTelemetry && ref >= SCRIPT_TELEMETRY_FIRST && ref <= SCRIPT_TELEMETRY_LAST) {
-      // Telemetry screen was exited while foreground function was preempted - finish in the background
-      luaLcdAllowed = false;
-    } else
-#endif
-    {
-      return scriptWasRun;
-    }
-  } else {
-    luaLcdAllowed = allowLcdUsage;
+
+  luaCycleTimeout = false;
+
+  // scripts are loaded by reference, the mix scripts come first
+  uint8_t mixCount = 0;
+#if defined(LUA_MODEL_SCRIPTS)
+  while (mixCount < luaScriptsCount && scriptInternalData[mixCount].reference <= SCRIPT_MIX_LAST) {
+    mixCount++;
   }
-  
-  for (; idx < luaScriptsCount; idx++) {
+#endif
+  uint8_t rotatedCount = luaScriptsCount - mixCount;
+  uint8_t startIdx = (nextIdx < rotatedCount ? nextIdx : 0);
+
+  for (uint8_t n = 0; n < luaScriptsCount; n++) {
+    uint8_t idx = (n < mixCount ? n : mixCount + (startIdx + n - mixCount) % rotatedCount);
     ScriptInternalData & sid = scriptInternalData[idx];
     uint8_t ref = sid.reference;
     
@@ -1034,11 +1131,35 @@ static bool resumeLua(bool init, bool allowLcdUsage)
     }
     
     int inputsCount = 0;
-    int luaStatus = lua_status(lsScripts);
+    lua_State * co = sid.thread;
+    bool yielded = co && lua_status(co) == LUA_YIELD;
+
+    if (yielded) {
+      // Finish the pending call in the right interactive mode
+      if (sid.threadLcd != allowLcdUsage) {
+#if defined(PCBTARANIS)
+        if (sid.threadLcd && menuHandlers[menuLevel] != menuViewTelemetry && ref >= SCRIPT_TELEMETRY_FIRST && ref <= SCRIPT_TELEMETRY_LAST) {
+          // Telemetry screen was exited while foreground function was preempted - finish in the background
+          sid.threadLcd = false;
+        } else
+#endif
+        {
+          continue;
+        }
+      }
+      luaLcdAllowed = sid.threadLcd;
+    }
+    else {
+      luaLcdAllowed = allowLcdUsage;
+
+      if (!co) {
+        co = lua_newthread(L);
+        sid.threadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        sid.thread = co;
+      }
 
-    if (luaStatus == LUA_OK) {
       // Not preempted - setup another function call
-      lua_settop(lsScripts, 0);
+      lua_settop(co, 0);
      
       if (allowLcdUsage) {
 #if defined(PCBTARANIS)
@@ -1051,13 +1172,13 @@ static bool resumeLua(bool init, bool allowLcdUsage)
           // Pull a new event from the buffer
           luaNextEvent(&evt);
 
-          lua_rawgeti(lsScripts, LUA_REGISTRYINDEX, sid.run);
-          lua_pushunsigned(lsScripts, evt.event);
+          lua_rawgeti(co, LUA_REGISTRYINDEX, sid.run);
+          lua_pushunsigned(co, evt.event);
           inputsCount = 1;
 
 #if defined(HARDWARE_TOUCH)
           if (IS_TOUCH_EVENT(evt.event)) {
-            luaPushTouchEventTable(lsScripts, &evt);
+            luaPushTouchEventTable(co, &evt);
             inputsCount = 2;
           }
 #endif
@@ -1067,7 +1188,7 @@ static bool resumeLua(bool init, bool allowLcdUsage)
       else {
 #if defined(LUA_MODEL_SCRIPTS)
         if (ref <= SCRIPT_MIX_LAST) {
-          lua_rawgeti(lsScripts, LUA_REGISTRYINDEX, sid.run);
+          lua_rawgeti(co, LUA_REGISTRYINDEX, sid.run);
          
           ScriptData & sd = g_model.scriptsData[ref - SCRIPT_MIX_FIRST];
           ScriptInputsOutputs * sio = & scriptInputsOutputs[ref - SCRIPT_MIX_FIRST];
@@ -1075,9 +1196,9 @@ static bool resumeLua(bool init, bool allowLcdUsage)
 
           for (int j = 0; j < inputsCount; j++) {
             if (sio->inputs[j].type == INPUT_TYPE_SOURCE)
-              luaGetValueAndPush(lsScripts, sd.inputs[j].source);
+              luaGetValueAndPush(co, sd.inputs[j].source);
             else
-              lua_pushinteger(lsScripts,
+              lua_pushinteger(co,
                               sd.inputs[j].value + sio->inputs[j].def);
           }
         } else
@@ -1100,61 +1221,87 @@ static bool resumeLua(bool init, bool allowLcdUsage)
           tmr10ms_t tmr10ms = get_tmr10ms();
 
           if (getSwitch(fn->swtch) && (functionsContext->lastFunctionTime[idx] == 0 || CFN_PLAY_REPEAT(fn) == 0)) {
-            lua_rawgeti(lsScripts, LUA_REGISTRYINDEX, sid.run);
+            lua_rawgeti(co, LUA_REGISTRYINDEX, sid.run);
             functionsContext->lastFunctionTime[idx] = tmr10ms;
           }
           else {
             if (sid.background == LUA_NOREF) continue;
-            lua_rawgeti(lsScripts, LUA_REGISTRYINDEX, sid.background);
+            lua_rawgeti(co, LUA_REGISTRYINDEX, sid.background);
           }
         }
 #if defined(PCBTARANIS)
         else if (ref <= SCRIPT_TELEMETRY_LAST) {
           if (sid.background == LUA_NOREF) continue;
-          lua_rawgeti(lsScripts, LUA_REGISTRYINDEX, sid.background);
+          lua_rawgeti(co, LUA_REGISTRYINDEX, sid.background);
         }
 #endif
         else continue;
       }
+
+      sid.threadLcd = allowLcdUsage;
+      sid.stats.callInstructions = 0;
+      sid.stats.callTime = 0;
+      sid.stats.callMemory = 0;
     }
     
     // Full garbage collection at the start of every cycle
     luaDoGc(lsScripts, fullGC);
     fullGC = false;
 
+    // Foreground calls are only limited by the cycle time
+    luaRunningScript = &sid;
+    luaRunningBudget = (luaLcdAllowed ? 0 : luaScriptBudgets[luaGetScriptClass(ref)]);
+    sid.stats.sliceInstructions = 0;
+    LuaTimeMark start;
+    luaTimeMark(start);
+    int32_t memUsed = luaGetMemUsed(lsScripts);
+
     // Resume running the coroutine
-    luaStatus = lua_resume(lsScripts, 0, inputsCount);
+    int luaStatus = lua_resume(co, 0, inputsCount);
+
+    luaRunningScript = nullptr;
+    luaRunningBudget = 0;
+    sid.stats.callInstructions += sid.stats.sliceInstructions;
+    sid.stats.callTime += luaElapsedUs(start);
+    sid.stats.callMemory += (int32_t)luaGetMemUsed(lsScripts) - memUsed;
 
     if (luaStatus == LUA_YIELD) {
-      // Coroutine yielded - wait for the next cycle
-      return scriptWasRun;
+      sid.stats.preemptions++;
+      if (luaCycleTimeout) {
+        // Coroutine ran out of time - the next cycle starts with the following script
+        nextIdx = (idx < mixCount ? startIdx : idx - mixCount + 1);
+        return scriptWasRun;
+      }
+      // Budget spent - the call will be continued in the next cycle
+      continue;
     }
     else if (luaStatus == LUA_OK) {
       // Coroutine returned
       scriptWasRun = true;
+      luaUpdateStats(sid);
       
 #if defined(LUA_MODEL_SCRIPTS)
       if (ref <= SCRIPT_MIX_LAST) {
         ScriptInputsOutputs * sio = & scriptInputsOutputs[ref - SCRIPT_MIX_FIRST];
-        lua_settop(lsScripts, sio -> outputsCount);
+        lua_settop(co, sio -> outputsCount);
 
         for (int j = sio -> outputsCount - 1; j >= 0; j--) {
-          if (!lua_isnumber(lsScripts, -1)) {
+          if (!lua_isnumber(co, -1)) {
             sid.state = SCRIPT_SYNTAX_ERROR;
-            snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "Script %.*s: run function did not return a number\n", LEN_SCRIPT_FILENAME, getScriptName(idx));
-            luaError(lsScripts, sid.state);
+            snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "Script %.*s: run function did not return a number\n", LEN_SCRIPT_FILENAME, luaGetScriptName(idx));
+            luaError(co, sid.state);
             break;
           }
-          sio -> outputs[j].value = lua_tointeger(lsScripts, -1);
-          lua_pop(lsScripts, 1);
+          sio -> outputs[j].value = lua_tointeger(co, -1);
+          lua_pop(co, 1);
         }
       } else
 #endif
       if (ref == SCRIPT_STANDALONE) {
-        lua_settop(lsScripts, 1);
-        if (lua_isnumber(lsScripts, -1)) {
-          int scriptResult = lua_tointeger(lsScripts, -1);
-          lua_pop(lsScripts, 1);  /* pop returned value */
+        lua_settop(co, 1);
+        if (lua_isnumber(co, -1)) {
+          int scriptResult = lua_tointeger(co, -1);
+          lua_pop(co, 1);  /* pop returned value */
          
           if (scriptResult != 0) {
             TRACE("Script finished with status %d", scriptResult);
@@ -1172,9 +1319,9 @@ static bool resumeLua(bool init, bool allowLcdUsage)
   #endif
           }
         }
-        else if (lua_isstring(lsScripts, -1)) {
+        else if (lua_isstring(co, -1)) {
           char nextScript[FF_MAX_LFN+1];
-          strncpy(nextScript, lua_tostring(lsScripts, -1), FF_MAX_LFN);
+          strncpy(nextScript, lua_tostring(co, -1), FF_MAX_LFN);
           nextScript[FF_MAX_LFN] = '\0';
           luaExec(nextScript);
           return scriptWasRun;
@@ -1182,7 +1329,7 @@ static bool resumeLua(bool init, bool allowLcdUsage)
         else {
           sid.state = SCRIPT_SYNTAX_ERROR;
           snprintf(lua_warning_info, LUA_WARNING_INFO_LEN, "Script run function returned unexpected value\n");
-          luaError(lsScripts, sid.state);
+          luaError(co, sid.state);
         }
        
         if (evt.event == EVT_KEY_LONG(KEY_EXIT)) {
@@ -1204,11 +1351,9 @@ static bool resumeLua(bool init, bool allowLcdUsage)
     else {
       // Error
       sid.state = SCRIPT_SYNTAX_ERROR;
-      luaError(lsScripts, sid.state);
+      luaError(co, sid.state);
 
-      // Replace the dead coroutine with a new one
-      lua_pop(L, 1);  // Pop the dead coroutine off the main stack
-      lsScripts = lua_newthread(L);  // Push the new coroutine
+      // Drop the dead coroutine with the script
       luaFree(lsScripts, sid);
       luaDoGc(lsScripts, true);
     }
@@ -1216,8 +1361,8 @@ static bool resumeLua(bool init, bool allowLcdUsage)
     scriptWasRun = true;
   } // for
  
-  // Start a new cycle
-  idx = 0;
+  // Start a new cycle, with the next script first
+  nextIdx = startIdx + 1;
  
   return scriptWasRun;
 } //resumeLua(...)
@@ -1297,6 +1442,11 @@ void luaInit()
   luaClose(&lsScripts);
   L = nullptr;
 
+#if defined(LUA_COMPILER)
+  // all scripts are looked up in the same index
+  luaCacheLoad();
+#endif
+
   if (luaState != INTERPRETER_PANIC) {
 #if defined(USE_BIN_ALLOCATOR)
     L = lua_newstate(bin_l_alloc, nullptr);   //we use our own allocator!
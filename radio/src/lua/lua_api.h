@@ -43,7 +43,7 @@ extern "C" {
   #if !defined(LUA_COMPILER) || defined(SIMU) || defined(DEBUG)
     #define LUA_SCRIPT_LOAD_MODE    "T"   // prefer loading .lua source file for full debug info
   #else
-    #define LUA_SCRIPT_LOAD_MODE    "bt"  // binary or text, whichever is newer
+    #define LUA_SCRIPT_LOAD_MODE    "bt"  // cached binary if it matches the text version, or text
   #endif
 #endif
 
@@ -88,6 +88,12 @@ LcdFlags flagsRGB(LcdFlags flags);
 extern lua_State* lsWidgets;
 extern uint32_t luaExtraMemoryUsage;
 void luaInitThemesAndWidgets();
+
+// called by the functions reading radio values with their results on
+// the stack, recorded by the retained Lua widgets (see lua_draw_list.h)
+int luaRecordInput(lua_State * L, lua_CFunction function, int nresults);
+#else
+#define luaRecordInput(L, function, nresults)  (nresults)
 #endif
 
 void luaInit();
@@ -158,12 +164,63 @@ enum ScriptReference {
   SCRIPT_STANDALONE                                              // Standalone script
 };
 
+enum LuaScriptClass {
+  LUA_CLASS_MIX,
+  LUA_CLASS_FUNCTION,
+  LUA_CLASS_TELEMETRY,
+  LUA_CLASS_STANDALONE,
+  LUA_CLASS_WIDGET,
+  LUA_CLASS_COUNT
+};
+
+// Number of instructions a script may run in one slice before it yields
+// to the next script (0 = only limited by LUA_TASK_PERIOD_TICKS). Widgets
+// are not preempted: a widget call running over its budget is aborted.
+#if !defined(LUA_BUDGET_MIX)
+  #define LUA_BUDGET_MIX                   5000
+#endif
+#if !defined(LUA_BUDGET_FUNCTION)
+  #define LUA_BUDGET_FUNCTION              5000
+#endif
+#if !defined(LUA_BUDGET_TELEMETRY)
+  #define LUA_BUDGET_TELEMETRY            10000
+#endif
+#if !defined(LUA_BUDGET_STANDALONE)
+  #define LUA_BUDGET_STANDALONE               0
+#endif
+#if !defined(LUA_BUDGET_WIDGET)
+  #define LUA_BUDGET_WIDGET               20000
+#endif
+
+extern const uint16_t luaScriptBudgets[LUA_CLASS_COUNT];
+
+// A call (run or background function) may span several slices
+struct LuaScriptStats {
+  uint32_t runs;              // completed calls
+  uint32_t preemptions;       // slices ended by a yield
+  uint32_t instructions;      // last completed call
+  uint32_t maxInstructions;
+  uint32_t time;              // us, last completed call
+  uint32_t maxTime;
+  int32_t memory;             // bytes allocated (net) by the last completed call
+  int32_t maxMemory;
+  // current call
+  uint32_t callInstructions;
+  uint32_t callTime;
+  int32_t callMemory;
+  uint32_t sliceInstructions;
+};
+
 struct ScriptInternalData {
   uint8_t reference;
   uint8_t state;
   int run;
   int background;
-  uint8_t instructions;
+  uint8_t instructions;       // % of the budget used by the last call
+  lua_State * thread;         // coroutine running the calls, created on the first one
+  int threadRef;
+  bool threadLcd;             // the coroutine yielded while allowed to use the LCD
+  LuaScriptStats stats;
 };
 
 struct ScriptInputsOutputs {
@@ -198,6 +255,9 @@ uint32_t luaGetMemUsed(lua_State * L);
 void luaGetValueAndPush(lua_State * L, int src);
 bool isTelemetryScriptAvailable();
 
+uint8_t luaGetScriptClass(uint8_t reference);
+const char * luaGetScriptName(uint8_t idx);
+
 #define luaGetCpuUsed(idx) scriptInternalData[idx].instructions
 #define LUA_LOAD_MODEL_SCRIPTS()   luaState = INTERPRETER_RELOAD_PERMANENT_SCRIPTS
 #define LUA_LOAD_MODEL_SCRIPT(idx) luaState = INTERPRETER_RELOAD_PERMANENT_SCRIPTS
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "opentx.h"
+#include "lua_cache.h"
+
+#if defined(LUA_COMPILER)
+
+PACK(struct LuaCacheHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t count;
+  uint16_t crc;     // crc16 of the entries
+});
+
+static LuaCacheKey luaCacheEntries[LUA_CACHE_MAX_ENTRIES];
+static uint8_t luaCacheCount = 0;
+static bool luaCacheLoaded = false;
+static bool luaCacheDirty = false;
+
+void luaCacheLoad()
+{
+  if (luaCacheLoaded)
+    return;
+
+  luaCacheLoaded = true;
+  luaCacheCount = 0;
+
+  FIL file;
+  if (f_open(&file, LUA_CACHE_INDEX_PATH, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    return;
+
+  LuaCacheHeader header;
+  UINT read;
+  if (f_read(&file, &header, sizeof(header), &read) == FR_OK &&
+      read == sizeof(header) &&
+      !memcmp(header.magic, LUA_CACHE_MAGIC, sizeof(header.magic)) &&
+      header.version == LUA_CACHE_VERSION &&
+      header.count <= LUA_CACHE_MAX_ENTRIES) {
+    UINT size = header.count * sizeof(LuaCacheKey);
+    if (f_read(&file, luaCacheEntries, size, &read) == FR_OK && read == size &&
+        crc16(CRC_1021, (const uint8_t *)luaCacheEntries, size) == header.crc) {
+      luaCacheCount = header.count;
+    }
+  }
+  f_close(&file);
+
+  TRACE("luaCacheLoad: %d entries", luaCacheCount);
+}
+
+void luaCacheSave()
+{
+  if (!luaCacheDirty)
+    return;
+
+  FIL file;
+  FRESULT result = f_open(&file, LUA_CACHE_INDEX_PATH, FA_CREATE_ALWAYS | FA_WRITE);
+  if (result != FR_OK) {
+    TRACE_ERROR("luaCacheSave: error %d\n", result);
+    return;
+  }
+
+  LuaCacheHeader header;
+  UINT size = luaCacheCount * sizeof(LuaCacheKey);
+  memcpy(header.magic, LUA_CACHE_MAGIC, sizeof(header.magic));
+  header.version = LUA_CACHE_VERSION;
+  header.count = luaCacheCount;
+  header.crc = crc16(CRC_1021, (const uint8_t *)luaCacheEntries, size);
+
+  UINT written;
+  result = f_write(&file, &header, sizeof(header), &written);
+  if (result == FR_OK)
+    result = f_write(&file, luaCacheEntries, size, &written);
+  f_close(&file);
+
+  if (result == FR_OK)
+    luaCacheDirty = false;
+}
+
+static bool luaCacheGetCrc(const char * source, uint16_t & crc)
+{
+  FIL file;
+  if (f_open(&file, source, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    return false;
+
+  uint8_t buffer[256];
+  UINT read;
+  FRESULT result;
+  crc = 0;
+  while ((result = f_read(&file, buffer, sizeof(buffer), &read)) == FR_OK && read > 0) {
+    crc = crc16(CRC_1021, buffer, read, crc);
+  }
+  f_close(&file);
+
+  return result == FR_OK;
+}
+
+void luaCacheGetKey(const char * source, const FILINFO & fno, LuaCacheKey & key)
+{
+  // two different polynomials give a 32 bits path hash
+  uint32_t len = strlen(source);
+  key.path = (crc16(CRC_1021, (const uint8_t *)source, len) << 16) +
+             crc16(CRC_1189, (const uint8_t *)source, len);
+  key.size = fno.fsize;
+  key.date = ((uint32_t)fno.fdate << 16) + fno.ftime;
+  key.crc = 0;
+  key.spare = 0;
+}
+
+void luaCacheGetFilename(const LuaCacheKey & key, char * filename)
+{
+  char * s = strAppend(filename, SCRIPTS_CACHE_PATH PATH_SEPARATOR);
+  // strAppendUnsigned() works on signed values
+  s = strAppendUnsigned(s, key.path >> 16, 4, 16);
+  s = strAppendUnsigned(s, key.path & 0xFFFF, 4, 16);
+  strAppend(s, SCRIPT_BIN_EXT);
+}
+
+static int luaCacheIndex(uint32_t path)
+{
+  for (int i = 0; i < luaCacheCount; i++) {
+    if (luaCacheEntries[i].path == path)
+      return i;
+  }
+  return -1;
+}
+
+bool luaCacheFind(const char * source, const LuaCacheKey & key)
+{
+  int i = luaCacheIndex(key.path);
+  if (i < 0)
+    return false;
+
+  LuaCacheKey & entry = luaCacheEntries[i];
+  if (entry.size != key.size)
+    return false;
+  if (entry.date == key.date)
+    return true;
+
+  // same size but another date, compare the content
+  uint16_t crc;
+  if (!luaCacheGetCrc(source, crc) || crc != entry.crc)
+    return false;
+
+  entry.date = key.date;
+  luaCacheDirty = true;
+  return true;
+}
+
+static void luaCacheDelete(int i)
+{
+  memmove(&luaCacheEntries[i], &luaCacheEntries[i + 1],
+          (luaCacheCount - i - 1) * sizeof(LuaCacheKey));
+  luaCacheCount--;
+  luaCacheDirty = true;
+}
+
+bool luaCacheAdd(const char * source, LuaCacheKey & key)
+{
+  uint16_t crc;
+  if (!luaCacheGetCrc(source, crc)) {
+    luaCacheRemove(key);
+    return false;
+  }
+  key.crc = crc;
+
+  // the compiled chunk of an older version of the same script
+  // has been overwritten, only its entry needs to be replaced
+  int i = luaCacheIndex(key.path);
+  if (i >= 0) {
+    luaCacheDelete(i);
+  }
+  else if (luaCacheCount == LUA_CACHE_MAX_ENTRIES) {
+    // drop the oldest script
+    char filename[LUA_CACHE_FILENAME_LEN];
+    luaCacheGetFilename(luaCacheEntries[0], filename);
+    f_unlink(filename);
+    luaCacheDelete(0);
+  }
+
+  luaCacheEntries[luaCacheCount++] = key;
+  luaCacheDirty = true;
+  return true;
+}
+
+void luaCacheRemove(const LuaCacheKey & key)
+{
+  int i = luaCacheIndex(key.path);
+  if (i >= 0) {
+    luaCacheDelete(i);
+  }
+}
+
+#endif // LUA_COMPILER
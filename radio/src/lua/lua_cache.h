@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include "definitions.h"
+#include "sdcard.h"
+
+// Compiled scripts are stored in SCRIPTS_CACHE_PATH, one file per script
+// path, and listed in an index of (path, size, date, crc) keys. A compiled
+// chunk is used when the size and date of the source file still match,
+// which only needs a f_stat(). When only the date differs (the card was
+// copied, which does not preserve timestamps), the crc of the source is
+// compared instead and the entry gets the new date.
+
+#define LUA_CACHE_INDEX_PATH    SCRIPTS_CACHE_PATH PATH_SEPARATOR "index.bin"
+#define LUA_CACHE_MAGIC         "ELBC"
+#define LUA_CACHE_VERSION       2
+
+#if defined(COLORLCD)
+  #define LUA_CACHE_MAX_ENTRIES 64
+#else
+  #define LUA_CACHE_MAX_ENTRIES 32
+#endif
+
+// SCRIPTS_CACHE_PATH "/XXXXXXXX.luac"
+#define LUA_CACHE_FILENAME_LEN  (sizeof(SCRIPTS_CACHE_PATH) + 14)
+
+PACK(struct LuaCacheKey {
+  uint32_t path;    // hash of the source path
+  uint32_t size;    // source size
+  uint32_t date;    // source fdate / ftime
+  uint16_t crc;     // source crc16
+  uint16_t spare;
+});
+
+// Read the index from the SD card, only done once
+void luaCacheLoad();
+
+// Write the index back if entries were added or removed
+void luaCacheSave();
+
+// Fill the key of a source file from its directory entry (no crc)
+void luaCacheGetKey(const char * source, const FILINFO & fno, LuaCacheKey & key);
+
+// Full path of the compiled chunk for a key
+void luaCacheGetFilename(const LuaCacheKey & key, char * filename);
+
+// True if the compiled chunk matches the source, the source is only
+// read when its date changed
+bool luaCacheFind(const char * source, const LuaCacheKey & key);
+
+// Add the key once the source has been compiled, false if it cannot be read
+bool luaCacheAdd(const char * source, LuaCacheKey & key);
+void luaCacheRemove(const LuaCacheKey & key);
@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "opentx.h"
+#include "lua_draw_list.h"
+
+LuaDrawList * luaDrawRecorder = nullptr;
+
+enum LuaValueType : uint8_t {
+  VALUE_NIL,
+  VALUE_FALSE,
+  VALUE_TRUE,
+  VALUE_NUMBER,
+  VALUE_STRING,
+  VALUE_REF,
+  VALUE_TABLE,
+};
+
+enum LuaValueMode : uint8_t {
+  MODE_DRAW_ARG,    // bitmaps and long strings referenced
+  MODE_INPUT_ARG,   // copied
+  MODE_RESULT,      // copied, tables of values allowed
+};
+
+static bool writeBytes(std::vector<uint8_t> & out, const void * bytes,
+                       size_t size)
+{
+  if (out.size() + size > LUA_DRAW_LIST_MAX_SIZE) return false;
+  auto p = (const uint8_t *)bytes;
+  out.insert(out.end(), p, p + size);
+  return true;
+}
+
+static bool writeType(std::vector<uint8_t> & out, LuaValueType type)
+{
+  uint8_t value = type;
+  return writeBytes(out, &value, 1);
+}
+
+static bool writeValue(lua_State * L, int index, uint8_t mode,
+                       std::vector<uint8_t> & out, std::vector<int> & refs,
+                       uint8_t & refCount)
+{
+  index = lua_absindex(L, index);
+
+  switch (lua_type(L, index)) {
+    case LUA_TNIL:
+      return writeType(out, VALUE_NIL);
+
+    case LUA_TBOOLEAN:
+      return writeType(out, lua_toboolean(L, index) ? VALUE_TRUE : VALUE_FALSE);
+
+    case LUA_TNUMBER: {
+      lua_Number value = lua_tonumber(L, index);
+      return writeType(out, VALUE_NUMBER) && writeBytes(out, &value, sizeof(value));
+    }
+
+    case LUA_TSTRING: {
+      size_t len;
+      const char * s = lua_tolstring(L, index, &len);
+      if (mode != MODE_DRAW_ARG || len <= LUA_DRAW_LIST_INLINE_STRING) {
+        if (len > UINT16_MAX) return false;
+        uint16_t size = len;
+        return writeType(out, VALUE_STRING) &&
+               writeBytes(out, &size, sizeof(size)) && writeBytes(out, s, len);
+      }
+      break;
+    }
+
+    case LUA_TUSERDATA:
+      break;
+
+    case LUA_TTABLE:
+      if (mode != MODE_RESULT) return false;
+      if (!writeType(out, VALUE_TABLE)) return false;
+      for (lua_pushnil(L); lua_next(L, index); lua_pop(L, 1)) {
+        // one level only
+        if (lua_type(L, -2) == LUA_TTABLE || lua_type(L, -1) == LUA_TTABLE ||
+            !writeValue(L, -2, mode, out, refs, refCount) ||
+            !writeValue(L, -1, mode, out, refs, refCount)) {
+          lua_pop(L, 2);
+          return false;
+        }
+      }
+      return writeType(out, VALUE_NIL);
+
+    default:
+      return false;
+  }
+
+  // bitmaps and long strings: kept referenced, compared by identity
+  if (mode != MODE_DRAW_ARG) return false;
+  const void * ptr = lua_topointer(L, index);
+  if (!writeType(out, VALUE_REF) || !writeBytes(out, &ptr, sizeof(ptr)))
+    return false;
+  lua_pushvalue(L, index);
+  refs.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+  refCount += 1;
+  return true;
+}
+
+static void rectUnion(rect_t & rect, const rect_t & other)
+{
+  coord_t left = min(rect.left(), other.left());
+  coord_t top = min(rect.top(), other.top());
+  coord_t right = max(rect.right(), other.right());
+  coord_t bottom = max(rect.bottom(), other.bottom());
+  rect = {left, top, right - left, bottom - top};
+}
+
+static bool rectIntersects(const rect_t & rect, const rect_t & other)
+{
+  return rect.left() < other.right() && other.left() < rect.right() &&
+         rect.top() < other.bottom() && other.top() < rect.bottom();
+}
+
+void LuaDrawList::startRecording()
+{
+  recordTime = RTOS_GET_MS();
+  luaDrawRecorder = this;
+}
+
+bool LuaDrawList::stopRecording()
+{
+  luaDrawRecorder = nullptr;
+  valid = !failed;
+  return valid;
+}
+
+bool LuaDrawList::recordCall(lua_State * L, Call & call,
+                             lua_CFunction function, int argc, uint8_t mode)
+{
+  call.function = function;
+  call.args = data.size();
+  call.argc = argc;
+  call.refs = 0;
+
+  for (int i = 1; i <= argc; i++) {
+    if (!writeValue(L, i, mode, data, refs, call.refs)) {
+      failed = true;
+      return false;
+    }
+  }
+
+  call.size = data.size() - call.args;
+  return true;
+}
+
+int LuaDrawList::recordDraw(lua_State * L, lua_CFunction function,
+                            const rect_t & bounds, bool blink)
+{
+  if (failed) return 0;
+
+  Draw draw;
+  if (recordCall(L, draw, function, lua_gettop(L), MODE_DRAW_ARG)) {
+    draw.bounds = bounds;
+    draw.blink = blink;
+    draws.push_back(draw);
+    if (blink) blinking = true;
+  }
+
+  return 0;
+}
+
+void LuaDrawList::recordInput(lua_State * L, lua_CFunction function,
+                              int nresults)
+{
+  if (failed) return;
+
+  int top = lua_gettop(L);
+  Input input;
+  if (!recordCall(L, input, function, top - nresults, MODE_INPUT_ARG))
+    return;
+
+  // the same value read several times
+  for (const auto & other : inputs) {
+    if (sameCall(input, *this, other)) {
+      data.resize(input.args);
+      return;
+    }
+  }
+
+  input.results = data.size();
+  uint8_t refCount = 0;
+  for (int i = top - nresults + 1; i <= top; i++) {
+    if (!writeValue(L, i, MODE_RESULT, data, refs, refCount)) {
+      failed = true;
+      return;
+    }
+  }
+  input.resultsSize = data.size() - input.results;
+
+  inputs.push_back(input);
+}
+
+bool LuaDrawList::isExpired() const
+{
+  return RTOS_GET_MS() - recordTime >= LUA_DRAW_LIST_TIMEOUT;
+}
+
+bool LuaDrawList::sameCall(const Call & call, const LuaDrawList & other,
+                           const Call & otherCall) const
+{
+  return call.function == otherCall.function && call.argc == otherCall.argc &&
+         call.size == otherCall.size &&
+         !memcmp(data.data() + call.args, other.data.data() + otherCall.args,
+                 call.size);
+}
+
+int LuaDrawList::pushArgs(lua_State * L, const Call & call, int ref) const
+{
+  luaL_checkstack(L, call.argc, nullptr);
+
+  const uint8_t * p = data.data() + call.args;
+  for (uint8_t i = 0; i < call.argc; i++) {
+    switch (*p++) {
+      case VALUE_NIL:
+        lua_pushnil(L);
+        break;
+
+      case VALUE_FALSE:
+      case VALUE_TRUE:
+        lua_pushboolean(L, p[-1] == VALUE_TRUE);
+        break;
+
+      case VALUE_NUMBER: {
+        lua_Number value;
+        memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        lua_pushnumber(L, value);
+        break;
+      }
+
+      case VALUE_STRING: {
+        uint16_t size;
+        memcpy(&size, p, sizeof(size));
+        p += sizeof(size);
+        lua_pushlstring(L, (const char *)p, size);
+        p += size;
+        break;
+      }
+
+      case VALUE_REF:
+        p += sizeof(void *);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, refs[ref++]);
+        break;
+    }
+  }
+
+  return ref;
+}
+
+int LuaDrawList::protectedReplay(lua_State * L)
+{
+  auto list = (const LuaDrawList *)lua_touserdata(L, 1);
+
+  int ref = 0;
+  for (const auto & draw : list->draws) {
+    lua_pushcfunction(L, draw.function);
+    ref = list->pushArgs(L, draw, ref);
+    lua_call(L, draw.argc, 0);
+  }
+
+  return 0;
+}
+
+bool LuaDrawList::replay(lua_State * L) const
+{
+  lua_pushcfunction(L, protectedReplay);
+  lua_pushlightuserdata(L, (void *)this);
+  return lua_pcall(L, 1, 0, 0) == 0;
+}
+
+bool LuaDrawList::checkInputs(lua_State * L) const
+{
+  std::vector<uint8_t> results;
+  std::vector<int> noRefs;
+
+  for (const auto & input : inputs) {
+    int top = lua_gettop(L);
+    lua_pushcfunction(L, input.function);
+    pushArgs(L, input, 0);
+    lua_call(L, input.argc, LUA_MULTRET);
+
+    results.clear();
+    bool same = true;
+    uint8_t refCount = 0;
+    for (int i = top + 1; same && i <= lua_gettop(L); i++) {
+      same = writeValue(L, i, MODE_RESULT, results, noRefs, refCount);
+    }
+    lua_settop(L, top);
+
+    if (!same || results.size() != input.resultsSize ||
+        memcmp(results.data(), data.data() + input.results, input.resultsSize))
+      return true;
+  }
+
+  return false;
+}
+
+int LuaDrawList::protectedInputsChanged(lua_State * L)
+{
+  auto list = (const LuaDrawList *)lua_touserdata(L, 1);
+  lua_pushboolean(L, list->checkInputs(L));
+  return 1;
+}
+
+bool LuaDrawList::inputsChanged(lua_State * L) const
+{
+  lua_pushcfunction(L, protectedInputsChanged);
+  lua_pushlightuserdata(L, (void *)this);
+  if (lua_pcall(L, 1, 1, 0) != 0) {
+    // record again, the error will be raised by refresh()
+    lua_pop(L, 1);
+    return true;
+  }
+
+  bool changed = lua_toboolean(L, -1);
+  lua_pop(L, 1);
+  return changed;
+}
+
+void LuaDrawList::diff(const LuaDrawList & previous,
+                       std::function<void(const rect_t &)> invalidate) const
+{
+  rect_t rects[LUA_DRAW_LIST_MAX_RECTS];
+  uint8_t count = 0;
+
+  auto add = [&](const rect_t & rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    for (uint8_t i = 0; i < count; i++) {
+      if (rectIntersects(rects[i], rect)) {
+        rectUnion(rects[i], rect);
+        return;
+      }
+    }
+    if (count < LUA_DRAW_LIST_MAX_RECTS) {
+      rects[count++] = rect;
+    } else {
+      // too many small areas: a single one covering them
+      for (uint8_t i = 1; i < count; i++) rectUnion(rects[0], rects[i]);
+      rectUnion(rects[0], rect);
+      count = 1;
+    }
+  };
+
+  size_t size = max(draws.size(), previous.draws.size());
+  for (size_t i = 0; i < size; i++) {
+    const Draw * draw = i < draws.size() ? &draws[i] : nullptr;
+    const Draw * old = i < previous.draws.size() ? &previous.draws[i] : nullptr;
+    if (draw && old && sameCall(*draw, previous, *old)) continue;
+    if (draw) add(draw->bounds);
+    if (old) add(old->bounds);
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    invalidate(rects[i]);
+  }
+}
+
+void LuaDrawList::forEachBlinkingDraw(
+    std::function<void(const rect_t &)> invalidate) const
+{
+  for (const auto & draw : draws) {
+    if (draw.blink) invalidate(draw.bounds);
+  }
+}
+
+void LuaDrawList::clear(lua_State * L)
+{
+  if (L) {
+    for (auto ref : refs) {
+      luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    }
+  }
+
+  draws.clear();
+  inputs.clear();
+  data.clear();
+  refs.clear();
+  valid = false;
+  failed = false;
+  blinking = false;
+}
+
+int luaRecordInput(lua_State * L, lua_CFunction function, int nresults)
+{
+  if (luaDrawRecorder) {
+    luaDrawRecorder->recordInput(L, function, nresults);
+  }
+  return nresults;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include <functional>
+#include <vector>
+
+#include "libopenui_types.h"
+#include "lua_api.h"
+
+// Retained mode of the Lua widgets declaring 'retained = true'.
+//
+// While recording, the lcd.* functions called by the widget refresh() are
+// stored with their arguments instead of drawing, as well as the calls
+// reading radio values (getValue(), getTime(), ...) with their results.
+// The list is then replayed into the widget buffer without running Lua,
+// until one of these calls returns a different result: refresh() is then
+// recorded again and only the bounds of the drawings which changed are
+// invalidated.
+//
+// Bitmaps and long strings are kept referenced by the list and compared
+// by identity, other arguments are copied.
+
+#define LUA_DRAW_LIST_MAX_SIZE        4096  // arguments and results, bytes
+#define LUA_DRAW_LIST_MAX_RECTS       4     // invalidated per update
+#define LUA_DRAW_LIST_INLINE_STRING   32
+// values read through other functions are not tracked: refresh() is
+// recorded again after this delay
+#define LUA_DRAW_LIST_TIMEOUT         1000  // ms
+
+// bounds of a drawing not known in advance (lcd.clear(), ...)
+#define LUA_DRAW_ANYWHERE  rect_t{-LCD_W, -LCD_H, 3 * LCD_W, 3 * LCD_H}
+
+class LuaDrawList
+{
+  public:
+    // recording the calls made by refresh()
+    void startRecording();
+    // false if a call could not be recorded
+    bool stopRecording();
+
+    int recordDraw(lua_State * L, lua_CFunction function,
+                   const rect_t & bounds, bool blink = false);
+    void recordInput(lua_State * L, lua_CFunction function, int nresults);
+
+    bool isValid() const { return valid; }
+    bool isExpired() const;
+    bool hasBlinkingDraws() const { return blinking; }
+
+    // calls the recorded inputs again, true if one result differs
+    bool inputsChanged(lua_State * L) const;
+
+    // draws into luaLcdBuffer, false on error (message on the stack)
+    bool replay(lua_State * L) const;
+
+    // rectangles covering the drawings which differ from the previous list
+    void diff(const LuaDrawList & previous,
+              std::function<void(const rect_t &)> invalidate) const;
+
+    // bounds of the drawings depending on the blink phase
+    void forEachBlinkingDraw(std::function<void(const rect_t &)> invalidate) const;
+
+    void clear(lua_State * L);
+
+  protected:
+    struct Call {
+      lua_CFunction function;
+      uint16_t args;         // offset in data
+      uint16_t size;         // arguments size
+      uint8_t argc;
+      uint8_t refs;          // number of referenced arguments
+    };
+
+    struct Draw: public Call {
+      rect_t bounds;
+      bool blink;
+    };
+
+    struct Input: public Call {
+      uint16_t results;      // offset in data
+      uint16_t resultsSize;
+    };
+
+    std::vector<Draw> draws;
+    std::vector<Input> inputs;
+    std::vector<uint8_t> data;
+    std::vector<int> refs;
+    uint32_t recordTime = 0;
+    bool valid = false;
+    bool failed = false;
+    bool blinking = false;
+
+    bool recordCall(lua_State * L, Call & call, lua_CFunction function,
+                    int argc, uint8_t mode);
+    bool sameCall(const Call & call, const LuaDrawList & other,
+                  const Call & otherCall) const;
+    int pushArgs(lua_State * L, const Call & call, int ref) const;
+    bool checkInputs(lua_State * L) const;
+
+    static int protectedReplay(lua_State * L);
+    static int protectedInputsChanged(lua_State * L);
+};
+
+// the list being recorded, nullptr when not recording
+extern LuaDrawList * luaDrawRecorder;
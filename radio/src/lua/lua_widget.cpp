@@ -26,7 +26,7 @@
 #include "lua_event.h"
 #include "draw_functions.h"
 
-#define MAX_INSTRUCTIONS       (20000/100)
+#define MAX_INSTRUCTIONS       (luaScriptBudgets[LUA_CLASS_WIDGET]/100)
 
 #if defined(HARDWARE_TOUCH)
 uint32_t LuaEventHandler::downTime = 0;
@@ -200,12 +200,14 @@ LuaWidget::LuaWidget(const WidgetFactory* factory, Window* parent,
     Widget(factory, parent, rect, persistentData),
     luaWidgetDataRef(luaWidgetDataRef),
     zoneRectDataRef(zoneRectDataRef),
-    errorMessage(nullptr)
+    errorMessage(nullptr),
+    retained(((LuaWidgetFactory*)factory)->retained)
 {
 }
 
 LuaWidget::~LuaWidget()
 {
+  drawList.clear(lsWidgets);
   luaL_unref(lsWidgets, LUA_REGISTRYINDEX, luaWidgetDataRef);
   luaL_unref(lsWidgets, LUA_REGISTRYINDEX, zoneRectDataRef);
   free(errorMessage);
@@ -235,6 +237,14 @@ void LuaWidget::checkEvents()
 {
   Widget::checkEvents();
 
+  if (isRetained()) {
+    if (lv_obj_is_visible(lvobj))
+      updateDrawList();
+    else
+      background();
+    return;
+  }
+
   // paint has not been called
   if (!refreshed) {
     background();
@@ -288,6 +298,9 @@ void LuaWidget::update()
   if (lua_pcall(lsWidgets, 2, 0, 0) != 0) {
     setErrorMessage("update()");
   }
+
+  // options or zone changed: record again
+  resetDrawList();
 }
 
 // Update table on top of Lua stack - set entry with name 'idx' to value 'val'
@@ -339,6 +352,9 @@ void LuaWidget::updateZoneRect(rect_t rect)
 
 void LuaWidget::onFullscreen(bool enable)
 {
+  // fullscreen widgets receive events: refresh() is always called
+  resetDrawList();
+
   if (enable) {
     setupHandler(this);
   } else {
@@ -378,6 +394,33 @@ void LuaWidget::refresh(BitmapBuffer* dc)
     return;
   }
 
+  // Enable drawing into the current LCD buffer
+  luaLcdBuffer = dc;
+
+  if (isRetained() && drawList.isValid()) {
+    bool lla = luaLcdAllowed;
+    luaLcdAllowed = true;
+    runningFS = this;
+
+    if (!drawList.replay(lsWidgets)) {
+      setErrorMessage("refresh()");
+    }
+
+    runningFS = nullptr;
+    luaLcdAllowed = lla;
+  } else {
+    callRefresh();
+  }
+
+  // Remove LCD
+  luaLcdBuffer = nullptr;
+
+  // mark as refreshed
+  refreshed = true;
+}
+
+void LuaWidget::callRefresh()
+{
   luaSetInstructionsLimit(lsWidgets, MAX_INSTRUCTIONS);
   LuaWidgetFactory * factory = (LuaWidgetFactory *)this->factory;
   lua_rawgeti(lsWidgets, LUA_REGISTRYINDEX, factory->refreshFunction);
@@ -400,9 +443,6 @@ void LuaWidget::refresh(BitmapBuffer* dc)
 #endif
     lua_pushnil(lsWidgets);
   
-  // Enable drawing into the current LCD buffer
-  luaLcdBuffer = dc;
-
   // This little hack is needed to not interfere with the LCD usage of preempted scripts
   bool lla = luaLcdAllowed;
   luaLcdAllowed = true;
@@ -412,12 +452,78 @@ void LuaWidget::refresh(BitmapBuffer* dc)
     setErrorMessage("refresh()");
   }
   runningFS = nullptr;
-  // Remove LCD
   luaLcdAllowed = lla;
-  luaLcdBuffer = nullptr;
+}
 
-  // mark as refreshed
-  refreshed = true;
+bool LuaWidget::isRetained() const
+{
+  return retained && !fullscreen && !errorMessage && lsWidgets;
+}
+
+// Records refresh() again when one of the values it read changed,
+// and invalidates only the drawings which differ
+void LuaWidget::updateDrawList()
+{
+  if (drawList.isValid() && !drawList.isExpired() &&
+      !drawList.inputsChanged(lsWidgets)) {
+    bool phase = BLINK_ON_PHASE != 0;
+    if (drawList.hasBlinkingDraws() && blinkPhase != phase) {
+      blinkPhase = phase;
+      drawList.forEachBlinkingDraw(
+          [=](const rect_t& rect) { invalidateArea(rect); });
+    }
+    return;
+  }
+
+  LuaDrawList previous = std::move(drawList);
+  drawList = LuaDrawList();
+
+  drawList.startRecording();
+  callRefresh();
+  bool recorded = drawList.stopRecording();
+
+  if (errorMessage) {
+    drawList.clear(lsWidgets);
+    invalidate();
+  } else if (!recorded) {
+    TRACE("Widget %s: refresh() cannot be recorded, retained mode disabled",
+          factory->getName());
+    retained = false;
+    drawList.clear(lsWidgets);
+    invalidate();
+  } else if (!previous.isValid()) {
+    invalidate();
+  } else {
+    drawList.diff(previous, [=](const rect_t& rect) { invalidateArea(rect); });
+  }
+
+  previous.clear(lsWidgets);
+}
+
+void LuaWidget::resetDrawList()
+{
+  if (drawList.isValid()) {
+    drawList.clear(lsWidgets);
+    invalidate();
+  }
+}
+
+void LuaWidget::invalidateArea(const rect_t& rect)
+{
+  // Window::invalidate() invalidates the whole object
+  coord_t x1 = max<coord_t>(rect.left(), 0);
+  coord_t y1 = max<coord_t>(rect.top(), 0);
+  coord_t x2 = min<coord_t>(rect.right(), width());
+  coord_t y2 = min<coord_t>(rect.bottom(), height());
+  if (x1 >= x2 || y1 >= y2) return;
+
+  lv_area_t area;
+  lv_obj_get_coords(lvobj, &area);
+  area.x2 = area.x1 + x2 - 1;
+  area.y2 = area.y1 + y2 - 1;
+  area.x1 += x1;
+  area.y1 += y1;
+  lv_obj_invalidate_area(lvobj, &area);
 }
 
 void LuaWidget::background()
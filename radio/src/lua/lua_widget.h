@@ -24,6 +24,7 @@
 #include "window.h"
 #include "widget.h"
 #include "lua_api.h"
+#include "lua_draw_list.h"
 
 #include "opentx_types.h"
 
@@ -64,6 +65,14 @@ class LuaWidget : public Widget, public LuaEventHandler
   char* errorMessage;
   bool refreshed = false;
 
+  // retained mode: refresh() calls recorded and replayed
+  LuaDrawList drawList;
+  // 'retained' field of the widget table, cleared when refresh() cannot be
+  // recorded (see luaLoadWidgetCallback())
+  bool retained;
+  // BLINK_ON_PHASE when the blinking drawings were last invalidated
+  bool blinkPhase = false;
+
   // Window interface
   void onClicked() override;
   void onCancel() override;
@@ -78,6 +87,14 @@ class LuaWidget : public Widget, public LuaEventHandler
   void updateZoneRect(rect_t rect) override;
   bool updateTable(const char* idx, int val);
 
+  // Calls LUA widget 'refresh' method, drawing into luaLcdBuffer
+  void callRefresh();
+
+  bool isRetained() const;
+  void updateDrawList();
+  void resetDrawList();
+  void invalidateArea(const rect_t& rect);
+
  public:
   LuaWidget(const WidgetFactory* factory, Window* parent, const rect_t& rect,
             WidgetPersistentData* persistentData, int luaWidgetDataRef, int zoneRectDataRef);
@@ -24,7 +24,7 @@
 
 #include "lua_api.h"
 
-#define MAX_INSTRUCTIONS       (20000/100)
+#define MAX_INSTRUCTIONS       (luaScriptBudgets[LUA_CLASS_WIDGET]/100)
 
 static void l_pushtableint(const char * key, int value)
 {
@@ -40,7 +40,8 @@ LuaWidgetFactory::LuaWidgetFactory(const char* name, ZoneOption* widgetOptions,
     updateFunction(0),
     refreshFunction(0),
     backgroundFunction(0),
-    translateFunction(0)
+    translateFunction(0),
+    retained(false)
 {
 }
 
@@ -45,4 +45,5 @@ class LuaWidgetFactory : public WidgetFactory
   int refreshFunction;
   int backgroundFunction;
   int translateFunction;
+  bool retained;  // retained drawing mode, see luaLoadWidgetCallback()
 };
@@ -24,6 +24,7 @@
 
 #include "opentx.h"
 #include "lua_api.h"
+#include "lua_cache.h"
 
 #include "widget.h"
 #include "libopenui_file.h"
@@ -32,7 +33,7 @@
 #include "lua_widget.h"
 #include "lua_widget_factory.h"
 
-#define MAX_INSTRUCTIONS       (20000/100)
+#define MAX_INSTRUCTIONS       (luaScriptBudgets[LUA_CLASS_WIDGET]/100)
 #define LUA_WARNING_INFO_LEN    64
 
 lua_State * lsWidgets = NULL;
@@ -212,6 +213,16 @@ ZoneOption *createOptionsArray(int reference, uint8_t maxOptions)
   return options;
 }
 
+// Fields of the table returned by a widget script:
+//  - name, options
+//  - create, update, refresh, background, translate: the widget functions
+//  - retained (optional, false by default): refresh() is only run again
+//    when a value it read changed (getValue(), getTime(), ...), or at least
+//    once per second for the values read otherwise. Its lcd.* calls are
+//    recorded and replayed in between, and only the areas whose drawings
+//    changed are redrawn. refresh() must therefore only draw through lcd.*
+//    and not rely on being run every cycle. Fullscreen widgets always run
+//    refresh().
 void luaLoadWidgetCallback()
 {
   TRACE("luaLoadWidgetCallback()");
@@ -219,6 +230,7 @@ void luaLoadWidgetCallback()
 
   int widgetOptions = 0, createFunction = 0, updateFunction = 0,
       refreshFunction = 0, backgroundFunction = 0, translateFunction = 0;
+  bool retained = false;
 
   luaL_checktype(lsWidgets, -1, LUA_TTABLE);
 
@@ -251,6 +263,9 @@ void luaLoadWidgetCallback()
       translateFunction = luaL_ref(lsWidgets, LUA_REGISTRYINDEX);
       lua_pushnil(lsWidgets);
     }
+    else if (!strcmp(key, "retained")) {
+      retained = lua_toboolean(lsWidgets, -1);
+    }
   }
 
   if (name && createFunction) {
@@ -261,6 +276,7 @@ void luaLoadWidgetCallback()
       factory->refreshFunction = refreshFunction;
       factory->backgroundFunction = backgroundFunction;   // NOSONAR
       factory->translateFunction = translateFunction;
+      factory->retained = retained;
       factory->translateOptions(options);
       TRACE("Loaded Lua widget %s", name);
     }
@@ -312,11 +328,12 @@ void luaLoadFiles(const char * directory, void (*callback)())
       res = f_readdir(&dir, &fno);                   /* Read a directory item */
       if (res != FR_OK || fno.fname[0] == 0) break;  /* Break on error or end of dir */
       uint8_t len = strlen(fno.fname);
-      if (len > 0 && (unsigned int)(len + pathlen + sizeof(LUA_WIDGET_FILENAME)) <= sizeof(path) &&
+      if (len > 0 && (unsigned int)(len + pathlen + sizeof(LUA_WIDGET_FILENAME) + 1) <= sizeof(path) &&
           fno.fname[0]!='.' && (fno.fattrib & AM_DIR)) {
         strcpy(&path[pathlen], fno.fname);
         strcat(&path[pathlen], LUA_WIDGET_FILENAME);
-        if (isFileAvailable(path)) {
+        // widgets may be shipped precompiled, without their source
+        if (isFileAvailable(path) || isFileAvailable(strcat(path, "c"))) {
           luaLoadFile(path, callback);
         }
       }
@@ -368,6 +385,9 @@ void luaInitThemesAndWidgets()
     UNPROTECT_LUA();
     TRACE("lsWidgets %p", lsWidgets);
     luaLoadFiles(WIDGETS_PATH, luaLoadWidgetCallback);
+#if defined(LUA_COMPILER)
+    luaCacheSave();
+#endif
     luaDoGc(lsWidgets, true);
   }
 }
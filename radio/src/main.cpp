@@ -32,6 +32,10 @@
   #include "cli.h"
 #endif
 
+#if defined(STORAGE_MODELSLIST)
+  #include "storage/modelslist.h"
+#endif
+
 uint8_t currentSpeakerVolume = 255;
 uint8_t requiredSpeakerVolume = 255;
 uint8_t currentBacklightBright = 0;
@@ -504,6 +508,12 @@ void perMain()
     #else
       logsWrite();         // call logsWrite the old way for simu
     #endif
+    #if defined(LOGS_BINARY)
+      logsFlush();         // write the log buffers filled by the logging tick
+    #endif
+    #if defined(STORAGE_MODELSLIST)
+      modelslist.rescanStep();  // check the models folder after a fast load
+    #endif
   }
 
   handleUsbConnection();
@@ -23,6 +23,8 @@
 #include "timers.h"
 #include "switches.h"
 
+#include <atomic>
+
 uint8_t s_mixer_first_run_done = false;
 
 int8_t  virtualInputsTrims[MAX_INPUTS];
@@ -40,6 +42,33 @@ int16_t calibratedAnalogs[NUM_CALIBRATED_ANALOGS];
 int16_t channelOutputs[MAX_OUTPUT_CHANNELS] = {0};
 int16_t ex_chans[MAX_OUTPUT_CHANNELS] = {0}; // Outputs (before LIMITS) of the last perMain;
 
+// Double buffer: the mixer fills the buffer which is not the published one
+// and then bumps the sequence. A reader copies the published buffer and
+// retries if the sequence moved meanwhile, as the mixer may then be writing
+// into the buffer being copied. Neither side ever waits for the other one.
+static ChannelsSnapshot channelsSnapshots[2];
+static std::atomic<uint32_t> channelsSequence(0);
+
+static void publishChannels()
+{
+  uint32_t sequence = channelsSequence.load(std::memory_order_relaxed) + 1;
+  ChannelsSnapshot & snapshot = channelsSnapshots[sequence & 1];
+  memcpy(snapshot.outputs, channelOutputs, sizeof(snapshot.outputs));
+  memcpy(snapshot.mixes, ex_chans, sizeof(snapshot.mixes));
+  channelsSequence.store(sequence, std::memory_order_release);
+}
+
+uint32_t getChannelsSnapshot(ChannelsSnapshot & snapshot)
+{
+  uint32_t sequence;
+  do {
+    sequence = channelsSequence.load(std::memory_order_acquire);
+    snapshot = channelsSnapshots[sequence & 1];
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while (channelsSequence.load(std::memory_order_relaxed) != sequence);
+  return sequence;
+}
+
 #if defined(HELI)
 int16_t cyc_anas[3] = {0};
 #endif
@@ -634,7 +663,200 @@ int getSourceTrimValue(int source, int stickValue=0)
 
 uint8_t mixerCurrentFlightMode;
 
-void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
+// Compiled mixer plan: indexes of the populated mix lines, in storage order
+// (which is also the destination channel order). It is rebuilt by the mixer
+// the first time it runs after mixerPlanInvalidate() has been called, so
+// that the mixer loop does not need to walk all the MAX_MIXERS slots.
+static uint8_t mixerPlan[MAX_MIXERS];
+static uint8_t mixerPlanCount = 0;
+static volatile bool mixerPlanValid = false;
+// a line reads a channel after its own: channels may need several passes
+static bool mixerPlanForwardRefs = false;
+
+void mixerPlanInvalidate()
+{
+  mixerPlanValid = false;
+}
+
+static void mixerPlanBuild()
+{
+  // set before scanning: an invalidation during the scan triggers a new build
+  mixerPlanValid = true;
+
+  uint8_t count = 0;
+  bool forwardRefs = false;
+  for (uint8_t i = 0; i < MAX_MIXERS; i++) {
+    MixData * md = mixAddress(i);
+    if (md->srcRaw) {
+      mixerPlan[count++] = i;
+      if (md->srcRaw >= MIXSRC_CH1 && md->srcRaw <= MIXSRC_LAST_CH &&
+          md->srcRaw - MIXSRC_CH1 > md->destCh)
+        forwardRefs = true;
+    }
+#if !defined(COLORLCD)
+    else
+      break; // the mixes list ends on the first empty line
+#endif
+  }
+
+  // lines not in the plan are never evaluated, so they can't be active
+  uint8_t p = 0;
+  for (uint8_t i = 0; i < MAX_MIXERS; i++) {
+    if (p < count && mixerPlan[p] == i)
+      p++;
+    else
+      swOn[i].activeMix = 0;
+  }
+
+  mixerPlanCount = count;
+  mixerPlanForwardRefs = forwardRefs;
+}
+
+// Flight modes fade: the active flight mode is evaluated first, then the
+// other fading flight modes only evaluate again the channels which may
+// differ from the active one, the others are copied from its results.
+bool mixerFadeSharing = true;
+
+static struct {
+  int16_t anas[MAX_INPUTS];
+  int16_t trims[NUM_TRIMS];
+  int8_t virtualInputsTrims[MAX_INPUTS];
+#if defined(HELI)
+  int16_t cyc_anas[3];
+#endif
+  int32_t chans[MAX_OUTPUT_CHANNELS];
+  uint8_t mixWarning;
+} fadeReference;
+
+static void fadeReferenceSave()
+{
+  memcpy(fadeReference.anas, anas, sizeof(anas));
+  memcpy(fadeReference.trims, trims, sizeof(trims));
+  memcpy(fadeReference.virtualInputsTrims, virtualInputsTrims, sizeof(virtualInputsTrims));
+#if defined(HELI)
+  memcpy(fadeReference.cyc_anas, cyc_anas, sizeof(cyc_anas));
+#endif
+  memcpy(fadeReference.chans, chans, sizeof(chans));
+  fadeReference.mixWarning = mixWarning;
+}
+
+static void fadeReferenceRestore()
+{
+  memcpy(anas, fadeReference.anas, sizeof(anas));
+  memcpy(trims, fadeReference.trims, sizeof(trims));
+  memcpy(virtualInputsTrims, fadeReference.virtualInputsTrims, sizeof(virtualInputsTrims));
+#if defined(HELI)
+  memcpy(cyc_anas, fadeReference.cyc_anas, sizeof(cyc_anas));
+#endif
+  memcpy(chans, fadeReference.chans, sizeof(chans));
+  mixWarning = fadeReference.mixWarning;
+}
+
+static bool isFadeSwitchShared(swsrc_t swtch, uint8_t fm)
+{
+  int idx = abs(swtch);
+  if ((idx >= SWSRC_FIRST_LOGICAL_SWITCH && idx <= SWSRC_LAST_LOGICAL_SWITCH) ||
+      (idx >= SWSRC_FIRST_FLIGHT_MODE && idx <= SWSRC_LAST_FLIGHT_MODE)) {
+    uint8_t current = mixerCurrentFlightMode;
+    bool value = getSwitch(swtch);
+    mixerCurrentFlightMode = fm;
+    bool shared = (getSwitch(swtch) == value);
+    mixerCurrentFlightMode = current;
+    return shared;
+  }
+  return true;
+}
+
+static bool isFadeSourceShared(mixsrc_t src, uint8_t fm)
+{
+  if (src >= MIXSRC_FIRST_INPUT && src <= MIXSRC_LAST_INPUT)
+    return anas[src - MIXSRC_FIRST_INPUT] == fadeReference.anas[src - MIXSRC_FIRST_INPUT];
+
+#if defined(HELI)
+  if (src >= MIXSRC_CYC1 && src <= MIXSRC_CYC3)
+    return cyc_anas[src - MIXSRC_CYC1] == fadeReference.cyc_anas[src - MIXSRC_CYC1];
+#endif
+
+  if ((src >= MIXSRC_FIRST_TRIM && src <= MIXSRC_LAST_TRIM) ||
+      (src >= MIXSRC_FIRST_LOGICAL_SWITCH && src <= MIXSRC_LAST_LOGICAL_SWITCH) ||
+      (src >= MIXSRC_FIRST_GVAR && src <= MIXSRC_LAST_GVAR)) {
+    uint8_t current = mixerCurrentFlightMode;
+    getvalue_t value = getValue(src);
+    mixerCurrentFlightMode = fm;
+    bool shared = (getValue(src) == value);
+    mixerCurrentFlightMode = current;
+    return shared;
+  }
+
+  return true;
+}
+
+static bool isFadeMixShared(const MixData * md, uint8_t fm, bitfield_channels_t variantChannels)
+{
+  uint8_t current = mixerCurrentFlightMode;
+
+  if (((md->flightModes >> current) ^ (md->flightModes >> fm)) & 0x01)
+    return false;
+
+  // delays only run in the active flight mode
+  if (md->delayUp || md->delayDown)
+    return false;
+
+  // flight modes evaluated before the active one read the slow value before its update
+  if ((md->speedUp || md->speedDown) && current < fm)
+    return false;
+
+  if (!isFadeSwitchShared(md->swtch, fm))
+    return false;
+
+  mixsrc_t src = md->srcRaw;
+  if (src >= MIXSRC_CH1 && src <= MIXSRC_LAST_CH) {
+    uint8_t ch = src - MIXSRC_CH1;
+    if (ch != md->destCh && (variantChannels & ((bitfield_channels_t)1 << ch)))
+      return false;
+  }
+  else if (!isFadeSourceShared(src, fm)) {
+    return false;
+  }
+
+  if (md->carryTrim == 0) {
+    int origin = getSourceTrimOrigin(src);
+    int referenceOrigin = origin;
+    if (src >= MIXSRC_FIRST_INPUT && src <= MIXSRC_LAST_INPUT)
+      referenceOrigin = fadeReference.virtualInputsTrims[src - MIXSRC_FIRST_INPUT];
+    if (origin != referenceOrigin || (origin >= 0 && trims[origin] != fadeReference.trims[origin]))
+      return false;
+  }
+
+  if (GET_GVAR_PREC1(MD_WEIGHT(md), GV_RANGELARGE_NEG, GV_RANGELARGE, current) !=
+      GET_GVAR_PREC1(MD_WEIGHT(md), GV_RANGELARGE_NEG, GV_RANGELARGE, fm))
+    return false;
+
+  if (GET_GVAR_PREC1(MD_OFFSET(md), GV_RANGELARGE_NEG, GV_RANGELARGE, current) !=
+      GET_GVAR_PREC1(MD_OFFSET(md), GV_RANGELARGE_NEG, GV_RANGELARGE, fm))
+    return false;
+
+  if ((md->curve.type == CURVE_REF_DIFF || md->curve.type == CURVE_REF_EXPO) &&
+      GET_GVAR_PREC1(md->curve.value, -100, 100, current) != GET_GVAR_PREC1(md->curve.value, -100, 100, fm))
+    return false;
+
+  return true;
+}
+
+// channels of the current flight mode which may differ from flight mode fm
+static bitfield_channels_t getFadeVariantChannels(uint8_t fm)
+{
+  bitfield_channels_t variantChannels = 0;
+  for (uint8_t p = 0; p < mixerPlanCount; p++) {
+    const MixData * md = mixAddress(mixerPlan[p]);
+    bitfield_channels_t mask = (bitfield_channels_t)1 << md->destCh;
+    if (md->srcRaw && !(variantChannels & mask) && !isFadeMixShared(md, fm, variantChannels))
+      variantChannels |= mask;
+  }
+  return variantChannels;
+}
+
+void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms, uint8_t fadeReferenceFlightMode)
 {
   evalInputs(mode);
 
@@ -709,8 +931,6 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
   }
 #endif
 
-  memclear(chans, sizeof(chans)); // all outputs to 0
-
   //========== MIXER LOOP ===============
   uint8_t lv_mixWarning = 0;
 
@@ -718,21 +938,32 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 
   bitfield_channels_t dirtyChannels = (bitfield_channels_t)-1; // all dirty when mixer starts
 
+  if (!mixerPlanValid)
+    mixerPlanBuild();
+
+  if (fadeReferenceFlightMode < MAX_FLIGHT_MODES) {
+    // start from the outputs of the active flight mode
+    memcpy(chans, fadeReference.chans, sizeof(chans));
+    dirtyChannels = getFadeVariantChannels(fadeReferenceFlightMode);
+  }
+  else {
+    memclear(chans, sizeof(chans)); // all outputs to 0
+  }
+
   do {
     bitfield_channels_t passDirtyChannels = 0;
 
-    for (uint8_t i=0; i<MAX_MIXERS; i++) {
+    for (uint8_t p=0; p<mixerPlanCount; p++) {
+      uint8_t i = mixerPlan[p];
+
       if (mode == e_perout_mode_normal && pass == 0)
         swOn[i].activeMix = 0;
 
       MixData * md = mixAddress(i);
 
+      // the line may have been cleared since the plan was built
       if (md->srcRaw == 0)
-#if defined(COLORLCD)
         continue;
-#else
-        break;
-#endif
 
       mixsrc_t stickIndex = md->srcRaw - MIXSRC_Rud;
 
@@ -979,6 +1210,22 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 
 
 
+static struct {
+  int16_t anas[MAX_INPUTS];
+  int8_t virtualInputsTrims[MAX_INPUTS];
+} fadeSavedInputs;
+
+static int32_t fadeSavedAct[MAX_MIXERS];
+
+static void fadeSwapAct()
+{
+  for (uint8_t i = 0; i < MAX_MIXERS; i++) {
+    int32_t tmp = act[i];
+    act[i] = fadeSavedAct[i];
+    fadeSavedAct[i] = tmp;
+  }
+}
+
 #define MAX_ACT 0xffff
 uint8_t lastFlightMode = 255; // TODO reinit everything here when the model changes, no???
 
@@ -1032,6 +1279,63 @@ void evalMixes(uint8_t tick10ms)
   int32_t weight = 0;
   if (flightModesFade) {
     memclear(sum_chans512, sizeof(sum_chans512));
+
+    if (!mixerPlanValid)
+      mixerPlanBuild();
+  }
+
+  if (flightModesFade && mixerFadeSharing && s_mixer_first_run_done &&
+      !mixerPlanForwardRefs && (flightModesFade & (0x01 << fm))) {
+    // The flight modes used to be evaluated in ascending order: the inputs
+    // without any active line keep the value of the previous evaluation, and
+    // the flight modes before the active one read the slow values before
+    // their update. This order is reproduced around the active flight mode.
+    uint16_t fadesBefore = flightModesFade & ((0x01 << fm) - 1);
+    bool swapAct = tick10ms && fadesBefore;
+    if (fadesBefore) {
+      memcpy(fadeSavedInputs.anas, anas, sizeof(anas));
+      memcpy(fadeSavedInputs.virtualInputsTrims, virtualInputsTrims, sizeof(virtualInputsTrims));
+      for (uint8_t p=0; p<fm; p++) {
+        if (fadesBefore & (0x01 << p)) {
+          mixerCurrentFlightMode = p;
+          evalInputs(e_perout_mode_inactive_flight_mode);
+        }
+      }
+    }
+    if (swapAct)
+      memcpy(fadeSavedAct, act, sizeof(act));
+
+    mixerCurrentFlightMode = fm;
+    evalFlightModeMixes(e_perout_mode_normal, tick10ms);
+    fadeReferenceSave();
+
+    if (fadesBefore) {
+      memcpy(anas, fadeSavedInputs.anas, sizeof(anas));
+      memcpy(virtualInputsTrims, fadeSavedInputs.virtualInputsTrims, sizeof(virtualInputsTrims));
+    }
+    if (swapAct)
+      fadeSwapAct();
+
+    for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+      if (flightModesFade & (0x01 << p)) {
+        if (p != fm) {
+          mixerCurrentFlightMode = p;
+          evalFlightModeMixes(e_perout_mode_inactive_flight_mode, 0, fm);
+        }
+        else {
+          if (swapAct)
+            fadeSwapAct();
+          fadeReferenceRestore();
+        }
+        for (uint8_t i=0; i<MAX_OUTPUT_CHANNELS; i++)
+          sum_chans512[i] += limit<int32_t>(-0x6fff, chans[i] >> 4, 0x6fff) * fp_act[p];
+        weight += fp_act[p];
+      }
+    }
+    assert(weight);
+    mixerCurrentFlightMode = fm;
+  }
+  else if (flightModesFade) {
     for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
       if (flightModesFade & (0x01 << p)) {
         mixerCurrentFlightMode = p;
@@ -1080,6 +1384,8 @@ void evalMixes(uint8_t tick10ms)
     channelOutputs[i] = value;  // copy consistent word to int-level
   }
 
+  publishChannels();
+
   if (tick10ms && flightModesFade) {
     uint16_t tick_delta = delta * tick10ms;
     for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "opentx.h"
+#include "mixer_stats.h"
+#include "mixer_scheduler.h"
+
+LatencyHistogram mixerLatency[MIXER_LATENCY_COUNT];
+
+const char * const mixerLatencyNames[MIXER_LATENCY_COUNT] = {
+  "ADC to pulses",
+  "Period jitter",
+  "Pulses send",
+};
+
+// the 16 bits 2MHz timer wraps after 32ms, slower
+// cycles are measured with the RTOS time instead
+constexpr uint32_t MIXER_LATENCY_TIMER_MAX_MS = 30;
+
+static bool resetRequested = false;
+static bool periodValid = false;
+static MixerLatencyTime lastCycleStart;
+
+uint8_t LatencyHistogram::getBucketIndex(uint32_t us)
+{
+  if (us < 2)
+    return 0;
+  uint8_t index = 31 - __builtin_clz(us);
+  return index < LATENCY_HISTOGRAM_BUCKETS ? index : LATENCY_HISTOGRAM_BUCKETS - 1;
+}
+
+void LatencyHistogram::add(uint32_t us)
+{
+  uint16_t value = us > UINT16_MAX ? UINT16_MAX : us;
+  if (count == 0 || value < min)
+    min = value;
+  if (value > max)
+    max = value;
+  last = value;
+  buckets[getBucketIndex(us)]++;
+  count++;
+}
+
+void LatencyHistogram::reset()
+{
+  memclear(buckets, sizeof(buckets));
+  count = 0;
+  min = max = last = 0;
+}
+
+uint32_t LatencyHistogram::getPercentile(uint8_t percent) const
+{
+  if (count == 0)
+    return 0;
+
+  uint32_t threshold = ((uint64_t)count * percent + 99) / 100;
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+    total += buckets[i];
+    if (total >= threshold)
+      return getBucketLimit(i);
+  }
+  return getBucketLimit(LATENCY_HISTOGRAM_BUCKETS - 1);
+}
+
+MixerLatencyTime mixerLatencyNow()
+{
+  return { getTmr2MHz(), RTOS_GET_MS() };
+}
+
+static uint32_t mixerLatencyElapsed(const MixerLatencyTime & start, const MixerLatencyTime & end)
+{
+  uint32_t elapsedMs = end.ms - start.ms;
+  if (elapsedMs >= MIXER_LATENCY_TIMER_MAX_MS)
+    return elapsedMs * 1000;
+  return (uint16_t)(end.tmr2MHz - start.tmr2MHz) / 2;
+}
+
+void mixerLatencyUpdate(const MixerLatencyTime & cycleStart,
+                        const MixerLatencyTime & pulsesStart,
+                        const MixerLatencyTime & pulsesEnd)
+{
+  if (resetRequested) {
+    resetRequested = false;
+    for (auto & histogram: mixerLatency) {
+      histogram.reset();
+    }
+  }
+
+  mixerLatency[MIXER_LATENCY_ADC_TO_PULSES].add(mixerLatencyElapsed(cycleStart, pulsesEnd));
+  mixerLatency[MIXER_LATENCY_PULSES_SEND].add(mixerLatencyElapsed(pulsesStart, pulsesEnd));
+
+  if (periodValid) {
+    uint32_t period = mixerLatencyElapsed(lastCycleStart, cycleStart);
+    uint32_t expected = getMixerSchedulerPeriod();
+    mixerLatency[MIXER_LATENCY_PERIOD_JITTER].add(period > expected ? period - expected : expected - period);
+  }
+
+  periodValid = true;
+  lastCycleStart = cycleStart;
+}
+
+void mixerLatencyRestart()
+{
+  periodValid = false;
+}
+
+void mixerLatencyReset()
+{
+  resetRequested = true;
+}
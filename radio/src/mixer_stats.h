@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define LATENCY_HISTOGRAM_BUCKETS  16
+
+// Log2 histogram of durations in us: bucket 0 counts the values below 2us,
+// bucket n the values in [2^n, 2^(n+1)) and the last one everything above.
+//
+// Values are added by the mixer task only, readers get a best effort view.
+class LatencyHistogram
+{
+  public:
+    void add(uint32_t us);
+    void reset();
+
+    uint32_t getCount() const { return count; }
+    uint16_t getMin() const { return count ? min : 0; }
+    uint16_t getMax() const { return max; }
+    uint16_t getLast() const { return last; }
+    uint32_t getBucket(uint8_t index) const { return buckets[index]; }
+
+    // upper bound (in us) of the bucket holding the given percentile
+    uint32_t getPercentile(uint8_t percent) const;
+
+    static uint8_t getBucketIndex(uint32_t us);
+
+    // exclusive upper bound of a bucket, in us
+    static uint32_t getBucketLimit(uint8_t index)
+    {
+      return 2u << index;
+    }
+
+  protected:
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint16_t min;
+    uint16_t max;
+    uint16_t last;
+};
+
+enum MixerLatencyIndex {
+  MIXER_LATENCY_ADC_TO_PULSES,  // start of the mixer cycle to channels sent
+  MIXER_LATENCY_PERIOD_JITTER,  // cycle period vs getMixerSchedulerPeriod()
+  MIXER_LATENCY_PULSES_SEND,    // pulsesSendChannels() duration
+  MIXER_LATENCY_COUNT
+};
+
+extern LatencyHistogram mixerLatency[MIXER_LATENCY_COUNT];
+extern const char * const mixerLatencyNames[MIXER_LATENCY_COUNT];
+
+// getTmr2MHz() timestamp, with the RTOS time for the durations
+// longer than the 16 bits timer range
+struct MixerLatencyTime {
+  uint16_t tmr2MHz;
+  uint32_t ms;
+};
+
+MixerLatencyTime mixerLatencyNow();
+
+// called by the mixer task with timestamps taken before getADC(),
+// before and after pulsesSendChannels()
+void mixerLatencyUpdate(const MixerLatencyTime & cycleStart,
+                        const MixerLatencyTime & pulsesStart,
+                        const MixerLatencyTime & pulsesEnd);
+
+// the next cycle period is not measured (mixer restarted)
+void mixerLatencyRestart();
+
+// clear the histograms, done by the mixer task on its next cycle
+void mixerLatencyReset();
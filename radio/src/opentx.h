@@ -478,7 +478,9 @@ extern uint8_t flightModeTransitionLast;
 extern uint32_t availableMemory();
 
 
-void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms);
+void mixerPlanInvalidate();
+extern bool mixerFadeSharing;
+void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms, uint8_t fadeReferenceFlightMode = 255);
 void evalMixes(uint8_t tick10ms);
 void doMixerCalculations();
 void doMixerPeriodicUpdates();
@@ -495,6 +497,7 @@ bool getSwitch(swsrc_t swtch, uint8_t flags=0);
 
 void logicalSwitchesTimerTick();
 void logicalSwitchesReset();
+void lswPlanInvalidate();
 
 void evalLogicalSwitches(bool isCurrentFlightmode=true);
 void logicalSwitchesCopyState(uint8_t src, uint8_t dst);
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include "definitions.h"
+#include "opentx_helpers.h"
+
+// Channels packing shared by the serial protocols (CRSF, SBUS, Multi, PXX2)
+//
+// Channels outputs [-1024:+1024] are scaled to the protocol range with
+// value * mul / div + center, clipped to [min:max].
+
+struct ChannelsScale {
+  int16_t mul;
+  int16_t div;
+  int16_t center;
+  int16_t min;
+  int16_t max;
+};
+
+constexpr ChannelsScale CROSSFIRE_CHANNELS_SCALE = {4, 5, 0x3E0, 0, 2 * 0x3E0};
+constexpr ChannelsScale SBUS_CHANNELS_SCALE = {8, 10, 992, 0, 2047};
+constexpr ChannelsScale MULTI_CHANNELS_SCALE = {800, 1000, 1024, 0, 2047};
+constexpr ChannelsScale MULTI_FAILSAFE_SCALE = {800, 1000, 1024, 1, 2046};
+constexpr ChannelsScale PXX2_CHANNELS_SCALE = {512, 682, 1024, 1, 2046};
+
+template <const ChannelsScale & scale>
+inline uint16_t scaleChannel(int value, int center = 0)
+{
+  return limit<int>(scale.min, scale.center + center + value * scale.mul / scale.div, scale.max);
+}
+
+// Packs 'count' values of BITS bits, least significant bits first. The bits
+// are accumulated in a 64 bits register and stored 32 at a time (4 bytes,
+// any alignment), the remaining bytes one by one at the end. Only whole
+// bytes are written: count * BITS is expected to be a multiple of 8.
+// Returns the end of the packed data.
+template <uint8_t BITS>
+inline uint8_t * packChannels(uint8_t * buf, const uint16_t * values, uint8_t count)
+{
+  uint64_t bits = 0;
+  uint8_t bitsavailable = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    bits |= (uint64_t)values[i] << bitsavailable;
+    bitsavailable += BITS;
+    if (bitsavailable >= 32) {
+      buf[0] = bits;
+      buf[1] = bits >> 8;
+      buf[2] = bits >> 16;
+      buf[3] = bits >> 24;
+      buf += 4;
+      bits >>= 32;
+      bitsavailable -= 32;
+    }
+  }
+
+  while (bitsavailable >= 8) {
+    *buf++ = bits;
+    bits >>= 8;
+    bitsavailable -= 8;
+  }
+
+  return buf;
+}
@@ -25,10 +25,10 @@
 #include "hal/module_port.h"
 
 #include "crossfire.h"
+#include "channels_packer.h"
 #include "telemetry/crossfire.h"
 
 #define CROSSFIRE_CH_BITS           11
-#define CROSSFIRE_CENTER            0x3E0
 #if defined(PPM_CENTER_ADJUSTABLE)
   #define CROSSFIRE_CENTER_CH_OFFSET(ch)            ((2 * limitAddress(ch)->ppmCenter) + 1)  // + 1 is for rouding
 #else
@@ -60,18 +60,11 @@ uint8_t createCrossfireChannelsFrame(uint8_t * frame, int16_t * pulses)
   *buf++ = 24; // 1(ID) + 22 + 1(CRC)
   uint8_t * crc_start = buf;
   *buf++ = CHANNELS_ID;
-  uint32_t bits = 0;
-  uint8_t bitsavailable = 0;
+  uint16_t values[CROSSFIRE_CHANNELS_COUNT];
   for (int i=0; i<CROSSFIRE_CHANNELS_COUNT; i++) {
-    uint32_t val = limit(0, CROSSFIRE_CENTER + (CROSSFIRE_CENTER_CH_OFFSET(i) * 4) / 5 + (pulses[i] * 4) / 5, 2 * CROSSFIRE_CENTER);
-    bits |= val << bitsavailable;
-    bitsavailable += CROSSFIRE_CH_BITS;
-    while (bitsavailable >= 8) {
-      *buf++ = bits;
-      bits >>= 8;
-      bitsavailable -= 8;
-    }
+    values[i] = scaleChannel<CROSSFIRE_CHANNELS_SCALE>(pulses[i], (CROSSFIRE_CENTER_CH_OFFSET(i) * 4) / 5);
   }
+  buf = packChannels<CROSSFIRE_CH_BITS>(buf, values, CROSSFIRE_CHANNELS_COUNT);
   *buf++ = crc8(crc_start, 23);
   return buf - frame;
 }
@@ -21,6 +21,7 @@
 
 #include "opentx.h"
 #include "multi.h"
+#include "channels_packer.h"
 
 #include "io/multi_protolist.h"
 #include "telemetry/multi.h"
@@ -81,35 +82,27 @@ static void updateMultiSync(uint8_t module)
 
 static void sendFailsafeChannels(uint8_t*& p_buf, uint8_t module)
 {
-  uint32_t bits = 0;
-  uint8_t bitsavailable = 0;
+  uint16_t values[MULTI_CHANS];
 
   for (int i = 0; i < MULTI_CHANS; i++) {
     int16_t failsafeValue = g_model.failsafeChannels[i];
-    int pulseValue;
 
     if (g_model.moduleData[module].failsafeMode == FAILSAFE_HOLD ||
         failsafeValue == FAILSAFE_CHANNEL_HOLD) {
-      pulseValue = 2047;
+      values[i] = 2047;
     } else if (g_model.moduleData[module].failsafeMode ==
                    FAILSAFE_NOPULSES ||
                failsafeValue == FAILSAFE_CHANNEL_NOPULSE) {
-      pulseValue = 0;
+      values[i] = 0;
     } else {
       failsafeValue +=
           2 * PPM_CH_CENTER(g_model.moduleData[module].channelsStart + i) -
           2 * PPM_CENTER;
-      pulseValue = limit(1, (failsafeValue * 800 / 1000) + 1024, 2046);
-    }
-
-    bits |= pulseValue << bitsavailable;
-    bitsavailable += MULTI_CHAN_BITS;
-    while (bitsavailable >= 8) {
-      sendMulti(p_buf, (uint8_t) (bits & 0xff));
-      bits >>= 8;
-      bitsavailable -= 8;
+      values[i] = scaleChannel<MULTI_FAILSAFE_SCALE>(failsafeValue);
     }
   }
+
+  p_buf = packChannels<MULTI_CHAN_BITS>(p_buf, values, MULTI_CHANS);
 }
 
 static void setupPulsesMulti(uint8_t*& p_buf, uint8_t module)
@@ -295,8 +288,7 @@ const etx_proto_driver_t MultiDriver = {
 
 static void sendChannels(uint8_t*& p_buf, uint8_t module)
 {
-  uint32_t bits = 0;
-  uint8_t bitsavailable = 0;
+  uint16_t values[MULTI_CHANS];
 
   // byte 4-25, channels 0..2047
   // Range for pulses (channelsOutputs) is [-1024:+1024] for [-100%;100%]
@@ -306,17 +298,10 @@ static void sendChannels(uint8_t*& p_buf, uint8_t module)
     int value = channelOutputs[channel] + 2 * PPM_CH_CENTER(channel) - 2 * PPM_CENTER;
 
     // Scale to 80%
-    value = value * 800 / 1000 + 1024;
-    value = limit(0, value, 2047);
-
-    bits |= value << bitsavailable;
-    bitsavailable += MULTI_CHAN_BITS;
-    while (bitsavailable >= 8) {
-      sendMulti(p_buf, (uint8_t) (bits & 0xff));
-      bits >>= 8;
-      bitsavailable -= 8;
-    }
+    values[i] = scaleChannel<MULTI_CHANNELS_SCALE>(value);
   }
+
+  p_buf = packChannels<MULTI_CHAN_BITS>(p_buf, values, MULTI_CHANS);
 }
 
 void sendFrameProtocolHeader(uint8_t*& p_buf, uint8_t module, bool failsafe)
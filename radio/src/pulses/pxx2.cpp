@@ -29,6 +29,7 @@
 
 #include "pxx2.h"
 #include "pxx2_transport.h"
+#include "channels_packer.h"
 
 static const etx_serial_init pxx2SerialInitParams = {
     .baudrate = PXX2_HIGHSPEED_BAUDRATE,
@@ -211,70 +212,67 @@ void Pxx2Pulses::addFlag1(uint8_t module)
   Pxx2Transport::addByte(flag1);
 }
 
-void Pxx2Pulses::addPulsesValues(uint16_t low, uint16_t high)
+// 12 bits channels, 2 channels in 3 bytes
+void Pxx2Pulses::addPulsesValues(const uint16_t * values, uint8_t count)
 {
-  Pxx2Transport::addByte(low); // Low byte of channel
-  Pxx2Transport::addByte(((low >> 8u) & 0x0Fu) | (high << 4u));  // 4 bits each from 2 channels
-  Pxx2Transport::addByte(high >> 4u);  // High byte of channel
+  uint8_t * start = ptr;
+  ptr = packChannels<12>(ptr, values, count & ~1u);
+  for (uint8_t * p = start; p < ptr; p++) {
+    Pxx2CrcMixin::addToCrc(*p);
+  }
 }
 
 void Pxx2Pulses::addChannels(uint8_t module, int16_t* channels, uint8_t nChannels)
 {
-  uint16_t pulseValue = 0;
-  uint16_t pulseValueLow = 0;
+  uint16_t values[MAX_OUTPUT_CHANNELS];
 
   uint8_t channel = g_model.moduleData[module].channelsStart;
   uint8_t count = sentModuleChannels(module);
 
   for (int8_t i = 0; i < count; i++, channel++) {
     int value = channels[i] + 2*PPM_CH_CENTER(channel) - 2*PPM_CENTER;
-    pulseValue = limit(1, (value * 512 / 682) + 1024, 2046);
+    values[i] = scaleChannel<PXX2_CHANNELS_SCALE>(value);
 #if defined(DEBUG_LATENCY_RF_ONLY)
     if (latencyToggleSwitch)
-      pulseValue = 1;
+      values[i] = 1;
     else
-      pulseValue = 2046;
+      values[i] = 2046;
 #endif
-    if (i & 1)
-      addPulsesValues(pulseValueLow, pulseValue);
-    else
-      pulseValueLow = pulseValue;
   }
+
+  addPulsesValues(values, count);
 }
 
 void Pxx2Pulses::addFailsafe(uint8_t module)
 {
-  uint16_t pulseValue = 0;
-  uint16_t pulseValueLow = 0;
+  uint16_t values[MAX_OUTPUT_CHANNELS];
 
   uint8_t channel = g_model.moduleData[module].channelsStart;
   uint8_t count = sentModuleChannels(module);
 
   for (int8_t i = 0; i < count; i++, channel++) {
     if (g_model.moduleData[module].failsafeMode == FAILSAFE_HOLD) {
-      pulseValue = 2047;
+      values[i] = 2047;
     }
     else if (g_model.moduleData[module].failsafeMode == FAILSAFE_NOPULSES) {
-      pulseValue = 0;
+      values[i] = 0;
     }
     else {
       int16_t failsafeValue = g_model.failsafeChannels[channel];
       if (failsafeValue == FAILSAFE_CHANNEL_HOLD) {
-        pulseValue = 2047;
+        values[i] = 2047;
       }
       else if (failsafeValue == FAILSAFE_CHANNEL_NOPULSE) {
-        pulseValue = 0;
+        values[i] = 0;
       }
       else {
         failsafeValue += 2*PPM_CH_CENTER(channel) - 2*PPM_CENTER;
-        pulseValue = limit(1, (failsafeValue * 512 / 682) + 1024, 2046);
+        values[i] = scaleChannel<PXX2_CHANNELS_SCALE>(failsafeValue);
       }
     }
-    if (i & 1)
-      addPulsesValues(pulseValueLow, pulseValue);
-    else
-      pulseValueLow = pulseValue;
   }
+
+  addPulsesValues(values, count);
 }
 
 void Pxx2Pulses::setupChannelsFrame(uint8_t module, int16_t* channels, uint8_t nChannels)
@@ -20,6 +20,7 @@
  */
 
 #include "sbus.h"
+#include "channels_packer.h"
 #include "hal/module_port.h"
 #include "mixer_scheduler.h"
 
@@ -36,8 +37,6 @@
 #define SBUS_FLAG_FAILSAFE_ACTIVE   (1 << 3)
 #define SBUS_FRAME_BEGIN_BYTE       0x0F
 
-#define SBUS_CHAN_CENTER            992
-
 static inline void sendByte(uint8_t*& p_buf, uint8_t b)
 {
   *p_buf++ = b;
@@ -59,22 +58,12 @@ static void setupPulsesSbus(uint8_t module, uint8_t*& p_buf)
   // Sync Byte
   sendByte(p_buf, SBUS_FRAME_BEGIN_BYTE);
 
-  uint32_t bits = 0;
-  uint8_t bitsavailable = 0;
-
   // byte 1-22, channels 0..2047, limits not really clear (B
+  uint16_t values[SBUS_NORMAL_CHANS];
   for (int i=0; i<SBUS_NORMAL_CHANS; i++) {
-    int value = getChannelValue(module, i);
-
-    value =  value*8/10 + SBUS_CHAN_CENTER;
-    bits |= limit(0, value, 2047) << bitsavailable;
-    bitsavailable += SBUS_CHAN_BITS;
-    while (bitsavailable >= 8) {
-      sendByte(p_buf, (uint8_t) (bits & 0xff));
-      bits >>= 8;
-      bitsavailable -= 8;
-    }
+    values[i] = scaleChannel<SBUS_CHANNELS_SCALE>(getChannelValue(module, i));
   }
+  p_buf = packChannels<SBUS_CHAN_BITS>(p_buf, values, SBUS_NORMAL_CHANS);
 
   // flags
   uint8_t flags=0;
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Headless simulator: runs a model against a scripted timeline on a virtual
+// clock, as fast as the mixer can go, and records the channel outputs to a
+// CSV file which can be compared to a golden file for regression runs.
+
+#include "opentx.h"
+#include "targets/simu/simuheadless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+uint16_t anaInValues[NUM_STICKS + NUM_POTS + NUM_SLIDERS] = { 0 };
+
+uint16_t anaIn(uint8_t chan)
+{
+  if (chan < NUM_STICKS + NUM_POTS + NUM_SLIDERS)
+    return anaInValues[chan];
+  else
+    return 0;
+}
+
+uint16_t getAnalogValue(uint8_t index)
+{
+  return anaIn(index);
+}
+
+static void usage(const char * name)
+{
+  fprintf(stderr,
+          "Usage: %s [options] <timeline>\n"
+          "  --sd <path>        SD card directory (radio settings and models)\n"
+          "  --settings <path>  settings directory (defaults to the SD card one)\n"
+          "  --model <file>     model file in MODELS/ (defaults to the current model)\n"
+          "  --output <file>    CSV output file (defaults to stdout)\n"
+          "  --golden <file>    compare the output with this CSV file\n"
+          "  --duration <ms>    run duration (defaults to the timeline end)\n"
+          "  --record <ms>      recording period (defaults to 10ms)\n"
+          "  --mixer <ms>       mixer period (defaults to %ums)\n"
+          "  --channels <n>     number of channels recorded (defaults to %u)\n",
+          name, MIXER_SCHEDULER_DEFAULT_PERIOD_US / 1000, MAX_OUTPUT_CHANNELS);
+}
+
+static bool loadStorage(const char * sdPath, const char * settingsPath, const char * modelFile)
+{
+#if defined(SDCARD)
+  if (sdPath) {
+    simuFatfsSetPaths(sdPath, settingsPath ? settingsPath : sdPath);
+
+    const char * error = loadRadioSettings();
+    if (error) {
+      fprintf(stderr, "Radio settings: %s\n", error);
+      return false;
+    }
+
+    if (modelFile) {
+      char filename[LEN_MODEL_FILENAME + 1];
+      strncpy(filename, modelFile, LEN_MODEL_FILENAME);
+      filename[LEN_MODEL_FILENAME] = '\0';
+      error = loadModel(filename, false);
+    }
+    else {
+#if defined(STORAGE_MODELSLIST)
+      error = loadModel(g_eeGeneral.currModelFilename, false);
+#else
+      error = loadModel(g_eeGeneral.currModel, false);
+#endif
+    }
+
+    if (error) {
+      fprintf(stderr, "Model: %s\n", error);
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  // no SD card: default radio settings and model
+  generalDefault();
+  preModelLoad();
+  memset(&g_model, 0, sizeof(g_model));
+  applyDefaultTemplate();
+  postModelLoad(false);
+  return true;
+}
+
+// the CSV output may go to stdout: traces are sent to stderr
+static void traceToStderr(const char * text)
+{
+  fputs(text, stderr);
+}
+
+int main(int argc, char ** argv)
+{
+  const char * sdPath = nullptr;
+  const char * settingsPath = nullptr;
+  const char * modelFile = nullptr;
+  const char * outputFile = nullptr;
+  const char * goldenFile = nullptr;
+  const char * timelineFile = nullptr;
+  uint32_t duration = 0;
+  uint32_t recordPeriod = 10;
+  uint32_t mixerPeriod = MIXER_SCHEDULER_DEFAULT_PERIOD_US / 1000;
+  uint32_t channels = MAX_OUTPUT_CHANNELS;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg[0] != '-') {
+      timelineFile = argv[i];
+      continue;
+    }
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+      return 2;
+    }
+    const char * value = argv[++i];
+    if (arg == "--sd")
+      sdPath = value;
+    else if (arg == "--settings")
+      settingsPath = value;
+    else if (arg == "--model")
+      modelFile = value;
+    else if (arg == "--output")
+      outputFile = value;
+    else if (arg == "--golden")
+      goldenFile = value;
+    else if (arg == "--duration")
+      duration = strtoul(value, nullptr, 0);
+    else if (arg == "--record")
+      recordPeriod = strtoul(value, nullptr, 0);
+    else if (arg == "--mixer")
+      mixerPeriod = strtoul(value, nullptr, 0);
+    else if (arg == "--channels")
+      channels = limit<uint32_t>(1, strtoul(value, nullptr, 0), MAX_OUTPUT_CHANNELS);
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (!timelineFile) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  traceStdout = false;
+  traceCallback = traceToStderr;
+
+  HeadlessSimulator simulator;
+  if (!simulator.loadTimeline(timelineFile)) {
+    fprintf(stderr, "%s: %s\n", timelineFile, simulator.getError().c_str());
+    return 2;
+  }
+
+  simuInit();
+  simuSetVirtualClock(true);
+  g_tmr10ms = 0;
+
+  if (!loadStorage(sdPath, settingsPath, modelFile)) {
+    return 2;
+  }
+
+  simulator.setAnalogs(anaInValues);
+  simulator.setMixerPeriod(mixerPeriod);
+
+  std::ostringstream output;
+  output << "time";
+  for (uint32_t ch = 0; ch < channels; ch++) {
+    output << ",CH" << ch + 1;
+  }
+  output << "\n";
+
+  simulator.run(duration ? duration : simulator.getDuration(), recordPeriod,
+                [&](uint32_t time, const int16_t * outputs) {
+                  output << time;
+                  for (uint32_t ch = 0; ch < channels; ch++) {
+                    output << "," << outputs[ch];
+                  }
+                  output << "\n";
+                });
+
+  if (outputFile) {
+    std::ofstream file(outputFile);
+    file << output.str();
+  }
+  else if (!goldenFile) {
+    fputs(output.str().c_str(), stdout);
+  }
+
+  if (goldenFile) {
+    std::ifstream file(goldenFile);
+    if (!file) {
+      fprintf(stderr, "cannot open %s\n", goldenFile);
+      return 2;
+    }
+
+    std::istringstream result(output.str());
+    std::string expected, actual;
+    unsigned line = 0;
+    while (true) {
+      bool hasExpected = (bool)std::getline(file, expected);
+      bool hasActual = (bool)std::getline(result, actual);
+      line++;
+      if (!hasExpected && !hasActual)
+        break;
+      if (!hasExpected || !hasActual || expected != actual) {
+        fprintf(stderr, "%s:%u: mismatch\n  expected: %s\n  actual:   %s\n", goldenFile, line,
+                hasExpected ? expected.c_str() : "<end of file>",
+                hasActual ? actual.c_str() : "<end of output>");
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
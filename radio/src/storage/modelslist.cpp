@@ -886,6 +886,17 @@ void ModelsList::clear()
     delete(mdl);
   }
   std::vector<ModelCell *>::clear();
+#if defined(SDCARD_YAML)
+  for(ModelCell *mdl: removedCells) {
+    delete(mdl);
+  }
+  removedCells.clear();
+  if (rescanDirOpen) {
+    f_closedir(&rescanDir);
+    rescanDirOpen = false;
+  }
+  rescanPending = false;
+#endif
   init();
 }
 
@@ -971,14 +982,36 @@ void ModelMap::updateModelCell(ModelCell *cell)
 
 char *FILInfoToHexStr(char buffer[17], FILINFO *finfo)
 {
+  static const char hex[] = "0123456789abcdef";
   char *str = buffer;
   for (unsigned int i = 0; i < sizeof(FInfoH); i++) {
-    sprintf(str, "%02x", *((uint8_t *)finfo + i));
-    str += 2;
+    uint8_t byte = *((uint8_t *)finfo + i);
+    *str++ = hex[byte >> 4];
+    *str++ = hex[byte & 0x0F];
   }
+  *str = '\0';
   return buffer;
 }
 
+/**
+ * @brief Checks the file is a model###.yml file
+ */
+
+static bool isModelFilename(const char *fname)
+{
+  unsigned int len = strlen(fname);
+  if (len < sizeof(MODEL_FILENAME_PREFIX) - 1 + 4) return false;
+
+  if (strncasecmp(fname, MODEL_FILENAME_PREFIX, sizeof(MODEL_FILENAME_PREFIX) - 1) != 0)
+    return false;
+
+  for (unsigned int i = sizeof(MODEL_FILENAME_PREFIX) - 1; i < len - 4; i++) {
+    if (fname[i] < '0' || fname[i] > '9') return false;
+  }
+
+  return strcasecmp(fname + len - 4, YAML_EXT) == 0;
+}
+
 /**
  * @brief Loads the Labels and Models from the labels.yml file
  *
@@ -993,6 +1026,12 @@ bool ModelsList::loadYaml()
   modelslabels.clear();
   fileHashInfo.clear();
 
+  // Fast path: the index written with labels.yml, the models folder is
+  // checked afterwards by rescanStep()
+  if (loadYamlIndex()) {
+    return true;
+  }
+
   DEBUG_TIMER_START(debugTimerYamlScan);
 
   // Scan all models in folder
@@ -1003,26 +1042,9 @@ bool ModelsList::loadYaml()
       FRESULT res = f_readdir(&moddir, &finfo);
       if (res != FR_OK || finfo.fname[0] == 0) break;
       if (finfo.fattrib & AM_DIR) continue;
-      unsigned int len = strlen(finfo.fname);
 
       // Only open model###.yml files
-      bool modelNameInvalid = false;
-      if (strncasecmp(finfo.fname, MODEL_FILENAME_PREFIX, sizeof(MODEL_FILENAME_PREFIX) - 1) == 0) {
-        for (unsigned int i = sizeof(MODEL_FILENAME_PREFIX) - 1; i < len - 4; i++) {
-          if(finfo.fname[i] < '0' || finfo.fname[i] > '9') {
-            modelNameInvalid = true;
-            break;
-          }
-        }
-      } else {
-        modelNameInvalid = true;
-      }
-
-      if (modelNameInvalid ||
-          strcasecmp(finfo.fname + len - 4, YAML_EXT) ||  // Skip non .yml files
-          (finfo.fattrib & AM_DIR)) {  // Skip sub dirs
-        continue;
-      }
+      if (!isModelFilename(finfo.fname)) continue;
 
       // Store hash & filename
       filedat cf;
@@ -1182,15 +1204,346 @@ bool ModelsList::loadYaml()
     modelslist.save();
   } else {
     TRACE_LABELS("LABELS.YML Is in Sync! No models were read");
+    // the index was missing or outdated, otherwise it would have been loaded
+    saveYamlIndex(modelslabels.getLabels());
+  }
+
+  // If no labels found. Add a favorites label
+  if (modelslabels.getLabels().size() == 0) {
+    modelslabels.addLabel(STR_FAVORITE_LABEL);
+  }
+
+  return true;
+}
+
+// labels.idx is a binary copy of labels.yml written next to it. It holds the
+// model cells and labels and is loaded with a single read. It is only used
+// while labels.yml still has the size and date it was written with.
+
+#define MODELS_INDEX_MAGIC    "ELIX"
+#define MODELS_INDEX_VERSION  1
+#define MODELS_RESCAN_FILES_PER_STEP  4
+
+#define MODELS_INDEX_LABEL_FILTERED  0x01
+
+PACK(struct ModelsIndexHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t sortOrder;
+  uint16_t labelsCount;
+  uint16_t modelsCount;
+  uint16_t crc;  // crc16 of the data following the header
+  FInfoH labelsFile;
+});
+
+// followed by labelsCount x uint16_t label index
+PACK(struct ModelsIndexEntry {
+  char filename[LEN_MODEL_FILENAME];
+  char hash[FILE_HASH_LENGTH];
+  char name[LEN_MODEL_NAME];
+#if LEN_BITMAP_NAME > 0
+  char bitmap[LEN_BITMAP_NAME];
+#endif
+  uint32_t lastOpened;
+  uint8_t modelId[NUM_MODULES];
+  uint8_t moduleType[NUM_MODULES];
+  uint8_t moduleSubType[NUM_MODULES];
+  uint8_t labelsCount;
+});
+
+/**
+ * @brief Writes labels.idx after labels.yml has been saved
+ *
+ * @param labels Labels in the order written to labels.yml
+ */
+
+void ModelsList::saveYamlIndex(const LabelsVector &labels)
+{
+  FILINFO labelsInfo;
+  if (f_stat(LABELSLIST_YAML_PATH, &labelsInfo) != FR_OK) return;
+
+  std::string data;
+  for (const auto &lbl : labels) {
+    uint8_t flags = 0;
+    if (modelslabels.isLabelFiltered(lbl)) flags |= MODELS_INDEX_LABEL_FILTERED;
+    uint8_t len = std::min<size_t>(lbl.size(), UINT8_MAX);
+    data.push_back(flags);
+    data.push_back(len);
+    data.append(lbl, 0, len);
+  }
+
+  for (auto &model : *this) {
+    ModelsIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.filename, model->modelFilename, sizeof(entry.filename));
+    strncpy(entry.hash, model->modelFinfoHash, sizeof(entry.hash));
+    strncpy(entry.name, model->modelName, sizeof(entry.name));
+#if LEN_BITMAP_NAME > 0
+    strncpy(entry.bitmap, model->modelBitmap, sizeof(entry.bitmap));
+#endif
+    entry.lastOpened = model->lastOpened;
+    for (int i = 0; i < NUM_MODULES; i++) {
+      entry.modelId[i] = model->modelId[i];
+      entry.moduleType[i] = model->moduleData[i].type;
+      entry.moduleSubType[i] = model->moduleData[i].subType;
+    }
+
+    std::vector<uint16_t> indexes;
+    for (const auto &lbl : modelslabels.getLabelsByModel(model)) {
+      auto it = std::find(labels.begin(), labels.end(), lbl);
+      if (it != labels.end()) indexes.push_back(it - labels.begin());
+    }
+    entry.labelsCount = std::min<size_t>(indexes.size(), UINT8_MAX);
+    data.append((const char *)&entry, sizeof(entry));
+    data.append((const char *)indexes.data(),
+                entry.labelsCount * sizeof(uint16_t));
+  }
+
+  ModelsIndexHeader header;
+  memcpy(header.magic, MODELS_INDEX_MAGIC, sizeof(header.magic));
+  header.version = MODELS_INDEX_VERSION;
+  header.sortOrder = modelslabels.sortOrder();
+  header.labelsCount = labels.size();
+  header.modelsCount = size();
+  header.crc = crc16(CRC_1021, (const uint8_t *)data.data(), data.size());
+  memcpy(&header.labelsFile, &labelsInfo, sizeof(FInfoH));
+
+  FIL idx;
+  if (f_open(&idx, LABELSLIST_INDEX_PATH, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return;
+
+  UINT written;
+  FRESULT result = f_write(&idx, &header, sizeof(header), &written);
+  if (result == FR_OK)
+    result = f_write(&idx, data.data(), data.size(), &written);
+  f_close(&idx);
+
+  if (result != FR_OK || written != data.size()) {
+    TRACE("Labels: unable to write the index");
+    f_unlink(LABELSLIST_INDEX_PATH);
+  }
+}
+
+/**
+ * @brief Loads the Labels and Models from labels.idx
+ *
+ * @return true On success
+ * @return false The index is missing or out of date, the full load is needed
+ */
+
+bool ModelsList::loadYamlIndex()
+{
+  FILINFO fno;
+
+  // models.yml is migrated by the full load
+  if (f_stat(MODELSLIST_YAML_PATH, &fno) == FR_OK ||
+      f_stat(FALLBACK_MODELSLIST_YAML_PATH, &fno) == FR_OK)
+    return false;
+
+  if (f_stat(LABELSLIST_YAML_PATH, &fno) != FR_OK) return false;
+
+  if (f_open(&file, LABELSLIST_INDEX_PATH, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    return false;
+
+  UINT size = f_size(&file);
+  uint8_t *buffer = nullptr;
+  UINT bytes_read = 0;
+  if (size > sizeof(ModelsIndexHeader)) {
+    buffer = (uint8_t *)malloc(size);
+    if (buffer && f_read(&file, buffer, size, &bytes_read) != FR_OK)
+      bytes_read = 0;
   }
+  f_close(&file);
+
+  if (!buffer || bytes_read != size) {
+    free(buffer);
+    return false;
+  }
+
+  const ModelsIndexHeader *header = (const ModelsIndexHeader *)buffer;
+  const uint8_t *data = buffer + sizeof(ModelsIndexHeader);
+  const uint8_t *end = buffer + size;
+
+  if (memcmp(header->magic, MODELS_INDEX_MAGIC, sizeof(header->magic)) ||
+      header->version != MODELS_INDEX_VERSION ||
+      memcmp(&header->labelsFile, &fno, sizeof(FInfoH)) ||
+      header->crc != crc16(CRC_1021, data, end - data)) {
+    TRACE_LABELS("Labels: index out of date");
+    free(buffer);
+    return false;
+  }
+
+  DEBUG_TIMER_START(debugTimerYamlScan);
+
+  bool valid = true;
+  LabelsVector labels;
+  for (int i = 0; valid && i < header->labelsCount; i++) {
+    if (data + 2 > end || data + 2 + data[1] > end) {
+      valid = false;
+      break;
+    }
+    std::string lbl((const char *)data + 2, data[1]);
+    modelslabels.addLabel(lbl);
+    if (data[0] & MODELS_INDEX_LABEL_FILTERED)
+      modelslabels.addFilteredLabel(lbl);
+    labels.push_back(lbl);
+    data += 2 + data[1];
+  }
+
+  for (int i = 0; valid && i < header->modelsCount; i++) {
+    ModelsIndexEntry entry;
+    if (data + sizeof(entry) > end) {
+      valid = false;
+      break;
+    }
+    memcpy(&entry, data, sizeof(entry));
+    data += sizeof(entry);
+    if (data + entry.labelsCount * sizeof(uint16_t) > end) {
+      valid = false;
+      break;
+    }
+
+    ModelCell *model = new ModelCell(entry.filename, sizeof(entry.filename));
+    memcpy(model->modelFinfoHash, entry.hash, FILE_HASH_LENGTH);
+    model->modelFinfoHash[FILE_HASH_LENGTH] = '\0';
+    memcpy(model->modelName, entry.name, LEN_MODEL_NAME);
+    model->modelName[LEN_MODEL_NAME] = '\0';
+#if LEN_BITMAP_NAME > 0
+    memcpy(model->modelBitmap, entry.bitmap, LEN_BITMAP_NAME);
+    model->modelBitmap[LEN_BITMAP_NAME] = '\0';
+#endif
+    model->lastOpened = entry.lastOpened;
+    for (int j = 0; j < NUM_MODULES; j++) {
+      model->modelId[j] = entry.modelId[j];
+      model->moduleData[j].type = entry.moduleType[j];
+      model->moduleData[j].subType = entry.moduleSubType[j];
+    }
+    model->valid_rfData = true;
+    model->_isDirty = false;
+    push_back(model);
+
+    for (int j = 0; j < entry.labelsCount; j++) {
+      uint16_t index;
+      memcpy(&index, data, sizeof(index));
+      data += sizeof(index);
+      if (index < labels.size())
+        modelslabels.addLabelToModel(labels[index], model);
+    }
+
+    if (!strncmp(model->modelFilename, g_eeGeneral.currModelFilename,
+                 LEN_MODEL_FILENAME))
+      setCurrentModel(model);
+  }
+
+  uint8_t sortOrder = header->sortOrder;
+  free(buffer);
+
+  if (!valid) {
+    clear();
+    modelslabels.clear();
+    return false;
+  }
+
+  modelslabels.setSortOrder((ModelsSortBy)sortOrder);
 
   // If no labels found. Add a favorites label
   if (modelslabels.getLabels().size() == 0) {
     modelslabels.addLabel(STR_FAVORITE_LABEL);
   }
 
+#if defined(DEBUG_TIMERS)
+  DEBUG_TIMER_SAMPLE(debugTimerYamlScan);
+  TRACE("Labels: Time to load labels.idx %luus",
+        debugTimers[debugTimerYamlScan].getLast());
+#endif
+
+  rescanPending = true;
   return true;
 }
+
+/**
+ * @brief Checks a few files of the models folder against the model cells
+ * @details Called periodically after the list has been loaded from
+ *          labels.idx. Only the models whose file changed are read, new
+ *          files get a model cell and the cells of deleted files are removed
+ *          once the whole folder has been scanned.
+ */
+
+void ModelsList::rescanStep()
+{
+  if (!rescanPending) return;
+
+  if (!rescanDirOpen) {
+    if (f_opendir(&rescanDir, MODELS_PATH) != FR_OK) {
+      rescanPending = false;
+      return;
+    }
+    rescanDirOpen = true;
+    rescanChanged = false;
+    for (auto &model : *this) {
+      model->_isScanned = false;
+    }
+  }
+
+  for (int i = 0; i < MODELS_RESCAN_FILES_PER_STEP; i++) {
+    FILINFO finfo;
+    FRESULT res = f_readdir(&rescanDir, &finfo);
+    if (res != FR_OK || finfo.fname[0] == 0) {
+      f_closedir(&rescanDir);
+      rescanDirOpen = false;
+      rescanPending = false;
+      if (res == FR_OK) rescanFinish();
+      return;
+    }
+
+    if ((finfo.fattrib & AM_DIR) || !isModelFilename(finfo.fname)) continue;
+
+    char hash[FILE_HASH_LENGTH + 1];
+    FILInfoToHexStr(hash, &finfo);
+
+    ModelCell *model = nullptr;
+    for (auto &cell : *this) {
+      if (!strcmp(cell->modelFilename, finfo.fname)) {
+        model = cell;
+        break;
+      }
+    }
+
+    if (!model) {
+      TRACE_LABELS("Labels: new model file %s", finfo.fname);
+      model = new ModelCell(finfo.fname);
+      push_back(model);
+    } else if (!strcmp(model->modelFinfoHash, hash)) {
+      model->_isScanned = true;
+      continue;
+    }
+
+    TRACE_LABELS("Labels: model file %s changed", finfo.fname);
+    strcpy(model->modelFinfoHash, hash);
+    modelslabels.updateModelCell(model);
+    model->_isScanned = true;
+    rescanChanged = true;
+  }
+}
+
+void ModelsList::rescanFinish()
+{
+  for (auto it = begin(); it != end();) {
+    ModelCell *model = *it;
+    if (!model->_isScanned && model != currentModel) {
+      TRACE_LABELS("Labels: model file %s removed", model->modelFilename);
+      modelslabels.removeModels(model);
+      it = erase(it);
+      // the GUI may still reference it, deleted with the next clear()
+      removedCells.push_back(model);
+      rescanChanged = true;
+    } else {
+      ++it;
+    }
+  }
+
+  if (rescanChanged) modelslabels.setDirty();
+}
 #endif
 
 /**
@@ -1318,6 +1671,10 @@ const char *ModelsList::save(LabelsVector newOrder)
   f_close(&file);
   modelslabels._isDirty = false;
 
+#if defined(SDCARD_YAML)
+  saveYamlIndex(newOrder);
+#endif
+
   return NULL;
 }
 
@@ -81,6 +81,7 @@ class ModelCell
 #endif
   gtime_t lastOpened = 0;
   bool _isDirty = true;
+  bool _isScanned = true;   // file seen by the running models folder rescan
 
   bool valid_rfData;
   uint8_t modelId[NUM_MODULES] = {0, 0};
@@ -251,6 +252,12 @@ class ModelsList : public ModelsVector
 
   bool readNextLine(char *line, int maxlen);
 
+#if defined(SDCARD_YAML)
+  void rescanStep();
+  // true after a load from labels.idx, until the folder has been checked
+  bool isRescanPending() const { return rescanPending; }
+#endif
+
   ModelCell *addModel(const char *name, bool save = true, ModelCell *copyCell = nullptr);
   bool removeModel(ModelCell *model);
   bool moveModelTo(unsigned curindex, unsigned toindex);
@@ -273,6 +280,16 @@ class ModelsList : public ModelsVector
 #if defined(SDCARD_YAML)
   bool loadYaml();
   bool loadYamlDirScanner();
+  bool loadYamlIndex();
+  void saveYamlIndex(const LabelsVector &labels);
+  void rescanFinish();
+
+  // models folder rescan after a load from labels.idx, see rescanStep()
+  bool rescanPending = false;
+  bool rescanDirOpen = false;
+  bool rescanChanged = false;
+  DIR rescanDir;
+  ModelsVector removedCells;
 #endif
 };
 
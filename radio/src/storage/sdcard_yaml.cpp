@@ -38,6 +38,11 @@
  #include "storage/eeprom_rlc.h"
 #endif
 
+// Whole sectors are read straight into this buffer by FatFs (no copy
+// through the file window) and parsed in place. Files are only read
+// from the menus task, so a single buffer is enough.
+static char yamlReadBuffer[FF_MAX_SS] __DMA;
+
 const char * readYamlFile(const char* fullpath, const YamlParserCalls* calls, void* parser_ctx, ChecksumResult* checksum_result)
 {
     FIL  file;
@@ -56,8 +61,8 @@ const char * readYamlFile(const char* fullpath, const YamlParserCalls* calls, vo
     uint16_t file_checksum = 0;
 
     bool first_block = true;
-    char buffer[32];
-    while (f_read(&file, buffer, sizeof(buffer)-1, &bytes_read) == FR_OK) {
+    char* buffer = yamlReadBuffer;
+    while (f_read(&file, buffer, sizeof(yamlReadBuffer), &bytes_read) == FR_OK) {
       if (bytes_read == 0)  // EOF
         break;
       total_bytes += bytes_read;
@@ -69,18 +74,19 @@ const char * readYamlFile(const char* fullpath, const YamlParserCalls* calls, vo
         first_block = false;
         const char *skipValue = "checksum: ";
         if(strncmp(buffer, skipValue, strlen(skipValue)) == 0) {
-          skip = 10;
           char* startPos = buffer + strlen(skipValue);
           char* endPos = startPos;
+          char* bufferEnd = buffer + bytes_read;
           // Advance through the value
-          while((*endPos != '\r') && (*endPos != '\n')) {
-            if (endPos > buffer + bytes_read) {
-              return SDCARD_ERROR(	FR_INT_ERR );
-            }
+          while((endPos < bufferEnd) && (*endPos != '\r') && (*endPos != '\n')) {
             endPos++;
           }
+          if (endPos >= bufferEnd) {
+            f_close(&file);
+            return SDCARD_ERROR(FR_INT_ERR);
+          }
           // Skip trailing newline
-          while((*endPos == '\r') || (*endPos == '\n')) {
+          while((endPos < bufferEnd) && ((*endPos == '\r') || (*endPos == '\n'))) {
             *endPos = 0;
             endPos++;
           }
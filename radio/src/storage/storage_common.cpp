@@ -47,6 +47,15 @@ void storageDirty(uint8_t msk)
   storageDirtyMsk |= msk;
   storageDirtyTime10ms = get_tmr10ms();
 
+  if (msk & EE_MODEL) {
+    mixerPlanInvalidate();
+    lswPlanInvalidate();
+    telemetrySensorsIndexInvalidate();
+#if defined(CURVES_LUT)
+    curvesLutInvalidate();
+#endif
+  }
+
 #if defined(RTC_BACKUP_RAM)
   rambackupDirtyMsk = storageDirtyMsk;
   rambackupDirtyTime10ms = storageDirtyTime10ms;
@@ -139,6 +148,10 @@ static void sortMixerLines()
 
 void postModelLoad(bool alarms)
 {
+  mixerPlanInvalidate();
+  lswPlanInvalidate();
+  telemetrySensorsIndexInvalidate();
+
   // Convert 'noGlobalFunctions' to 'radioGFDisabled'
   // TODO: Remove sometime in the future (and remove 'noGlobalFunctions' property)
   if (g_model.noGlobalFunctions) {
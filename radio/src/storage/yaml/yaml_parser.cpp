@@ -51,9 +51,23 @@ void YamlParser::reset()
         state = saved_state = ps_Indent;
     }
     indent = scratch_len  = 0;
+    token = nullptr;
+    token_len = 0;
     node_found = false;
 }
 
+bool YamlParser::spillToken()
+{
+    if (scratch_len + token_len > MAX_STR)
+        return false;
+
+    memcpy(scratch_buf + scratch_len, token, token_len);
+    scratch_len += token_len;
+    token = nullptr;
+    token_len = 0;
+    return true;
+}
+
 bool YamlParser::toChild()
 {
     bool ret = calls->to_child(ctx);
@@ -90,6 +104,32 @@ YamlParser::parse(const char* buffer, unsigned int size)
         }                                       \
     }
 
+    // plain characters are kept in the chunk as long as
+    // the token is contiguous and nothing has been copied yet
+#define PUSH_CHAR(p)                                    \
+    {                                                   \
+        if (!token && !scratch_len) {                   \
+            token = p;                                  \
+            token_len = 0;                              \
+        }                                               \
+        if (token && (token + token_len == p)           \
+            && (token_len < MAX_STR)) {                 \
+            token_len++;                                \
+        }                                               \
+        else {                                          \
+            SPILL_TOKEN();                              \
+            CONCAT_STR(scratch_buf, scratch_len, *p);   \
+        }                                               \
+    }
+
+#define SPILL_TOKEN()                           \
+    {                                           \
+        if (token && !spillToken()) {           \
+            TRACE_YAML("STRING_OVERFLOW");      \
+            return STRING_OVERFLOW;             \
+        }                                       \
+    }
+
     const char* c   = buffer;
     const char* end = c + size;
 
@@ -153,7 +193,7 @@ YamlParser::parse(const char* buffer, unsigned int size)
                 state = ps_AttrQuo;
                 break;
             }
-            CONCAT_STR(scratch_buf, scratch_len, *c);
+            PUSH_CHAR(c);
             break;
 
         case ps_AttrQuo:
@@ -166,20 +206,21 @@ YamlParser::parse(const char* buffer, unsigned int size)
 
         case ps_Attr:
             if (*c == '\"') {
+                SPILL_TOKEN();
                 state = ps_AttrQuo;
                 break;
             }
             if ((*c != ':') && (*c != '\r') && (*c != '\n'))
-                CONCAT_STR(scratch_buf, scratch_len, *c);
+                PUSH_CHAR(c);
             // trap
         case ps_AttrSP:
             if (*c == '\r' || *c == '\n') {
                 if (state == ps_Attr) {
                     // TODO: trim spaces at the end?
-                    node_found = calls->find_node(ctx, scratch_buf, scratch_len);
+                    node_found = calls->find_node(ctx, tokenBuf(), tokenLen());
                     if (!node_found) {
                         TRACE_YAML("YAML_PARSER: Could not find node '%.*s' (2)\n",
-                              scratch_len, scratch_buf);
+                              tokenLen(), tokenBuf());
                     }
                 }
                 saved_state = state;
@@ -189,10 +230,10 @@ YamlParser::parse(const char* buffer, unsigned int size)
             if (*c == ':') {
                 if (state == ps_Attr) {
                     // TODO: trim spaces at the end?
-                    node_found = calls->find_node(ctx, scratch_buf, scratch_len);
+                    node_found = calls->find_node(ctx, tokenBuf(), tokenLen());
                     if (!node_found) {
                         TRACE_YAML("YAML_PARSER: Could not find node '%.*s' (3)\n",
-                              scratch_len, scratch_buf);
+                              tokenLen(), tokenBuf());
                     }
                 }
                 state = ps_Sep;
@@ -210,6 +251,8 @@ YamlParser::parse(const char* buffer, unsigned int size)
             }
             state = ps_Val;
             scratch_len = 0;
+            token = nullptr;
+            token_len = 0;
             if (*c == '\"') {
                 state = ps_ValQuo;
                 break;
@@ -218,7 +261,7 @@ YamlParser::parse(const char* buffer, unsigned int size)
                 state = ps_ValEsc;
                 break;
             }
-            CONCAT_STR(scratch_buf, scratch_len, *c);
+            PUSH_CHAR(c);
             break;
 
         case ps_ValQuo:
@@ -279,21 +322,23 @@ YamlParser::parse(const char* buffer, unsigned int size)
                 // set attribute
                 if (node_found) {
                     // TODO: trim spaces at the end?
-                    calls->set_attr(ctx, scratch_buf, scratch_len);
+                    calls->set_attr(ctx, tokenBuf(), tokenLen());
                 }
                 saved_state = state;
                 state = ps_CRLF;
                 continue;
             }
             if (*c == '\"') {
+                SPILL_TOKEN();
                 state = ps_ValQuo;
                 break;
             }
             if (*c == '\\') {
+                SPILL_TOKEN();
                 state = ps_ValEsc;
                 break;
             }
-            CONCAT_STR(scratch_buf, scratch_len, *c);
+            PUSH_CHAR(c);
             break;
 
         case ps_ValEsc:
@@ -318,9 +363,12 @@ YamlParser::parse(const char* buffer, unsigned int size)
 
     if ((state == ps_Val) && eof && node_found) {
         // TODO: trim spaces at the end?
-        calls->set_attr(ctx, scratch_buf, scratch_len);
+        calls->set_attr(ctx, tokenBuf(), tokenLen());
     }
-    
+
+    // the chunk is not valid anymore after returning
+    SPILL_TOKEN();
+
     return CONTINUE_PARSING;
 }
 
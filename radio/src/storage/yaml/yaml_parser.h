@@ -32,8 +32,8 @@ struct YamlParserCalls
     bool (*to_parent)    (void* ctx);
     bool (*to_child)     (void* ctx);
     bool (*to_next_elmt) (void* ctx);
-    bool (*find_node)    (void* ctx, char* buf, uint8_t len);
-    void (*set_attr)     (void* ctx, char* buf, uint16_t len);
+    bool (*find_node)    (void* ctx, const char* buf, uint8_t len);
+    void (*set_attr)     (void* ctx, const char* buf, uint16_t len);
 };
 
 class YamlParser
@@ -67,11 +67,16 @@ class YamlParser
     uint8_t state;
     uint8_t saved_state;
 
-    // scratch buffer w/ 16 bytes
-    // used for attribute and values
+    // scratch buffer used for attributes and values
+    // that cross a chunk boundary or need decoding
     char    scratch_buf[MAX_STR];
     uint16_t scratch_len;
 
+    // attribute or value still in the caller's chunk
+    // (not copied, only valid during parse())
+    const char* token;
+    uint16_t    token_len;
+
     bool node_found;
     bool eof;
 
@@ -82,6 +87,13 @@ class YamlParser
     // Reset parser state for next line
     void reset();
 
+    // Move the in-place token into the scratch buffer
+    bool spillToken();
+
+    // Current attribute or value
+    const char* tokenBuf() const { return token ? token : scratch_buf; }
+    uint16_t    tokenLen() const { return token ? token_len : scratch_len; }
+
     bool    toChild();
     bool    toParent();
     uint8_t getLastIndent();
@@ -98,6 +110,8 @@ public:
 
     void init(const YamlParserCalls* parser_calls, void* parser_ctx);
 
+    // Values fully contained in 'buffer' are passed to the
+    // callbacks without being copied
     YamlResult parse(const char* buffer, unsigned int size);
 
     void set_eof() { eof = true; }
@@ -627,24 +627,142 @@ bool getSwitch(swsrc_t swtch, uint8_t flags)
   return swtch > 0 ? result : !result;
 }
 
+// Logical switches evaluation plan, rebuilt by the mixer the first time it
+// runs after lswPlanInvalidate() has been called, like the mixes plan.
+//
+// Only the used switches are evaluated, still in index order: a switch
+// reading a later one gets its state of the previous cycle, as before.
+// Stateless switches (AND, OR, XOR without delay nor duration) depending
+// only on other logical switches, flight modes or constants are event
+// driven: they are evaluated again only when one of these logical switches
+// changed during this cycle or the previous one. Each flight mode context
+// is first evaluated completely after a rebuild or a state reset.
+#define LSW_PLAN_NO_INPUT 0xFF
+
+struct LogicalSwitchPlanEntry {
+  uint8_t idx;
+  uint8_t inputs[3];  // logical switches inputs of event driven switches
+};
+
+static LogicalSwitchPlanEntry lswPlan[MAX_LOGICAL_SWITCHES];
+static uint8_t lswPlanCount = 0;
+static volatile bool lswPlanValid = false;
+static uint64_t lswEventDriven = 0;
+static uint16_t lswFmSettled = 0;
+static uint64_t lswFmChanges[MAX_FLIGHT_MODES];
+
+void lswPlanInvalidate()
+{
+  lswPlanValid = false;
+}
+
+// returns the logical switch index of an event source, LSW_PLAN_NO_INPUT for
+// a constant, or -1 when the source must be polled
+static int lswEventInput(swsrc_t swtch)
+{
+  swtch = abs(swtch);
+  if (swtch >= SWSRC_FIRST_LOGICAL_SWITCH && swtch <= SWSRC_LAST_LOGICAL_SWITCH)
+    return swtch - SWSRC_FIRST_LOGICAL_SWITCH;
+  // a flight mode is constant for each flight mode context
+  if (swtch == SWSRC_NONE || swtch == SWSRC_ON ||
+      (swtch >= SWSRC_FIRST_FLIGHT_MODE && swtch <= SWSRC_LAST_FLIGHT_MODE))
+    return LSW_PLAN_NO_INPUT;
+  return -1;
+}
+
+static void lswPlanBuild()
+{
+  // set before scanning: an invalidation during the scan triggers a new build
+  lswPlanValid = true;
+
+  uint8_t count = 0;
+  uint64_t eventDriven = 0;
+  for (uint8_t idx = 0; idx < MAX_LOGICAL_SWITCHES; idx++) {
+    LogicalSwitchData * ls = lswAddress(idx);
+    if (ls->func == LS_FUNC_NONE)
+      continue;
+
+    LogicalSwitchPlanEntry & entry = lswPlan[count++];
+    entry.idx = idx;
+    memset(entry.inputs, LSW_PLAN_NO_INPUT, sizeof(entry.inputs));
+
+    if (lswFamily(ls->func) == LS_FAMILY_BOOL && !ls->delay && !ls->duration) {
+      int inputs[3] = { lswEventInput(ls->andsw), lswEventInput(ls->v1), lswEventInput(ls->v2) };
+      if (inputs[0] >= 0 && inputs[1] >= 0 && inputs[2] >= 0) {
+        for (uint8_t i = 0; i < 3; i++)
+          entry.inputs[i] = inputs[i];
+        eventDriven |= (uint64_t)1 << idx;
+      }
+    }
+  }
+
+  lswPlanCount = count;
+  lswEventDriven = eventDriven;
+  lswFmSettled = 0;
+}
+
+static bool evalLogicalSwitch(uint8_t idx, bool isCurrentFlightmode)
+{
+  LogicalSwitchContext & context = lswFm[mixerCurrentFlightMode].lsw[idx];
+  bool result = getLogicalSwitch(idx);
+  if (isCurrentFlightmode) {
+    if (result) {
+      if (!context.state) PLAY_LOGICAL_SWITCH_ON(idx);
+    }
+    else {
+      if (context.state) PLAY_LOGICAL_SWITCH_OFF(idx);
+    }
+  }
+  bool changed = (context.state != result);
+  context.state = result;
+  return changed;
+}
+
 /**
   @brief Calculates new state of logical switches for mixerCurrentFlightMode
 */
 void evalLogicalSwitches(bool isCurrentFlightmode)
 {
-  for (unsigned int idx=0; idx<MAX_LOGICAL_SWITCHES; idx++) {
-    LogicalSwitchContext & context = lswFm[mixerCurrentFlightMode].lsw[idx];
-    bool result = getLogicalSwitch(idx);
-    if (isCurrentFlightmode) {
-      if (result) {
-        if (!context.state) PLAY_LOGICAL_SWITCH_ON(idx);
-      }
-      else {
-        if (context.state) PLAY_LOGICAL_SWITCH_OFF(idx);
+  if (!lswPlanValid)
+    lswPlanBuild();
+
+  uint8_t fm = mixerCurrentFlightMode;
+
+  if (!(lswFmSettled & (1 << fm))) {
+    // unused switches are settled by this pass and skipped afterwards
+    for (uint8_t idx = 0; idx < MAX_LOGICAL_SWITCHES; idx++) {
+      evalLogicalSwitch(idx, isCurrentFlightmode);
+    }
+    lswFmSettled |= (1 << fm);
+    // switches reading a later one are evaluated again in the next cycle
+    lswFmChanges[fm] = (uint64_t)-1;
+    return;
+  }
+
+  uint64_t previousChanges = lswFmChanges[fm];
+  uint64_t changes = 0;
+
+  for (uint8_t p = 0; p < lswPlanCount; p++) {
+    const LogicalSwitchPlanEntry & entry = lswPlan[p];
+    uint8_t idx = entry.idx;
+
+    if (lswEventDriven & ((uint64_t)1 << idx)) {
+      uint64_t pending = previousChanges | changes;
+      bool dirty = false;
+      for (uint8_t i = 0; i < 3; i++) {
+        uint8_t input = entry.inputs[i];
+        if (input != LSW_PLAN_NO_INPUT && (pending & ((uint64_t)1 << input)))
+          dirty = true;
       }
+      if (!dirty)
+        continue;
     }
-    context.state = result;
+
+    if (evalLogicalSwitch(idx, isCurrentFlightmode))
+      changes |= (uint64_t)1 << idx;
   }
+
+  lswFmChanges[fm] = changes;
 }
 
 swarnstate_t switches_states = 0;
@@ -1014,6 +1132,7 @@ int16_t lswTimerValue(delayval_t val)
 void logicalSwitchesReset()
 {
   memset(lswFm, 0, sizeof(lswFm));
+  lswFmSettled = 0;
 
   for (uint8_t fm=0; fm<MAX_FLIGHT_MODES; fm++) {
     for (uint8_t i=0; i<MAX_LOGICAL_SWITCHES; i++) {
@@ -1034,4 +1153,5 @@ getvalue_t convertLswTelemValue(LogicalSwitchData * ls)
 void logicalSwitchesCopyState(uint8_t src, uint8_t dst)
 {
   lswFm[dst] = lswFm[src];
+  lswFmSettled &= ~(1 << dst);
 }
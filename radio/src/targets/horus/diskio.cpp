@@ -29,6 +29,10 @@
 #include "debug.h"
 #include "targets/common/arm/stm32/sdio_sd.h"
 
+#if defined(DISK_CACHE)
+  #include "disk_cache.h"
+#endif
+
 #include <string.h>
 
 /*-----------------------------------------------------------------------*/
@@ -296,6 +300,11 @@ DRESULT disk_ioctl (
       break;
 
     case CTRL_SYNC:
+#if defined(DISK_CACHE)
+      // sectors held back by the write-back cache go first
+      if (diskCache.flush(drv) != RES_OK)
+        break;
+#endif
       while (SD_GetStatus() == SD_TRANSFER_BUSY); /* Complete pending write process (needed at _FS_READONLY == 0) */
       res = RES_OK;
       break;
@@ -387,6 +396,12 @@ void sdDone()
     f_close(&g_bluetoothFile);
 #endif
 
+#if defined(DISK_CACHE)
+    // FatFs only calls into the cache under its lock
+    RTOS_LOCK_MUTEX(ioMutex);
+    diskCache.flush(0);
+    RTOS_UNLOCK_MUTEX(ioMutex);
+#endif
     f_mount(nullptr, "", 0); // unmount SD
   }
 }
@@ -550,16 +550,19 @@ void OpenTxSimulator::checkOutputsChanged()
   const uint8_t phase = getFlightMode();  // opentx.cpp
   const uint8_t mode = getStickMode();
 
+  ChannelsSnapshot channels;
+  getChannelsSnapshot(channels);
+
   for (i=0; i < chansDim; i++) {
-    if (lastOutputs.chans[i] != channelOutputs[i] || m_resetOutputsData) {
-      emit channelOutValueChange(i, channelOutputs[i], (g_model.extendedLimits ? limit * LIMIT_EXT_PERCENT / 100 : limit));
-      emit outputValueChange(OUTPUT_SRC_CHAN_OUT, i, channelOutputs[i]);
-      lastOutputs.chans[i] = channelOutputs[i];
+    if (lastOutputs.chans[i] != channels.outputs[i] || m_resetOutputsData) {
+      emit channelOutValueChange(i, channels.outputs[i], (g_model.extendedLimits ? limit * LIMIT_EXT_PERCENT / 100 : limit));
+      emit outputValueChange(OUTPUT_SRC_CHAN_OUT, i, channels.outputs[i]);
+      lastOutputs.chans[i] = channels.outputs[i];
     }
-    if (lastOutputs.ex_chans[i] != ex_chans[i] || m_resetOutputsData) {
-      emit channelMixValueChange(i, ex_chans[i], limit * 2);
-      emit outputValueChange(OUTPUT_SRC_CHAN_MIX, i, ex_chans[i]);
-      lastOutputs.ex_chans[i] = ex_chans[i];
+    if (lastOutputs.ex_chans[i] != channels.mixes[i] || m_resetOutputsData) {
+      emit channelMixValueChange(i, channels.mixes[i], limit * 2);
+      emit outputValueChange(OUTPUT_SRC_CHAN_MIX, i, channels.mixes[i]);
+      lastOutputs.ex_chans[i] = channels.mixes[i];
     }
   }
 
@@ -60,8 +60,27 @@ void lcdCopy(void * dest, void * src);
 
 FATFS g_FATFS_Obj;
 
+// When enabled, the time only moves forward with simuAdvanceClock() / simuSleep(),
+// so that a headless run is deterministic and not bound to the wall clock
+static bool simuVirtualClock = false;
+static uint64_t simuVirtualMicros = 0;
+
+void simuSetVirtualClock(bool enabled)
+{
+  simuVirtualClock = enabled;
+  simuVirtualMicros = 0;
+}
+
+void simuAdvanceClock(uint32_t us)
+{
+  simuVirtualMicros += us;
+}
+
 uint64_t simuTimerMicros(void)
 {
+  if (simuVirtualClock)
+    return simuVirtualMicros;
+
 #if SIMPGMSPC_USE_QT
   static QElapsedTimer ticker;
   if (!ticker.isValid())
@@ -263,6 +282,11 @@ bool simuIsRunning()
 
 uint8_t simuSleep(uint32_t ms)
 {
+  if (simuVirtualClock) {
+    simuAdvanceClock(ms * 1000);
+    return simu_shutdown ? 1 : 0;
+  }
+
   for (uint32_t i = 0; i < ms; ++i){
     if (simu_shutdown || !simu_running)
       return 1;
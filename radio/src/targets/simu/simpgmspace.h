@@ -204,6 +204,8 @@ inline void getADC() { }
 
 uint64_t simuTimerMicros(void);
 uint8_t simuSleep(uint32_t ms);  // returns true if thread shutdown requested
+void simuSetVirtualClock(bool enabled);
+void simuAdvanceClock(uint32_t us);
 
 void simuSetKey(uint8_t key, bool state);
 void simuSetTrim(uint8_t trim, bool state);
@@ -146,7 +146,11 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff)
   switch(cmd) {
 /* Generic command (Used by FatFs) */
     case CTRL_SYNC :     /* Complete pending write process (needed at _FS_READONLY == 0) */
+#if defined(DISK_CACHE)
+      return diskCache.flush(pdrv);
+#else
       break;
+#endif
 
     case GET_SECTOR_COUNT: /* Get media size (needed at _USE_MKFS == 1) */
       {
@@ -238,6 +242,16 @@ void sdDone()
 #endif
 #if defined(LOG_BLUETOOTH)
     f_close(&g_bluetoothFile);
+#endif
+#if defined(DISK_CACHE)
+    // FatFs only calls into the cache under its lock
+    RTOS_LOCK_MUTEX(ioMutex);
+    diskCache.flush(0);
+    RTOS_UNLOCK_MUTEX(ioMutex);
+    const DiskCacheStats & stats = diskCache.getStats();
+    TRACE_SIMPGMSPACE("disk cache: w: %u, r: %u, h: %u, m: %u, dirty: %u, flushes: %u (%u writes)",
+                      stats.noWrites, stats.noHits + stats.noMisses, stats.noHits, stats.noMisses,
+                      stats.noDirty, stats.noFlushes, stats.noFlushWrites);
 #endif
     f_mount(NULL, "", 0); // unmount SD
   }
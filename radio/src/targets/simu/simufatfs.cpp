@@ -44,10 +44,12 @@
   #include <direct.h>
   #include <stdlib.h>
   #include <sys/utime.h>
+  #include <io.h>
   #define mkdir(s, f) _mkdir(s)
 #else
   #include <sys/time.h>
   #include <utime.h>
+  #include <unistd.h>
 #endif
 
 #include "ff.h"
@@ -136,6 +138,7 @@ bool redirectToSettingsDirectory(const std::string & path)
 #if defined(SDCARD_YAML)
     if (path == MODELSLIST_YAML_PATH || path == RADIO_SETTINGS_YAML_PATH || path == RADIO_SETTINGS_TMPFILE_YAML_PATH || path == RADIO_SETTINGS_ERRORFILE_YAML_PATH)
       return true;
+    if (path == LABELSLIST_INDEX_PATH) return true;
     if (startsWith(path, MODELS_PATH) && endsWith(path, YAML_EXT)) return true;
 #endif
   }
@@ -385,6 +388,22 @@ FRESULT f_lseek (FIL* fil, DWORD offset)
   return FR_OK;
 }
 
+FRESULT f_truncate (FIL* fil)
+{
+  if (fil && fil->obj.fs) {
+    FILE * fp = (FILE*)fil->obj.fs;
+    fflush(fp);
+#if MSVC_BUILD
+    int result = _chsize(_fileno(fp), ftell(fp));
+#else
+    int result = ftruncate(fileno(fp), ftell(fp));
+#endif
+    TRACE_SIMPGMSPACE("f_truncate(%p) at %ld = %d", fil->obj.fs, ftell(fp), result);
+    if (result) return FR_DISK_ERR;
+  }
+  return FR_OK;
+}
+
 UINT f_size(FIL* fil)
 {
   if (fil && fil->obj.fs) {
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "opentx.h"
+#include "simuheadless.h"
+
+#include <algorithm>
+#include <fstream>
+
+bool HeadlessSimulator::loadTimeline(const char * path)
+{
+  std::ifstream file(path);
+  if (!file) {
+    error = std::string("cannot open ") + path;
+    return false;
+  }
+
+  std::string line;
+  unsigned lineNumber = 0;
+  while (std::getline(file, line)) {
+    if (!parseTimeline(line.c_str(), ++lineNumber))
+      return false;
+  }
+
+  return true;
+}
+
+bool HeadlessSimulator::parseTimeline(const char * line, unsigned lineNumber)
+{
+  char command[16];
+  unsigned time;
+  int index = 0, value = 0;
+
+  int count = sscanf(line, "%u %15s %d %d", &time, command, &index, &value);
+  if (count <= 0 || line[strspn(line, " \t")] == '#') {
+    // empty line or comment
+    return true;
+  }
+
+  HeadlessEvent event = { time, HEADLESS_EVENT_END, (uint8_t)index, value };
+  unsigned indexMax = 0;
+
+  if (count >= 2 && !strcmp(command, "end")) {
+    event.type = HEADLESS_EVENT_END;
+  }
+  else if (count < 4) {
+    error = "line " + std::to_string(lineNumber) + ": expected '<time> <command> <index> <value>'";
+    return false;
+  }
+  else if (!strcmp(command, "ana")) {
+    event.type = HEADLESS_EVENT_ANALOG;
+    event.value = limit<int32_t>(-RESX, value, RESX);
+    indexMax = NUM_STICKS + NUM_POTS + NUM_SLIDERS;
+  }
+  else if (!strcmp(command, "switch")) {
+    event.type = HEADLESS_EVENT_SWITCH;
+    event.value = limit<int32_t>(-1, value, 1);
+    indexMax = NUM_SWITCHES;
+  }
+  else if (!strcmp(command, "key")) {
+    event.type = HEADLESS_EVENT_KEY;
+    indexMax = NUM_KEYS;
+  }
+  else if (!strcmp(command, "sensor")) {
+    event.type = HEADLESS_EVENT_SENSOR;
+    indexMax = MAX_TELEMETRY_SENSORS;
+  }
+  else {
+    error = "line " + std::to_string(lineNumber) + ": unknown command '" + command + "'";
+    return false;
+  }
+
+  if (event.type != HEADLESS_EVENT_END && (index < 0 || (unsigned)index >= indexMax)) {
+    error = "line " + std::to_string(lineNumber) + ": index out of range";
+    return false;
+  }
+
+  // events after the end would never be applied
+  if (event.type == HEADLESS_EVENT_END ? event.time < duration : (hasEnd && event.time > duration)) {
+    error = "line " + std::to_string(lineNumber) + ": event after the end";
+    return false;
+  }
+
+  // keep the events sorted, in the file order for the same time
+  auto position = std::upper_bound(events.begin(), events.end(), event,
+      [](const HeadlessEvent & a, const HeadlessEvent & b) { return a.time < b.time; });
+  events.insert(position, event);
+
+  if (event.type == HEADLESS_EVENT_END) {
+    hasEnd = true;
+    duration = event.time;
+  }
+  else if (event.time > duration) {
+    duration = event.time;
+  }
+
+  return true;
+}
+
+void HeadlessSimulator::applyEvent(const HeadlessEvent & event)
+{
+  switch (event.type) {
+    case HEADLESS_EVENT_ANALOG:
+      // the simulator doesn't apply the calibration (see evalInputs()),
+      // anaIn() values are used as calibrated ones, except for the
+      // multi-position pots which are read as 0..2048
+      if (analogs)
+        analogs[event.index] = (IS_POT_MULTIPOS(event.index) ? event.value + RESX : event.value);
+      break;
+
+    case HEADLESS_EVENT_SWITCH:
+      simuSetSwitch(event.index, event.value);
+      break;
+
+    case HEADLESS_EVENT_KEY:
+      simuSetKey(event.index, event.value != 0);
+      break;
+
+    case HEADLESS_EVENT_SENSOR:
+    {
+      const TelemetrySensor & sensor = g_model.telemetrySensors[event.index];
+      telemetryItems[event.index].setValue(sensor, event.value, sensor.unit, sensor.prec);
+      telemetryItemChanged(event.index);
+      break;
+    }
+  }
+}
+
+void HeadlessSimulator::run(uint32_t endTime, uint32_t recordPeriod, const Recorder & recorder)
+{
+  auto event = events.begin();
+
+  for (uint32_t now = 0; now <= endTime; now++) {
+    while (event != events.end() && event->time <= now) {
+      applyEvent(*event++);
+    }
+
+    if (now % 10 == 0) {
+      per10ms();
+    }
+
+    if (now % mixerPeriod == 0) {
+      doMixerCalculations();
+      doMixerPeriodicUpdates();
+    }
+
+    if (recordPeriod && now % recordPeriod == 0 && recorder) {
+      recorder(now, channelOutputs);
+    }
+
+    // 1ms steps
+    simuAdvanceClock(1000);
+  }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _SIMUHEADLESS_H_
+#define _SIMUHEADLESS_H_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "mixer_scheduler.h"
+
+enum HeadlessEventType {
+  HEADLESS_EVENT_ANALOG,
+  HEADLESS_EVENT_SWITCH,
+  HEADLESS_EVENT_KEY,
+  HEADLESS_EVENT_SENSOR,
+  HEADLESS_EVENT_END,
+};
+
+struct HeadlessEvent {
+  uint32_t time;  // ms
+  uint8_t type;
+  uint8_t index;
+  int32_t value;
+};
+
+// Runs the mixer back to back on the simulator virtual clock, feeding the
+// inputs and telemetry from a scripted timeline:
+//
+//   # time(ms) command index value
+//   0     ana     0  0
+//   500   ana     0  1024
+//   600   switch  1  -1
+//   700   key     0  1
+//   800   sensor  0  1250
+//   2000  end
+//
+// 'ana' values are the calibrated -1024..1024 values of the sticks / pots
+// (the simulator has no calibration, as if it was neutral), 'switch' values
+// are -1 / 0 / 1, 'sensor' values are the raw telemetry values of the model
+// sensor at this index. Events after 'end' are rejected.
+class HeadlessSimulator
+{
+  public:
+    typedef std::function<void(uint32_t time, const int16_t * channels)> Recorder;
+
+    bool loadTimeline(const char * path);
+    bool parseTimeline(const char * line, unsigned lineNumber = 0);
+
+    const std::string & getError() const
+    {
+      return error;
+    }
+
+    const std::vector<HeadlessEvent> & getEvents() const
+    {
+      return events;
+    }
+
+    // the 'end' event time, or the time of the last event
+    uint32_t getDuration() const
+    {
+      return duration;
+    }
+
+    // the analog values returned by anaIn(), owned by the executable
+    void setAnalogs(uint16_t * values)
+    {
+      analogs = values;
+    }
+
+    void setMixerPeriod(uint32_t ms)
+    {
+      mixerPeriod = ms ? ms : 1;
+    }
+
+    // runs the timeline from the time 0 up to (and including) the given time,
+    // the recorder is called every recordPeriod ms with the channel outputs
+    void run(uint32_t endTime, uint32_t recordPeriod, const Recorder & recorder);
+
+  protected:
+    std::vector<HeadlessEvent> events;
+    std::string error;
+    uint16_t * analogs = nullptr;
+    uint32_t duration = 0;
+    bool hasEnd = false;
+    uint32_t mixerPeriod = MIXER_SCHEDULER_DEFAULT_PERIOD_US / 1000;
+
+    void applyEvent(const HeadlessEvent & event);
+};
+
+#endif // _SIMUHEADLESS_H_
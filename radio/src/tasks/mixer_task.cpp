@@ -22,6 +22,7 @@
 #include "tasks.h"
 #include "mixer_task.h"
 #include "mixer_scheduler.h"
+#include "mixer_stats.h"
 
 #include "opentx.h"
 
@@ -69,6 +70,7 @@ bool mixerTaskStarted()
 
 void mixerTaskStart()
 {
+  mixerLatencyRestart();
   _mixer_started = true;
   _mixer_running = true;
 }
@@ -185,13 +187,16 @@ TASK_FUNCTION(mixerTask)
 
     if (_mixer_running) {
 
-      uint16_t t0 = getTmr2MHz();
+      MixerLatencyTime cycleStart = mixerLatencyNow();
+      uint16_t t0 = cycleStart.tmr2MHz;
 
       DEBUG_TIMER_START(debugTimerMixer);
       mixerTaskLock();
 
       doMixerCalculations();
+      MixerLatencyTime pulsesStart = mixerLatencyNow();
       pulsesSendChannels();
+      mixerLatencyUpdate(cycleStart, pulsesStart, mixerLatencyNow());
       doMixerPeriodicUpdates();
 
       // TODO: what are these for???
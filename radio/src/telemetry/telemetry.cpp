@@ -292,12 +292,7 @@ void telemetryWakeup()
   }
   _telemetryIsPolling = false;
 
-  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
-    const TelemetrySensor & sensor = g_model.telemetrySensors[i];
-    if (sensor.type == TELEM_TYPE_CALCULATED) {
-      telemetryItems[i].eval(sensor);
-    }
-  }
+  evalCalculatedTelemetrySensors();
 
 #if defined(VARIO)
   if (TELEMETRY_STREAMING() && !IS_FAI_ENABLED()) {
@@ -319,6 +314,7 @@ void telemetryWakeup()
           TelemetrySensor * sensor = & g_model.telemetrySensors[i];
           if (sensor->unit != UNIT_DATETIME) {
             item.setOld();
+            telemetryItemChanged(i);
             sensorLost = true;
           }
         }
@@ -387,7 +383,13 @@ void telemetryInterrupt10ms()
     for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
       const TelemetrySensor & sensor = g_model.telemetrySensors[i];
       if (sensor.type == TELEM_TYPE_CALCULATED) {
-        telemetryItems[i].per10ms(sensor);
+        TelemetryItem & item = telemetryItems[i];
+        int32_t value = item.value;
+        int8_t timeout = item.timeout;
+        item.per10ms(sensor);
+        if (item.value != value || item.timeout != timeout) {
+          telemetryItemChanged(i);
+        }
       }
       if (tick160ms && telemetryItems[i].timeout > 0) {
         telemetryItems[i].timeout--;
@@ -399,9 +401,10 @@ void telemetryInterrupt10ms()
 #if !defined(SIMU)
     telemetryData.rssi.reset();
 #endif
-    for (auto & telemetryItem: telemetryItems) {
-      if (telemetryItem.isAvailable()) {
-        telemetryItem.setOld();
+    for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+      if (telemetryItems[i].isAvailable()) {
+        telemetryItems[i].setOld();
+        telemetryItemChanged(i);
       }
     }
   }
@@ -411,8 +414,9 @@ void telemetryReset()
 {
   telemetryData.clear();
 
-  for (auto & telemetryItem : telemetryItems) {
-    telemetryItem.clear();
+  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    telemetryItems[i].clear();
+    telemetryItemChanged(i);
   }
 
   telemetryStreaming = 0; // reset counter only if valid telemetry packets are being detected
@@ -113,6 +113,8 @@ PACK(struct CellValue
 });
 
 int setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t subId, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec);
+int findTelemetrySensors(TelemetryProtocol protocol, uint16_t id, uint8_t subId, uint8_t instance, uint8_t * indexes);
+void telemetrySensorsIndexInvalidate();
 int setTelemetryText(TelemetryProtocol protocol, uint16_t id, uint8_t subId, uint8_t instance, const char * text);
 void delTelemetryIndex(uint8_t index);
 int availableTelemetryIndex();
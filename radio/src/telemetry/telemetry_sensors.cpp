@@ -22,6 +22,7 @@
 #include "opentx.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <atomic>
 
 #if defined(LIBOPENUI)
   #include "libopenui.h"
@@ -259,6 +260,7 @@ void TelemetryItem::setValue(const TelemetrySensor &sensor, int32_t val,
       TelemetryItem & item = telemetryItems[i];
       int32_t increment = it.getValue(val, unit, prec);
       item.setValue(it, item.value+increment, it.unit, it.prec);
+      telemetryItemChanged(i);
     }
   }
 
@@ -466,6 +468,8 @@ void delTelemetryIndex(uint8_t index)
 {
   memclear(&g_model.telemetrySensors[index], sizeof(TelemetrySensor));
   telemetryItems[index].clear();
+  telemetryItemChanged(index);
+  telemetrySensorsIndexInvalidate();
   storageDirty(EE_MODEL);
 }
 
@@ -491,34 +495,275 @@ int lastUsedTelemetryIndex()
   return -1;
 }
 
-template <class T>
-int setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t subId,
-                      uint8_t instance, T value, uint32_t unit = 0,
-                      uint32_t prec = 0)
+// Index of the custom sensors, hashed on (id, subId). Each bucket is a chain
+// of sensor indexes in ascending order, linked through telemetrySensorsNext[]
+#define TELEMETRY_SENSORS_HASH_SIZE    32
+#define TELEMETRY_SENSORS_HASH_END     0xFF
+
+static uint8_t telemetrySensorsHash[TELEMETRY_SENSORS_HASH_SIZE];
+static uint8_t telemetrySensorsNext[MAX_TELEMETRY_SENSORS];
+static volatile bool telemetrySensorsIndexValid = false;
+
+// Calculated sensors handled by eval(), each one after its sources
+static uint8_t telemetryCalculatedOrder[MAX_TELEMETRY_SENSORS];
+static uint8_t telemetryCalculatedCount = 0;
+
+// Items which got a new value or state since the last evaluation. They are
+// flagged from the telemetry task and from the 10ms interrupt, hence the
+// atomic words
+static std::atomic<uint32_t> telemetryItemsChanged[2];
+
+void telemetryItemChanged(uint8_t index)
+{
+  if (index < MAX_TELEMETRY_SENSORS) {
+    telemetryItemsChanged[index / 32].fetch_or((uint32_t)1 << (index % 32));
+  }
+}
+
+static void telemetryItemsChangedAll()
+{
+  telemetryItemsChanged[0] = (uint32_t)-1;
+  telemetryItemsChanged[1] = (uint32_t)-1;
+}
+
+static bool isEvaluatedTelemetrySensor(const TelemetrySensor & sensor)
+{
+  if (sensor.type != TELEM_TYPE_CALCULATED)
+    return false;
+
+  switch (sensor.formula) {
+    case TELEM_FORMULA_ADD:
+    case TELEM_FORMULA_AVERAGE:
+    case TELEM_FORMULA_MIN:
+    case TELEM_FORMULA_MAX:
+    case TELEM_FORMULA_MULTIPLY:
+    case TELEM_FORMULA_CELL:
+    case TELEM_FORMULA_DIST:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the number of sensors read by eval() for a calculated sensor
+static uint8_t getCalculatedSensorSources(const TelemetrySensor & sensor, uint8_t * sources)
 {
-  bool sensorFound = false;
+  uint8_t count = 0;
+
+  switch (sensor.formula) {
+    case TELEM_FORMULA_CELL:
+      if (sensor.cell.source)
+        sources[count++] = sensor.cell.source - 1;
+      break;
+
+    case TELEM_FORMULA_DIST:
+      if (sensor.dist.gps)
+        sources[count++] = sensor.dist.gps - 1;
+      if (sensor.dist.alt)
+        sources[count++] = sensor.dist.alt - 1;
+      break;
+
+    default:
+    {
+      int maxitems = (sensor.formula == TELEM_FORMULA_MULTIPLY ? 2 : 4);
+      for (int i = 0; i < maxitems; i++) {
+        if (sensor.calc.sources[i])
+          sources[count++] = abs(sensor.calc.sources[i]) - 1;
+      }
+      break;
+    }
+  }
 
+  return count;
+}
+
+static void telemetryCalculatedOrderBuild()
+{
+  uint64_t pending = 0;
   for (int index = 0; index < MAX_TELEMETRY_SENSORS; index++) {
-    TelemetrySensor &telemetrySensor = g_model.telemetrySensors[index];
+    if (isEvaluatedTelemetrySensor(g_model.telemetrySensors[index]))
+      pending |= (uint64_t)1 << index;
+  }
 
-    if (telemetrySensor.type == TELEM_TYPE_CUSTOM && telemetrySensor.id == id &&
-        telemetrySensor.subId == subId &&
-        (telemetrySensor.isSameInstance(protocol, instance) ||
-         g_model.ignoreSensorIds)) {
+  uint8_t count = 0;
+  bool progress = true;
+  while (pending && progress) {
+    progress = false;
+    for (int index = 0; index < MAX_TELEMETRY_SENSORS; index++) {
+      uint64_t mask = (uint64_t)1 << index;
+      if (!(pending & mask))
+        continue;
+      uint8_t sources[4];
+      uint8_t sourcesCount = getCalculatedSensorSources(g_model.telemetrySensors[index], sources);
+      bool ready = true;
+      for (uint8_t i = 0; i < sourcesCount; i++) {
+        if (sources[i] < MAX_TELEMETRY_SENSORS && (pending & ((uint64_t)1 << sources[i])))
+          ready = false;
+      }
+      if (ready) {
+        telemetryCalculatedOrder[count++] = index;
+        pending &= ~mask;
+        progress = true;
+      }
+    }
+  }
 
-      telemetryItems[index].setValue(telemetrySensor, value, unit, prec);
-      sensorFound = true;
+  // sensors in a loop are evaluated last, in index order
+  for (int index = 0; index < MAX_TELEMETRY_SENSORS; index++) {
+    if (pending & ((uint64_t)1 << index))
+      telemetryCalculatedOrder[count++] = index;
+  }
+
+  telemetryCalculatedCount = count;
+}
+
+static inline uint8_t telemetrySensorHash(uint16_t id, uint8_t subId)
+{
+  return (id ^ (id >> 4) ^ (id >> 9) ^ (subId << 1)) & (TELEMETRY_SENSORS_HASH_SIZE - 1);
+}
+
+void telemetrySensorsIndexInvalidate()
+{
+  telemetrySensorsIndexValid = false;
+}
+
+static void telemetrySensorsIndexBuild()
+{
+  // set before scanning: an invalidation during the scan triggers a new build
+  telemetrySensorsIndexValid = true;
+
+  memset(telemetrySensorsHash, TELEMETRY_SENSORS_HASH_END, sizeof(telemetrySensorsHash));
+  for (int index = MAX_TELEMETRY_SENSORS - 1; index >= 0; index--) {
+    const TelemetrySensor & telemetrySensor = g_model.telemetrySensors[index];
+    if (telemetrySensor.type == TELEM_TYPE_CUSTOM) {
+      uint8_t hash = telemetrySensorHash(telemetrySensor.id, telemetrySensor.subId);
+      telemetrySensorsNext[index] = telemetrySensorsHash[hash];
+      telemetrySensorsHash[hash] = index;
+    }
+    else {
+      telemetrySensorsNext[index] = TELEMETRY_SENSORS_HASH_END;
+    }
+  }
+
+  telemetryCalculatedOrderBuild();
+
+  // the sensors configuration changed, all calculated sensors are evaluated
+  telemetryItemsChangedAll();
+}
+
+void evalCalculatedTelemetrySensors()
+{
+  if (!telemetrySensorsIndexValid) {
+    telemetrySensorsIndexBuild();
+  }
+
+  // the items flagged from now on are handled on the next call
+  uint64_t changedItems = telemetryItemsChanged[0].exchange(0) |
+                          ((uint64_t)telemetryItemsChanged[1].exchange(0) << 32);
+
+  for (uint8_t i = 0; i < telemetryCalculatedCount; i++) {
+    uint8_t index = telemetryCalculatedOrder[i];
+    const TelemetrySensor & sensor = g_model.telemetrySensors[index];
+    if (!isEvaluatedTelemetrySensor(sensor))
+      continue;
+
+    uint8_t sources[4];
+    uint8_t count = getCalculatedSensorSources(sensor, sources);
+    bool changed = (count == 0);
+    for (uint8_t j = 0; j < count; j++) {
+      if (sources[j] < MAX_TELEMETRY_SENSORS && (changedItems & ((uint64_t)1 << sources[j])))
+        changed = true;
+    }
+
+    // the sensors using this one, evaluated after it, see it changed
+    if (changed) {
+      telemetryItems[index].eval(sensor);
+      changedItems |= (uint64_t)1 << index;
+    }
+  }
+}
+
+static inline bool isTelemetrySensorMatching(TelemetrySensor & telemetrySensor,
+                                             TelemetryProtocol protocol, uint16_t id,
+                                             uint8_t subId, uint8_t instance)
+{
+  return telemetrySensor.type == TELEM_TYPE_CUSTOM && telemetrySensor.id == id &&
+         telemetrySensor.subId == subId &&
+         (telemetrySensor.isSameInstance(protocol, instance) ||
+          g_model.ignoreSensorIds);
+}
+
+int findTelemetrySensors(TelemetryProtocol protocol, uint16_t id, uint8_t subId,
+                         uint8_t instance, uint8_t * indexes)
+{
+  if (!telemetrySensorsIndexValid) {
+    telemetrySensorsIndexBuild();
+  }
+
+  int count = 0;
+  uint8_t index = telemetrySensorsHash[telemetrySensorHash(id, subId)];
+
+  while (index != TELEMETRY_SENSORS_HASH_END) {
+    // the whole condition is checked again, a sensor edited since the last
+    // build may not match anymore
+    if (isTelemetrySensorMatching(g_model.telemetrySensors[index], protocol, id, subId, instance)) {
       // we continue search here, because sensors can share the same id and
       // instance
+      indexes[count++] = index;
+    }
+
+    index = telemetrySensorsNext[index];
+  }
+
+  return count;
+}
+
+// Linear scan, used to confirm a miss before a new sensor is created: a
+// sensor edited since the last build may be missing from the index, and a
+// miss would then add a duplicate sensor
+static int findTelemetrySensorsLinear(TelemetryProtocol protocol, uint16_t id,
+                                      uint8_t subId, uint8_t instance,
+                                      uint8_t * indexes)
+{
+  int count = 0;
+  for (int index = 0; index < MAX_TELEMETRY_SENSORS; index++) {
+    if (isTelemetrySensorMatching(g_model.telemetrySensors[index], protocol, id, subId, instance)) {
+      indexes[count++] = index;
     }
   }
+  return count;
+}
+
+template <class T>
+int setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t subId,
+                      uint8_t instance, T value, uint32_t unit = 0,
+                      uint32_t prec = 0)
+{
+  uint8_t indexes[MAX_TELEMETRY_SENSORS];
+  int count = findTelemetrySensors(protocol, id, subId, instance, indexes);
+
+  if (count == 0 && allowNewSensors) {
+    count = findTelemetrySensorsLinear(protocol, id, subId, instance, indexes);
+    if (count > 0) {
+      telemetrySensorsIndexInvalidate();
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    uint8_t index = indexes[i];
+    telemetryItems[index].setValue(g_model.telemetrySensors[index], value, unit, prec);
+    telemetryItemChanged(index);
+  }
 
-  if (sensorFound || !allowNewSensors) {
+  if (count > 0 || !allowNewSensors) {
     return -1;
   }
 
   int index = availableTelemetryIndex();
   if (index >= 0) {
+    // the *SetDefault() functions end with storageDirty(EE_MODEL), which
+    // invalidates the index again once the new sensor is set up
+    telemetrySensorsIndexInvalidate();
     switch (protocol) {
       case PROTOCOL_TELEMETRY_FRSKY_SPORT:
         frskySportSetDefault(index, id, subId, instance);
@@ -583,6 +828,7 @@ int setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t subId,
         return index;
     }
     telemetryItems[index].setValue(g_model.telemetrySensors[index], value, unit, prec);
+    telemetryItemChanged(index);
     return index;
   }
   else {
@@ -135,6 +135,8 @@ class TelemetryItem
 
 extern TelemetryItem telemetryItems[MAX_TELEMETRY_SENSORS];
 extern uint8_t allowNewSensors;
+void telemetryItemChanged(uint8_t index);
+void evalCalculatedTelemetrySensors();
 bool isFaiForbidden(source_t idx);
 
 #endif // _TELEMETRY_SENSORS_H_
@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include "gtests.h"
+#include "location.h"
+#include "audio_codecs.h"
+
+// A 121 samples block, encoded and decoded with the IMA-ADPCM codec of
+// Python's audioop module (nibbles swapped to the WAV order)
+static const uint8_t imaAdpcmBlock[] = {
+  0x00, 0x00, 0x14, 0x00, 0x77, 0x77, 0x77, 0x02, 0x80, 0xBB, 0xBE, 0xAC,
+  0x18, 0x73, 0x23, 0xA0, 0xCD, 0x09, 0x52, 0x82, 0xCB, 0x1A, 0x35, 0xC8,
+  0x8B, 0x44, 0xC8, 0x2A, 0x13, 0xBC, 0x52, 0xB8, 0x5A, 0xB2, 0x3B, 0xB4,
+  0x3B, 0xB4, 0x5B, 0xD1, 0x30, 0xB9, 0x04, 0x2C, 0xD2, 0x30, 0x0C, 0xC3,
+  0x21, 0x1C, 0xC1, 0x83, 0x4A, 0x1B, 0xC1, 0xA4, 0x10, 0x5B, 0x2B, 0x98,
+  0xE3, 0xB4, 0x92, 0x81,
+};
+
+static const int16_t imaAdpcmSamples[] = {
+  0, 93, 292, 722, 1647, 3634, 7894, 10937, 11490, 11993,
+  11536, 8627, 5981, 1515, -2745, -7726, -11074, -11682, -10022, -6500,
+  362, 7225, 11682, 12492, 8809, 1443, -7382, -10941, -9863, -4961,
+  4845, 11371, 10185, 2635, -6190, -12122, -8887, 1899, 11948, 10643,
+  -36, -10085, -11390, -711, 12211, 10474, -3740, -13295, -4609, 6445,
+  10751, -996, -12050, -4872, 9485, 7574, -4586, -12482, 3311, 13822,
+  445, -11715, -661, 12261, 101, -10953, -904, 10843, -211, -10260,
+  4097, 9830, -9280, -6737, 9450, 3144, -10233, 5403, 7505, -9695,
+  1867, 12378, -8644, -5846, 11959, -8853, -6055, 11750, -9062, -668,
+  12050, -8762, -368, 7262, -13550, 6036, 3493, -8069, 10851, -6954,
+  -17, 6289, -10911, 9901, -4089, -1546, 5391, -9324, 11698, -7888,
+  4830, 2518, -3788, 9589, -12996, 14704, -11365, 5563, -3669, 4725,
+  2182,
+};
+
+TEST(Audio, imaAdpcmReferenceBlock)
+{
+  int16_t samples[2 * sizeof(imaAdpcmBlock)];
+  unsigned count = imaAdpcmDecodeBlock(imaAdpcmBlock, sizeof(imaAdpcmBlock), samples);
+  ASSERT_EQ(DIM(imaAdpcmSamples), count);
+  for (unsigned i = 0; i < count; i++) {
+    EXPECT_EQ(imaAdpcmSamples[i], samples[i]) << "sample " << i;
+  }
+}
+
+// IMA-ADPCM encoder following the IMA recommendation, the decoder is
+// expected to track its predictor exactly
+class ImaAdpcmEncoder {
+  public:
+    static const int16_t stepTable[89];
+
+    std::vector<uint8_t> encodeBlock(const int16_t * samples, unsigned count,
+                                     std::vector<int16_t> & predicted)
+    {
+      std::vector<uint8_t> block;
+      predictor = samples[0];
+      predicted.push_back(predictor);
+      block.push_back(predictor & 0xFF);
+      block.push_back(predictor >> 8);
+      block.push_back(index);
+      block.push_back(0);
+      for (unsigned i = 1; i < count; i += 2) {
+        uint8_t low = encode(samples[i], predicted);
+        uint8_t high = encode(i + 1 < count ? samples[i + 1] : samples[i], predicted);
+        block.push_back(low | (high << 4));
+      }
+      return block;
+    }
+
+  private:
+    int32_t predictor = 0;
+    int index = 0;
+
+    uint8_t encode(int16_t sample, std::vector<int16_t> & predicted)
+    {
+      static const int indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+      int32_t step = stepTable[index];
+      int32_t diff = sample - predictor;
+      uint8_t nibble = 0;
+      if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+      }
+      int32_t delta = step >> 3;
+      if (diff >= step) { nibble |= 4; diff -= step; delta += step; }
+      step >>= 1;
+      if (diff >= step) { nibble |= 2; diff -= step; delta += step; }
+      step >>= 1;
+      if (diff >= step) { nibble |= 1; delta += step; }
+      predictor += (nibble & 8) ? -delta : delta;
+      predictor = limit<int32_t>(INT16_MIN, predictor, INT16_MAX);
+      index = limit(0, index + indexTable[nibble & 7], 88);
+      predicted.push_back(predictor);
+      return nibble;
+    }
+};
+
+const int16_t ImaAdpcmEncoder::stepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+  45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+  230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+  963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+  3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493,
+  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086,
+  29794, 32767
+};
+
+static std::vector<int16_t> generateTones(unsigned count, unsigned rate)
+{
+  std::vector<int16_t> samples(count);
+  for (unsigned i = 0; i < count; i++) {
+    double t = double(i) / rate;
+    samples[i] = 9000 * sin(2 * M_PI * 440 * t) + 4000 * sin(2 * M_PI * 1250 * t);
+  }
+  return samples;
+}
+
+// 505 samples blocks of 256 bytes, as written by most encoders at 22 kHz
+TEST(Audio, imaAdpcmAccuracy)
+{
+  const unsigned blockSamples = 505;
+  std::vector<int16_t> input = generateTones(20 * blockSamples, 22050);
+
+  ImaAdpcmEncoder encoder;
+  double signal = 0, noise = 0;
+  for (unsigned pos = 0; pos < input.size(); pos += blockSamples) {
+    std::vector<int16_t> predicted;
+    std::vector<uint8_t> block = encoder.encodeBlock(&input[pos], blockSamples, predicted);
+    ASSERT_EQ(256U, block.size());
+
+    int16_t output[2 * 256];
+    ASSERT_EQ(blockSamples, imaAdpcmDecodeBlock(block.data(), block.size(), output));
+    for (unsigned i = 0; i < blockSamples; i++) {
+      ASSERT_EQ(predicted[i], output[i]) << "block " << pos / blockSamples << " sample " << i;
+      signal += double(input[pos + i]) * input[pos + i];
+      noise += double(input[pos + i] - output[i]) * (input[pos + i] - output[i]);
+    }
+  }
+
+  double snr = 10 * log10(signal / noise);
+  EXPECT_GT(snr, 25);
+}
+
+TEST(Audio, linearResampler)
+{
+  for (unsigned rate : {8000, 11025, 22050, 44100, 48000}) {
+    std::vector<int16_t> input = generateTones(5 * rate, rate);
+
+    LinearResampler resampler;
+    resampler.init(rate, AUDIO_SAMPLE_RATE);
+    std::vector<int16_t> output;
+    auto next = input.begin();
+    while (true) {
+      while (resampler.needsInput() && next != input.end())
+        resampler.push(*next++);
+      if (resampler.needsInput())
+        break;
+      output.push_back(resampler.next());
+    }
+
+    // the output rate stays exact over the whole stream
+    EXPECT_NEAR(5 * AUDIO_SAMPLE_RATE, output.size(), AUDIO_SAMPLE_RATE / rate + 1) << rate << " Hz";
+
+    // the output follows the input signal, the linear interpolation error
+    // grows with the tones frequency relative to the input rate
+    std::vector<int16_t> expected = generateTones(output.size(), AUDIO_SAMPLE_RATE);
+    int maxError = 0;
+    for (unsigned i = 0; i < output.size(); i++) {
+      maxError = max(maxError, abs(output[i] - expected[i]));
+    }
+    EXPECT_LT(maxError, rate >= 22050 ? 150 : 1100) << rate << " Hz";
+  }
+}
+
+// 'padding' bytes of an unknown chunk are inserted before the data chunk
+static void writeWavFile(const char * path, uint16_t codec, uint32_t rate,
+                         uint16_t blockAlign, const std::vector<uint8_t> & data,
+                         uint32_t padding = 0)
+{
+  uint8_t header[48];
+  uint32_t fmtSize = (codec == 1 ? 16 : 20);
+  memcpy(header, "RIFF", 4);
+  *(uint32_t *)(header + 4) = 4 + 8 + fmtSize + (padding ? 8 + padding : 0) + 8 + data.size();
+  memcpy(header + 8, "WAVEfmt ", 8);
+  *(uint32_t *)(header + 16) = fmtSize;
+  *(uint16_t *)(header + 20) = codec;
+  *(uint16_t *)(header + 22) = 1;
+  *(uint32_t *)(header + 24) = rate;
+  *(uint32_t *)(header + 28) = rate * 2;
+  *(uint16_t *)(header + 32) = blockAlign;
+  *(uint16_t *)(header + 34) = (codec == 1 ? 16 : 4);
+  *(uint16_t *)(header + 36) = 0;                       // cbSize
+  *(uint16_t *)(header + 38) = (blockAlign - 4) * 2 + 1; // samples per block
+  uint8_t * chunk = header + 20 + fmtSize;
+  memcpy(chunk, "data", 4);
+  *(uint32_t *)(chunk + 4) = data.size();
+
+  FIL file;
+  UINT written;
+  ASSERT_EQ(FR_OK, f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE));
+  f_write(&file, header, chunk - header, &written);
+  if (padding) {
+    std::vector<uint8_t> pad(8 + padding);
+    memcpy(pad.data(), "pad ", 4);
+    *(uint32_t *)(pad.data() + 4) = padding;
+    f_write(&file, pad.data(), pad.size(), &written);
+  }
+  f_write(&file, chunk, 8, &written);
+  f_write(&file, data.data(), data.size(), &written);
+  f_write(&file, "LIST\4\0\0\0INFO", 12, &written);   // trailing chunk, not played
+  f_close(&file);
+}
+
+static std::vector<int> playWavFile(const char * path)
+{
+  static WavContext context;
+  std::vector<int> output;
+
+  context.setFragment(path, 0, 1);
+  while (true) {
+    AudioMixBuffer buffer;
+    memclear(&buffer, sizeof(buffer));
+    int count = context.mixBuffer(&buffer, 2, 0);
+    output.insert(output.end(), buffer.data, buffer.data + count);
+    if (count < AUDIO_BUFFER_SIZE)
+      break;
+  }
+  return output;
+}
+
+// decoding and resampling in the audio mixer, across the read-ahead
+// buffer refills and the IMA-ADPCM blocks
+TEST(Audio, playWavFiles)
+{
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/", TESTS_BUILD_PATH "/");
+
+  const unsigned blockSamples = 505;
+  std::vector<int16_t> input = generateTones(7 * blockSamples + 100, 22050);
+  std::vector<uint8_t> pcm((uint8_t *)input.data(), (uint8_t *)(input.data() + input.size()));
+
+  // the ADPCM file ends with a short block, its padding nibble is played
+  ImaAdpcmEncoder encoder;
+  std::vector<uint8_t> adpcm;
+  std::vector<int16_t> predicted;
+  for (unsigned pos = 0; pos < input.size(); pos += blockSamples) {
+    unsigned count = min<unsigned>(blockSamples, input.size() - pos);
+    std::vector<uint8_t> block = encoder.encodeBlock(&input[pos], count, predicted);
+    adpcm.insert(adpcm.end(), block.begin(), block.end());
+  }
+
+  writeWavFile("/test_pcm_22k.wav", 1, 22050, 2, pcm);
+  writeWavFile("/test_adpcm_22k.wav", 0x11, 22050, 256, adpcm);
+
+  for (auto test : {std::make_pair("/test_pcm_22k.wav", &input),
+                    std::make_pair("/test_adpcm_22k.wav", &predicted)}) {
+    const std::vector<int16_t> & samples = *test.second;
+    std::vector<int> output = playWavFile(test.first);
+
+    LinearResampler resampler;
+    resampler.init(22050, AUDIO_SAMPLE_RATE);
+    std::vector<int> expected;
+    auto next = samples.begin();
+    while (true) {
+      while (resampler.needsInput() && next != samples.end())
+        resampler.push(*next++);
+      if (resampler.needsInput())
+        break;
+      expected.push_back(resampler.next());
+    }
+
+    ASSERT_EQ(expected.size(), output.size()) << test.first;
+    for (unsigned i = 0; i < output.size(); i++) {
+      ASSERT_EQ(expected[i], output[i])
+          << test.first << " sample " << i;
+    }
+  }
+
+  f_unlink("/test_pcm_22k.wav");
+  f_unlink("/test_adpcm_22k.wav");
+  simuFatfsSetPaths("", "");
+}
+
+// the reads of the data chunk start at odd file offsets, and end across
+// several read-ahead buffer refills and sector boundaries
+TEST(Audio, readDataAcrossRefills)
+{
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/", TESTS_BUILD_PATH "/");
+
+  const unsigned rates[] = {AUDIO_SAMPLE_RATE, AUDIO_SAMPLE_RATE / 2, 22050};
+  for (unsigned rate : rates) {
+    for (uint32_t padding : {1, 7, 510}) {
+      std::vector<int16_t> input(3 * WAV_READAHEAD_SIZE + 1000 + padding);
+      for (unsigned i = 0; i < input.size(); i++)
+        input[i] = i * 7;
+      std::vector<uint8_t> pcm((uint8_t *)input.data(), (uint8_t *)(input.data() + input.size()));
+      writeWavFile("/test_refills.wav", 1, rate, 2, pcm, padding);
+
+      std::vector<int> expected;
+      if (AUDIO_SAMPLE_RATE % rate == 0) {
+        for (int16_t sample : input)
+          expected.insert(expected.end(), AUDIO_SAMPLE_RATE / rate, sample);
+      }
+      else {
+        LinearResampler resampler;
+        resampler.init(rate, AUDIO_SAMPLE_RATE);
+        auto next = input.begin();
+        while (true) {
+          while (resampler.needsInput() && next != input.end())
+            resampler.push(*next++);
+          if (resampler.needsInput())
+            break;
+          expected.push_back(resampler.next());
+        }
+      }
+
+      std::vector<int> output = playWavFile("/test_refills.wav");
+      ASSERT_EQ(expected.size(), output.size()) << rate << " Hz, padding " << padding;
+      for (unsigned i = 0; i < output.size(); i++) {
+        ASSERT_EQ(expected[i], output[i])
+            << rate << " Hz, padding " << padding << ", sample " << i;
+      }
+    }
+  }
+
+  f_unlink("/test_refills.wav");
+  simuFatfsSetPaths("", "");
+}
+
+// the mixing loop used before, one saturation per voice and sample
+static void mixVoicesBySample(audio_data_t * output, const int16_t * const * voices,
+                              int count, const unsigned * shifts)
+{
+  for (int i = 0; i < AUDIO_BUFFER_SIZE; i++)
+    output[i] = AUDIO_DATA_SILENCE;
+  for (int voice = 0; voice < count; voice++) {
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+      output[i] = limit<int>(AUDIO_DATA_MIN, output[i] + ((voices[voice][i] >> shifts[voice]) >> (16 - AUDIO_BITS_PER_SAMPLE)), AUDIO_DATA_MAX);
+    }
+  }
+}
+
+static void mixVoicesByBlock(audio_data_t * output, const int16_t * const * voices,
+                             int count, const unsigned * shifts)
+{
+  AudioMixBuffer mix;
+  memclear(&mix, sizeof(mix));
+  for (int voice = 0; voice < count; voice++) {
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+      mix.data[i] += voices[voice][i] >> shifts[voice];
+    }
+  }
+  audioMixOutput(output, mix.data, AUDIO_BUFFER_SIZE);
+}
+
+// a prompt, the vario and the background music ducked as in AudioQueue::wakeup()
+TEST(Audio, mixVoices)
+{
+  currentSpeakerVolume = VOLUME_LEVEL_MAX;
+  std::vector<int16_t> voices[4];
+  const int16_t * pointers[4];
+  const unsigned shifts[4] = {0, 1, 2, 2};
+  for (int voice = 0; voice < 4; voice++) {
+    voices[voice] = generateTones(AUDIO_BUFFER_SIZE, 8000 + 3000 * voice);
+    pointers[voice] = voices[voice].data();
+  }
+
+  audio_data_t bySample[AUDIO_BUFFER_SIZE], byBlock[AUDIO_BUFFER_SIZE];
+
+  // below the saturation, only the rounding of the voices shifted to the
+  // DAC resolution differs
+  mixVoicesBySample(bySample, pointers, 4, shifts);
+  mixVoicesByBlock(byBlock, pointers, 4, shifts);
+  for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+    EXPECT_NEAR(bySample[i], byBlock[i], 4) << "sample " << i;
+  }
+
+  // saturated voices are clipped once, instead of after each voice
+  const unsigned loud[4] = {0, 0, 0, 0};
+  for (auto & sample : voices[0])
+    sample = INT16_MAX;
+  for (auto & sample : voices[1])
+    sample = -20000;
+  mixVoicesByBlock(byBlock, pointers, 2, loud);
+  for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+    EXPECT_EQ(AUDIO_DATA_SILENCE + ((INT16_MAX - 20000) >> (16 - AUDIO_BITS_PER_SAMPLE)), byBlock[i]);
+  }
+}
+
+#if defined(GTESTS_BENCHMARKS)
+#include <chrono>
+
+TEST(Audio, mixVoicesBenchmark)
+{
+  currentSpeakerVolume = VOLUME_LEVEL_MAX;
+  const int iterations = 20000;
+  std::vector<int16_t> voices[4];
+  const int16_t * pointers[4];
+  const unsigned shifts[4] = {0, 1, 2, 2};
+  for (int voice = 0; voice < 4; voice++) {
+    voices[voice] = generateTones(AUDIO_BUFFER_SIZE, 8000 + 3000 * voice);
+    pointers[voice] = voices[voice].data();
+  }
+
+  audio_data_t output[AUDIO_BUFFER_SIZE];
+  uint32_t check = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++) {
+    mixVoicesBySample(output, pointers, 4, shifts);
+    check += output[n % AUDIO_BUFFER_SIZE];
+  }
+  std::chrono::duration<double> bySample = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++) {
+    mixVoicesByBlock(output, pointers, 4, shifts);
+    check += output[n % AUDIO_BUFFER_SIZE];
+  }
+  std::chrono::duration<double> byBlock = std::chrono::steady_clock::now() - start;
+
+  EXPECT_NE(0U, check);
+  double samples = double(AUDIO_BUFFER_SIZE) * iterations;
+  printf("Mixing 4 voices: %6.1f samples/us saturating each voice, %6.1f samples/us saturating once\n",
+         samples / bySample.count() / 1e6, samples / byBlock.count() / 1e6);
+}
+#endif
@@ -24,6 +24,7 @@
 #if defined(COLORLCD)
 
 #include "colors.h"
+#include <lvgl/lvgl.h>
 
 TEST(color, RGB)
 {
@@ -52,4 +53,41 @@ TEST(color, ARGB)
   EXPECT_EQ(ARGB(128, 30, 40, 150), (uint16_t)0x8129);
 }
 
+int lcdMergeAreas(lv_area_t* areas, int count);
+
+TEST(lcd, mergeAreas)
+{
+  // side by side cells of a row: copied as one area
+  lv_area_t row[] = {{0, 10, 49, 29}, {100, 10, 149, 29}, {50, 10, 99, 29}};
+  EXPECT_EQ(lcdMergeAreas(row, 3), 1);
+  EXPECT_EQ(row[0].x1, 0);
+  EXPECT_EQ(row[0].y1, 10);
+  EXPECT_EQ(row[0].x2, 149);
+  EXPECT_EQ(row[0].y2, 29);
+
+  // the merged area would copy more pixels: kept apart
+  lv_area_t corners[] = {{0, 0, 9, 9}, {100, 100, 109, 109}};
+  EXPECT_EQ(lcdMergeAreas(corners, 2), 2);
+  EXPECT_EQ(corners[1].x1, 100);
+
+  // overlapping areas
+  lv_area_t overlap[] = {{0, 0, 99, 99}, {50, 0, 149, 99}};
+  EXPECT_EQ(lcdMergeAreas(overlap, 2), 1);
+  EXPECT_EQ(overlap[0].x2, 149);
+
+  // the grown area is checked again against the areas it was kept apart from
+  lv_area_t column[] = {{0, 0, 49, 9}, {0, 20, 49, 29}, {0, 10, 49, 19}};
+  EXPECT_EQ(lcdMergeAreas(column, 3), 1);
+  EXPECT_EQ(column[0].y1, 0);
+  EXPECT_EQ(column[0].y2, 29);
+
+  // two halves of a row merged last, then merged with the row above
+  lv_area_t halves[] = {{0, 0, 49, 9}, {0, 10, 24, 19}, {25, 10, 49, 19}};
+  EXPECT_EQ(lcdMergeAreas(halves, 3), 1);
+  EXPECT_EQ(halves[0].x1, 0);
+  EXPECT_EQ(halves[0].y1, 0);
+  EXPECT_EQ(halves[0].x2, 49);
+  EXPECT_EQ(halves[0].y2, 19);
+}
+
 #endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <vector>
+
+#include "gtests.h"
+
+// the byte at a time implementation used before
+static uint16_t crc16Bytewise(uint8_t index, const uint8_t * buf, uint32_t len, uint16_t crc)
+{
+  const unsigned short * tab = crc16tab[index];
+  for (uint32_t i = 0; i < len; i++)
+    crc = (crc << 8) ^ tab[((crc >> 8) ^ buf[i]) & 0x00FF];
+  return crc;
+}
+
+// Both implementations are linear in the start value and the data (no
+// final xor): checking every start value with a zero block and every byte
+// at every position of a block covers all the 4 bytes blocks. All the
+// lengths and alignments around the blocks are checked then.
+TEST(Crc, crc16SlicingEquivalence)
+{
+  for (uint8_t index : {CRC_1021, CRC_1189}) {
+    uint8_t block[4] = {0, 0, 0, 0};
+    for (uint32_t start = 0; start <= 0xFFFF; start++) {
+      ASSERT_EQ(crc16Bytewise(index, block, 4, start), crc16(index, block, 4, start));
+    }
+    for (int pos = 0; pos < 4; pos++) {
+      for (int b = 0; b < 256; b++) {
+        block[pos] = b;
+        ASSERT_EQ(crc16Bytewise(index, block, 4, 0), crc16(index, block, 4, 0));
+      }
+      block[pos] = 0;
+    }
+
+    std::vector<uint8_t> buffer(4096 + 3);
+    for (auto & byte : buffer)
+      byte = rand();
+    for (uint32_t offset = 0; offset < 4; offset++) {
+      for (uint32_t len = 0; len <= 64; len++) {
+        uint16_t start = rand();
+        ASSERT_EQ(crc16Bytewise(index, &buffer[offset], len, start),
+                  crc16(index, &buffer[offset], len, start))
+            << "offset " << offset << " len " << len;
+      }
+      ASSERT_EQ(crc16Bytewise(index, &buffer[offset], 4096, 0xFFFF),
+                crc16(index, &buffer[offset], 4096, 0xFFFF));
+    }
+  }
+}
+
+TEST(Crc, crc16Streaming)
+{
+  std::vector<uint8_t> buffer(1000);
+  for (auto & byte : buffer)
+    byte = rand();
+
+  uint16_t whole = crc16(CRC_1021, buffer.data(), buffer.size());
+  for (uint32_t split : {1, 3, 7, 64, 999}) {
+    uint16_t crc = crc16(CRC_1021, buffer.data(), split);
+    crc = crc16(CRC_1021, buffer.data() + split, buffer.size() - split, crc);
+    EXPECT_EQ(whole, crc) << "split at " << split;
+  }
+}
+
+#if defined(GTESTS_BENCHMARKS)
+#include <chrono>
+
+TEST(Crc, crc16Benchmark)
+{
+  const uint32_t size = 64 * 1024;
+  const int iterations = 20;
+  std::vector<uint8_t> buffer(size);
+  for (auto & byte : buffer)
+    byte = rand();
+
+  uint16_t bytewise = 0, sliced = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++)
+    bytewise = crc16Bytewise(CRC_1021, buffer.data(), size, bytewise);
+  std::chrono::duration<double> bytewiseTime = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++)
+    sliced = crc16(CRC_1021, buffer.data(), size, sliced);
+  std::chrono::duration<double> slicedTime = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(bytewise, sliced);
+  double bytes = double(size) * iterations;
+  printf("CRC16 bytewise %8.2f MB/s, slicing-by-4 %8.2f MB/s\n",
+         bytes / bytewiseTime.count() / 1e6, bytes / slicedTime.count() / 1e6);
+}
+#endif
@@ -25,17 +25,26 @@
 uint8_t createCrossfireChannelsFrame(uint8_t * frame, int16_t * pulses);
 TEST(Crossfire, createCrossfireChannelsFrame)
 {
-  int16_t pulsesStart[MAX_TRAINER_CHANNELS];
+  // recorded with the encoder packing the channels one value at a time
+  static const uint8_t golden[] = {
+    0xEE, 0x18, 0x16, 0x00, 0x80, 0x00, 0x32, 0x12, 0x02, 0x1C, 0x3C, 0xE5, 0x0A,
+    0x6E, 0x28, 0x4C, 0x23, 0x48, 0xB1, 0x9B, 0x61, 0x68, 0x23, 0x1E, 0xF8, 0x28,
+  };
+
+  int16_t pulsesStart[CROSSFIRE_CHANNELS_COUNT];
   uint8_t crossfire[CROSSFIRE_FRAME_MAXLEN];
 
+  MODEL_RESET();
   memset(crossfire, 0, sizeof(crossfire));
-  for (int i=0; i<MAX_TRAINER_CHANNELS; i++) {
-    pulsesStart[i] = -1024 + (2048 / MAX_TRAINER_CHANNELS) * i;
+  for (int i=0; i<CROSSFIRE_CHANNELS_COUNT; i++) {
+    pulsesStart[i] = -1400 + 180 * i;
+    g_model.limitData[i].ppmCenter = (i % 3 - 1) * 25;
   }
 
-  createCrossfireChannelsFrame(crossfire, pulsesStart);
-
-  // TODO check
+  ASSERT_EQ(sizeof(golden), createCrossfireChannelsFrame(crossfire, pulsesStart));
+  for (unsigned i=0; i<sizeof(golden); i++) {
+    EXPECT_EQ(golden[i], crossfire[i]) << "byte " << i;
+  }
 }
 
 TEST(Crossfire, crc8)
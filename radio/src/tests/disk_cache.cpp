@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "gtests.h"
+
+#if !defined(DISK_CACHE)
+#include "diskio.h"
+#undef __disk_read
+#undef __disk_write
+
+// The cache is built here in its write-back configuration, on top of a RAM
+// disk instead of the SD card driver
+#define DISK_CACHE_WRITEBACK
+#define SIMU_DISKIO
+
+namespace disk_cache_test {
+
+#define RAM_DISK_SECTORS   256
+
+static uint8_t ramDisk[RAM_DISK_SECTORS * BLOCK_SIZE];
+
+static uint32_t sdGetNoSectors()
+{
+  return RAM_DISK_SECTORS;
+}
+
+static DRESULT __disk_read(BYTE drv, BYTE * buff, DWORD sector, UINT count)
+{
+  if (sector + count > RAM_DISK_SECTORS) return RES_PARERR;
+  memcpy(buff, ramDisk + sector * BLOCK_SIZE, count * BLOCK_SIZE);
+  return RES_OK;
+}
+
+static DRESULT __disk_write(BYTE drv, const BYTE * buff, DWORD sector, UINT count)
+{
+  if (sector + count > RAM_DISK_SECTORS) return RES_PARERR;
+  memcpy(ramDisk + sector * BLOCK_SIZE, buff, count * BLOCK_SIZE);
+  return RES_OK;
+}
+
+#include "disk_cache.h"
+#include "../disk_cache.cpp"
+
+}  // namespace disk_cache_test
+
+using namespace disk_cache_test;
+
+TEST(DiskCache, writeBackInterleavedWithReads)
+{
+  static uint8_t expected[RAM_DISK_SECTORS * BLOCK_SIZE];
+  static uint8_t buffer[40 * BLOCK_SIZE];
+
+  for (unsigned i = 0; i < sizeof(ramDisk); i++) {
+    ramDisk[i] = expected[i] = i * 7;
+  }
+
+  DiskCache & cache = diskCache;
+  cache.clear();
+  uint32_t seed = 0x5678;
+  for (int i = 0; i < 5000; i++) {
+    seed = seed * 1103515245 + 12345;
+    // up to 40 sectors, more than the write-back buffer and the read blocks
+    UINT count = 1 + (seed >> 8) % 40;
+    DWORD sector = (seed >> 16) % (RAM_DISK_SECTORS - count);
+    // most operations are on the first sectors, like the FAT
+    if ((seed >> 4) & 1) {
+      sector %= 24;
+    }
+
+    switch ((seed >> 28) % 8) {
+      case 0:
+        ASSERT_EQ(RES_OK, cache.flush(0));
+        ASSERT_EQ(0, memcmp(ramDisk, expected, sizeof(ramDisk)));
+        break;
+
+      case 1:
+      case 2:
+      case 3:
+        for (UINT j = 0; j < count * BLOCK_SIZE; j++) {
+          buffer[j] = i + j;
+        }
+        ASSERT_EQ(RES_OK, cache.write(0, buffer, sector, count));
+        memcpy(expected + sector * BLOCK_SIZE, buffer, count * BLOCK_SIZE);
+        break;
+
+      default:
+        ASSERT_EQ(RES_OK, cache.read(0, buffer, sector, count));
+        ASSERT_EQ(0, memcmp(buffer, expected + sector * BLOCK_SIZE, count * BLOCK_SIZE))
+          << "read(" << sector << ", " << count << ") at step " << i;
+        break;
+    }
+  }
+
+  ASSERT_EQ(RES_OK, cache.flush(0));
+  EXPECT_EQ(0, memcmp(ramDisk, expected, sizeof(ramDisk)));
+  EXPECT_GT(cache.getStats().noHits, 0U);
+  EXPECT_GT(cache.getStats().noFlushes, 0U);
+}
+#endif
@@ -382,6 +382,7 @@ TEST(FrSkySPORT, frskySetCellVoltageTwoSensors)
   g_model.telemetrySensors[2].prec = 1;
   g_model.telemetrySensors[2].calc.sources[0] = 1;
   g_model.telemetrySensors[2].calc.sources[1] = 2;
+  storageDirty(EE_MODEL);
 
   telemetryWakeup();
 
@@ -406,6 +407,45 @@ TEST(FrSkySPORT, frskySetCellVoltageTwoSensors)
   EXPECT_EQ(telemetryItems[2].valueMax, 287);
 }
 
+TEST(FrSkySPORT, calculatedSensorsChain)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  telemetryStreaming = TELEMETRY_TIMEOUT10ms;
+
+  g_model.telemetrySensors[0].init("Src", UNIT_VOLTS, 0);
+
+  // sensor 2 uses sensor 4, which is evaluated first
+  g_model.telemetrySensors[2].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[2].formula = TELEM_FORMULA_ADD;
+  g_model.telemetrySensors[2].unit = UNIT_VOLTS;
+  g_model.telemetrySensors[2].calc.sources[0] = 5;
+  g_model.telemetrySensors[2].calc.sources[1] = 1;
+
+  g_model.telemetrySensors[4].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[4].formula = TELEM_FORMULA_ADD;
+  g_model.telemetrySensors[4].unit = UNIT_VOLTS;
+  g_model.telemetrySensors[4].calc.sources[0] = 1;
+  storageDirty(EE_MODEL);
+
+  telemetryItems[0].setValue(g_model.telemetrySensors[0], 10, UNIT_VOLTS);
+  telemetryItemChanged(0);
+  telemetryWakeup();
+  EXPECT_EQ(telemetryItems[4].value, 10);
+  EXPECT_EQ(telemetryItems[2].value, 20);
+
+  // no new source value: the calculated sensors are not evaluated again
+  telemetryItems[2].value = 0;
+  telemetryWakeup();
+  EXPECT_EQ(telemetryItems[2].value, 0);
+
+  telemetryItems[0].setValue(g_model.telemetrySensors[0], 12, UNIT_VOLTS);
+  telemetryItemChanged(0);
+  telemetryWakeup();
+  EXPECT_EQ(telemetryItems[4].value, 12);
+  EXPECT_EQ(telemetryItems[2].value, 24);
+}
+
 void generateSportFasVoltagePacket(uint8_t * packet, uint32_t voltage)
 {
   packet[0] = 0x22; //DATA_ID_FAS
@@ -530,3 +570,88 @@ TEST(FrSkySPORT, frskyCurrent)
   EXPECT_EQ(telemetryItems[0].valueMax, 505);
 }
 
+
+static int findTelemetrySensorsLinear(TelemetryProtocol protocol, uint16_t id,
+                                      uint8_t subId, uint8_t instance,
+                                      uint8_t * indexes)
+{
+  int count = 0;
+  for (int index = 0; index < MAX_TELEMETRY_SENSORS; index++) {
+    TelemetrySensor & telemetrySensor = g_model.telemetrySensors[index];
+    if (telemetrySensor.type == TELEM_TYPE_CUSTOM && telemetrySensor.id == id &&
+        telemetrySensor.subId == subId &&
+        (telemetrySensor.isSameInstance(protocol, instance) ||
+         g_model.ignoreSensorIds)) {
+      indexes[count++] = index;
+    }
+  }
+  return count;
+}
+
+TEST(FrSkySPORT, findSensorsMatchesLinearScan)
+{
+  const uint16_t ids[] = { 0x0000, 0x0100, 0x0210, 0x0211, 0x0300, 0x0910, 0x5100 };
+  uint32_t seed = 0x1234;
+
+  for (int ignoreSensorIds = 0; ignoreSensorIds <= 1; ignoreSensorIds++) {
+    MODEL_RESET();
+    TELEMETRY_RESET();
+    g_model.ignoreSensorIds = ignoreSensorIds;
+
+    // leave a few empty slots, they are matched as custom sensors with id 0
+    for (int i = 0; i < MAX_TELEMETRY_SENSORS - 5; i++) {
+      seed = seed * 1103515245 + 12345;
+      TelemetrySensor & sensor = g_model.telemetrySensors[i];
+      sensor.id = ids[(seed >> 16) % DIM(ids)];
+      sensor.subId = (seed >> 8) % 3;
+      sensor.instance = (seed >> 20) % 4;
+      sensor.type = ((seed >> 24) % 5) == 0 ? TELEM_TYPE_CALCULATED : TELEM_TYPE_CUSTOM;
+    }
+    telemetrySensorsIndexInvalidate();
+
+    for (auto id: ids) {
+      for (uint8_t subId = 0; subId < 3; subId++) {
+        for (uint8_t instance = 0; instance < 5; instance++) {
+          uint8_t expected[MAX_TELEMETRY_SENSORS];
+          uint8_t result[MAX_TELEMETRY_SENSORS];
+          int expectedCount = findTelemetrySensorsLinear(PROTOCOL_TELEMETRY_FRSKY_SPORT, id, subId, instance, expected);
+          int count = findTelemetrySensors(PROTOCOL_TELEMETRY_FRSKY_SPORT, id, subId, instance, result);
+          ASSERT_EQ(expectedCount, count);
+          for (int i = 0; i < count; i++) {
+            EXPECT_EQ(expected[i], result[i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(FrSkySPORT, noDuplicateSensorWithOutdatedIndex)
+{
+  uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  telemetryStreaming = TELEMETRY_TIMEOUT10ms;
+  telemetryData.telemetryValid = 0x07;
+  allowNewSensors = true;
+
+  generateSportFasVoltagePacket(packet, 5000);
+  sportProcessTelemetryPacket(0, packet, sizeof(packet));
+  generateSportFasCurrentPacket(packet, 100);
+  sportProcessTelemetryPacket(0, packet, sizeof(packet));
+  ASSERT_TRUE(g_model.telemetrySensors[1].isAvailable());
+
+  // rebuild the index without the current sensor
+  TelemetrySensor current = g_model.telemetrySensors[1];
+  delTelemetryIndex(1);
+  generateSportFasVoltagePacket(packet, 5000);
+  sportProcessTelemetryPacket(0, packet, sizeof(packet));
+
+  // then put it back behind the index
+  g_model.telemetrySensors[1] = current;
+  generateSportFasCurrentPacket(packet, 200);
+  sportProcessTelemetryPacket(0, packet, sizeof(packet));
+  EXPECT_EQ(telemetryItems[1].value, 200);
+  EXPECT_FALSE(g_model.telemetrySensors[2].isAvailable());
+}
@@ -169,6 +169,10 @@ int main(int argc, char **argv)
 #endif
 #if !defined(COLORLCD)
   menuLevel = 0;
+#endif
+#if defined(GTESTS_BENCHMARKS)
+  // only the benchmarks by default, --gtest_filter still applies
+  ::testing::GTEST_FLAG(filter) = "*Benchmark*";
 #endif
   InitGoogleTest(&argc, argv);
 
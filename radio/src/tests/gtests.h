@@ -69,6 +69,8 @@ inline void MODEL_RESET()
   s_mixer_first_run_done = false;
   evalMixes(1);  // this is needed to reset fp_act
   lastFlightMode = 255;
+  mixerPlanInvalidate();  // mixes are set up by the tests after the reset
+  lswPlanInvalidate();
 }
 
 inline void MIXER_RESET()
@@ -91,6 +93,7 @@ inline void TELEMETRY_RESET()
     telemetryItems[i].clear();
   }
   memclear(g_model.telemetrySensors, sizeof(g_model.telemetrySensors));
+  telemetrySensorsIndexInvalidate();
 }
 
 class OpenTxTest : public testing::Test 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "gtests.h"
+#include "targets/simu/simuheadless.h"
+
+class HeadlessTest : public OpenTxTest {};
+
+TEST(Headless, parseTimeline)
+{
+  HeadlessSimulator simulator;
+
+  EXPECT_TRUE(simulator.parseTimeline("# comment"));
+  EXPECT_TRUE(simulator.parseTimeline(""));
+  EXPECT_TRUE(simulator.parseTimeline("500 ana 1 2000"));
+  EXPECT_TRUE(simulator.parseTimeline("100 switch 0 -1"));
+  EXPECT_TRUE(simulator.parseTimeline("100 sensor 2 1250"));
+  EXPECT_TRUE(simulator.parseTimeline("1000 end"));
+
+  auto & events = simulator.getEvents();
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[0].type, HEADLESS_EVENT_SWITCH);
+  EXPECT_EQ(events[1].type, HEADLESS_EVENT_SENSOR);
+  EXPECT_EQ(events[2].type, HEADLESS_EVENT_ANALOG);
+  EXPECT_EQ(events[2].value, RESX);
+  EXPECT_EQ(simulator.getDuration(), 1000u);
+
+  EXPECT_FALSE(simulator.parseTimeline("0 throttle 0 0", 7));
+  EXPECT_EQ(simulator.getError(), "line 7: unknown command 'throttle'");
+  EXPECT_FALSE(simulator.parseTimeline("0 ana 0"));
+  EXPECT_FALSE(simulator.parseTimeline("0 switch 200 1"));
+
+  // nothing can happen after the end
+  EXPECT_FALSE(simulator.parseTimeline("1500 ana 0 0", 9));
+  EXPECT_EQ(simulator.getError(), "line 9: event after the end");
+  EXPECT_TRUE(simulator.parseTimeline("1000 ana 0 0"));
+  EXPECT_EQ(simulator.getDuration(), 1000u);
+
+  HeadlessSimulator reversed;
+  EXPECT_TRUE(reversed.parseTimeline("1500 ana 0 0"));
+  EXPECT_FALSE(reversed.parseTimeline("1000 end"));
+}
+
+TEST_F(HeadlessTest, runTimeline)
+{
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].mltpx = MLTPX_ADD;
+  g_model.mixData[0].srcRaw = MIXSRC_Rud;
+  g_model.mixData[0].weight = 100;
+  g_model.mixData[0].speedUp = 10;
+  mixerPlanInvalidate();
+
+  HeadlessSimulator simulator;
+  simulator.setAnalogs(anaInValues);
+  ASSERT_TRUE(simulator.parseTimeline("100 ana 0 1024"));
+  ASSERT_TRUE(simulator.parseTimeline("3000 end"));
+
+  auto run = [&]() {
+    std::vector<int16_t> outputs;
+    memset(anaInValues, 0, sizeof(anaInValues));
+    MIXER_RESET();
+    g_tmr10ms = 0;
+    simuSetVirtualClock(true);
+    simulator.run(simulator.getDuration(), 100, [&](uint32_t time, const int16_t * channels) {
+      outputs.push_back(channels[0]);
+    });
+    EXPECT_EQ(simuTimerMicros(), (simulator.getDuration() + 1) * 1000u);
+    simuSetVirtualClock(false);
+    return outputs;
+  };
+
+  auto outputs = run();
+  ASSERT_EQ(outputs.size(), 31u);
+  EXPECT_EQ(outputs[0], 0);
+  EXPECT_GT(outputs[2], 0);
+  EXPECT_LT(outputs[2], RESX);
+  for (unsigned i = 2; i < outputs.size(); i++) {
+    EXPECT_GE(outputs[i], outputs[i - 1]);
+  }
+  EXPECT_EQ(outputs.back(), RESX);
+
+  // the same timeline gives the same outputs
+  EXPECT_EQ(run(), outputs);
+}
+
+TEST_F(HeadlessTest, negativeAnalog)
+{
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].mltpx = MLTPX_ADD;
+  g_model.mixData[0].srcRaw = MIXSRC_Rud;
+  g_model.mixData[0].weight = 100;
+  mixerPlanInvalidate();
+
+  HeadlessSimulator simulator;
+  simulator.setAnalogs(anaInValues);
+  ASSERT_TRUE(simulator.parseTimeline("10 ana 0 -512"));
+  ASSERT_TRUE(simulator.parseTimeline("100 end"));
+
+  int16_t output = 0;
+  memset(anaInValues, 0, sizeof(anaInValues));
+  MIXER_RESET();
+  simuSetVirtualClock(true);
+  simulator.run(simulator.getDuration(), 100, [&](uint32_t time, const int16_t * channels) {
+    output = channels[0];
+  });
+  simuSetVirtualClock(false);
+  EXPECT_EQ(output, -512);
+}
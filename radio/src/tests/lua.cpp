@@ -21,11 +21,13 @@
 
 #include <math.h>
 #include "gtests.h"
+#include "location.h"
 
 #if defined(LUA)
 
 #define SWAP_DEFINED
 #include "opentx.h"
+#include "lua/lua_cache.h"
 
 
 ::testing::AssertionResult __luaExecStr(const char * str)
@@ -164,4 +166,290 @@ TEST(Lua, testModelInputs)
 
 }
 
+static void writeScript(const char * path, const char * script)
+{
+  FIL file;
+  UINT written;
+  ASSERT_EQ(FR_OK, f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE));
+  f_write(&file, script, strlen(script), &written);
+  f_close(&file);
+}
+
+TEST(Lua, testScriptsScheduler)
+{
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/", TESTS_BUILD_PATH "/");
+  f_mkdir(SCRIPTS_PATH);
+  f_mkdir(SCRIPTS_FUNCS_PATH);
+  writeScript(SCRIPTS_FUNCS_PATH "/heavy.lua",
+              "local function run() local n = 0 for i = 1, 20000 do n = n + i end end\n"
+              "return { run = run }\n");
+  writeScript(SCRIPTS_FUNCS_PATH "/light.lua",
+              "local function run() end\n"
+              "return { run = run }\n");
+
+  MODEL_RESET();
+  const char * names[] = { "heavy", "light" };
+  for (int i = 0; i < 2; i++) {
+    CustomFunctionData & cfn = g_model.customFn[i];
+    cfn.swtch = SWSRC_ON;
+    cfn.func = FUNC_PLAY_SCRIPT;
+    strncpy(cfn.play.name, names[i], sizeof(cfn.play.name));
+  }
+
+  luaInit();
+  luaState = INTERPRETER_RELOAD_PERMANENT_SCRIPTS;
+  for (int i = 0; i < 10 && luaState != INTERPRETER_RUNNING; i++) {
+    luaTask(0, false);
+  }
+  ASSERT_EQ(INTERPRETER_RUNNING, luaState);
+  ASSERT_EQ(2, luaScriptsCount);
+
+  // the heavy script exceeds its budget, but does not delay the light one
+  LuaScriptStats & heavy = scriptInternalData[0].stats;
+  LuaScriptStats & light = scriptInternalData[1].stats;
+  uint32_t lightRuns = light.runs;
+  for (int i = 0; i < 20; i++) {
+    luaTask(0, false);
+  }
+  EXPECT_EQ(SCRIPT_OK, scriptInternalData[0].state);
+  EXPECT_EQ(lightRuns + 20, light.runs);
+  EXPECT_EQ(0u, light.preemptions);
+  EXPECT_GT(heavy.runs, 0u);
+  EXPECT_GT(heavy.preemptions, heavy.runs);
+  EXPECT_GT(heavy.maxInstructions, (uint32_t)LUA_BUDGET_FUNCTION);
+  EXPECT_EQ(100, luaGetCpuUsed(0));
+
+  luaExecStr("stats = getScriptStats()");
+  luaExecStr("if #stats ~= 2 or stats[1].name ~= 'heavy' or stats[2].type ~= 'function' then error('getScriptStats()') end");
+  luaExecStr("if stats[2].runs < 20 or stats[1].budget == 0 then error('getScriptStats()') end");
+
+  luaClose(&lsScripts);
+  simuFatfsSetPaths("", "");
+}
+
+TEST(Lua, testScriptsPreemptionInsideCCall)
+{
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/", TESTS_BUILD_PATH "/");
+  f_mkdir(SCRIPTS_PATH);
+  f_mkdir(SCRIPTS_FUNCS_PATH);
+  // the budget is spent inside a gsub() callback, where the script cannot be preempted
+  writeScript(SCRIPTS_FUNCS_PATH "/gsub.lua",
+              "local function heavy(c) local n = 0 for i = 1, 5000 do n = n + i end return c end\n"
+              "local function run() string.gsub('abcdef', '.', heavy) end\n"
+              "return { run = run }\n");
+
+  MODEL_RESET();
+  CustomFunctionData & cfn = g_model.customFn[0];
+  cfn.swtch = SWSRC_ON;
+  cfn.func = FUNC_PLAY_SCRIPT;
+  strncpy(cfn.play.name, "gsub", sizeof(cfn.play.name));
+  memclear(&modelFunctionsContext, sizeof(modelFunctionsContext));
+
+  luaInit();
+  luaState = INTERPRETER_RELOAD_PERMANENT_SCRIPTS;
+  for (int i = 0; i < 10 && luaState != INTERPRETER_RUNNING; i++) {
+    luaTask(0, false);
+  }
+  ASSERT_EQ(INTERPRETER_RUNNING, luaState);
+  ASSERT_EQ(1, luaScriptsCount);
+
+  for (int i = 0; i < 5; i++) {
+    luaTask(0, false);
+  }
+  EXPECT_EQ(SCRIPT_OK, scriptInternalData[0].state);
+  EXPECT_GT(scriptInternalData[0].stats.runs, 0u);
+
+  luaClose(&lsScripts);
+  f_unlink(SCRIPTS_FUNCS_PATH "/gsub.lua");
+  simuFatfsSetPaths("", "");
+}
+
+#if defined(LUA_COMPILER)
+static int luaLoadScriptValue(const char * filename, const char * mode)
+{
+  int value = -1;
+  if (luaLoadScriptFileToState(lsScripts, filename, mode) == SCRIPT_OK) {
+    lua_call(lsScripts, 0, 1);
+    value = lua_tointeger(lsScripts, -1);
+  }
+  lua_pop(lsScripts, 1);
+  return value;
+}
+
+static void setScriptDate(const char * path, uint8_t day)
+{
+  FILINFO fno;
+  fno.fdate = ((2020 - 1980) << 9) | (1 << 5) | day;
+  fno.ftime = 0;
+  f_utime(path, &fno);
+}
+
+static bool isScriptCached(const char * path, char * chunk = nullptr)
+{
+  FILINFO fno;
+  LuaCacheKey key;
+  if (f_stat(path, &fno) != FR_OK)
+    return false;
+  luaCacheGetKey(path, fno, key);
+  if (chunk)
+    luaCacheGetFilename(key, chunk);
+  return luaCacheFind(path, key);
+}
+
+TEST(Lua, testCompiledScriptsCache)
+{
+  char chunk[LUA_CACHE_FILENAME_LEN];
+  char other[LUA_CACHE_FILENAME_LEN];
+
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/", TESTS_BUILD_PATH "/");
+  f_mkdir(SCRIPTS_PATH);
+  f_mkdir(SCRIPTS_FUNCS_PATH);
+  writeScript(SCRIPTS_FUNCS_PATH "/cached.lua", "return 11\n");
+  writeScript(SCRIPTS_FUNCS_PATH "/other.lua", "return 22\n");
+  setScriptDate(SCRIPTS_FUNCS_PATH "/cached.lua", 1);
+  luaInit();
+
+  // miss: the source is compiled to the cache
+  EXPECT_EQ(11, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "btc"));
+  EXPECT_EQ(22, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/other", "btc"));
+  ASSERT_TRUE(isScriptCached(SCRIPTS_FUNCS_PATH "/cached.lua", chunk));
+  ASSERT_TRUE(isScriptCached(SCRIPTS_FUNCS_PATH "/other.lua", other));
+  EXPECT_TRUE(isFileAvailable(chunk));
+
+  // hit: the compiled chunk is loaded instead of the source
+  sdCopyFile(other, chunk);
+  EXPECT_EQ(22, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "bt"));
+  EXPECT_EQ(11, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "t"));
+
+  // another date with the same content is still a hit
+  setScriptDate(SCRIPTS_FUNCS_PATH "/cached.lua", 2);
+  EXPECT_EQ(22, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "bt"));
+  EXPECT_TRUE(isScriptCached(SCRIPTS_FUNCS_PATH "/cached.lua"));
+
+  // another content with the same size invalidates the chunk
+  writeScript(SCRIPTS_FUNCS_PATH "/cached.lua", "return 33\n");
+  setScriptDate(SCRIPTS_FUNCS_PATH "/cached.lua", 3);
+  EXPECT_FALSE(isScriptCached(SCRIPTS_FUNCS_PATH "/cached.lua"));
+  EXPECT_EQ(33, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "bt"));
+  EXPECT_TRUE(isScriptCached(SCRIPTS_FUNCS_PATH "/cached.lua"));
+
+  // and so does another size
+  writeScript(SCRIPTS_FUNCS_PATH "/cached.lua", "return 444\n");
+  setScriptDate(SCRIPTS_FUNCS_PATH "/cached.lua", 3);
+  EXPECT_FALSE(isScriptCached(SCRIPTS_FUNCS_PATH "/cached.lua"));
+  EXPECT_EQ(444, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "bt"));
+  EXPECT_EQ(444, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/cached", "bt"));
+
+  // a precompiled script without a source is loaded as is
+  sdCopyFile(chunk, SCRIPTS_FUNCS_PATH "/binary.luac");
+  EXPECT_EQ(444, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/binary", "bt"));
+  EXPECT_EQ(444, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/binary.luac", "T"));
+  EXPECT_EQ(-1, luaLoadScriptValue(SCRIPTS_FUNCS_PATH "/binary", "t"));
+
+  f_unlink(SCRIPTS_FUNCS_PATH "/cached.lua");
+  f_unlink(SCRIPTS_FUNCS_PATH "/other.lua");
+  f_unlink(SCRIPTS_FUNCS_PATH "/binary.luac");
+  luaClose(&lsScripts);
+  simuFatfsSetPaths("", "");
+}
+#endif
+
+#if defined(COLORLCD)
+#include "lua/lua_draw_list.h"
+
+static int drawListValue = 0;
+static std::vector<std::string> drawListDrawn;
+
+static int drawListGetValue(lua_State * L)
+{
+  lua_pushinteger(L, drawListValue + lua_tointeger(L, 1));
+  return luaRecordInput(L, drawListGetValue, 1);
+}
+
+static int drawListDraw(lua_State * L)
+{
+  coord_t x = lua_tointeger(L, 1);
+  coord_t y = lua_tointeger(L, 2);
+  if (luaDrawRecorder)
+    return luaDrawRecorder->recordDraw(L, drawListDraw, {x, y, 10, 10});
+
+  drawListDrawn.push_back(std::to_string(x) + "," + std::to_string(y) + "," +
+                          luaL_checkstring(L, 3));
+  return 0;
+}
+
+static bool drawListRecord(lua_State * L, LuaDrawList & list,
+                           const char * function)
+{
+  lua_getglobal(L, function);
+  list.startRecording();
+  bool ok = lua_pcall(L, 0, 0, 0) == 0;
+  return list.stopRecording() && ok;
+}
+
+TEST(Lua, testDrawList)
+{
+  lua_State * L = luaL_newstate();
+  lua_register(L, "getValue", drawListGetValue);
+  lua_register(L, "draw", drawListDraw);
+  ASSERT_FALSE(luaL_dostring(L,
+      "function refresh()\n"
+      "  local v = getValue(1)\n"
+      "  draw(1, 2, 'value ' .. v)\n"
+      "  draw(30, 40, 'static')\n"
+      "  draw(50, 60, 'long string long string long string long string ')\n"
+      "end\n"
+      "function refreshTable()\n"
+      "  draw(1, 2, {})\n"
+      "end\n"));
+  int top = lua_gettop(L);
+
+  // calls recorded, nothing drawn
+  drawListValue = 5;
+  LuaDrawList list;
+  EXPECT_TRUE(drawListRecord(L, list, "refresh"));
+  EXPECT_TRUE(list.isValid());
+  EXPECT_TRUE(drawListDrawn.empty());
+
+  EXPECT_TRUE(list.replay(L));
+  ASSERT_EQ(drawListDrawn.size(), 3u);
+  EXPECT_EQ(drawListDrawn[0], "1,2,value 6");
+  EXPECT_EQ(drawListDrawn[1], "30,40,static");
+  EXPECT_EQ(drawListDrawn[2], "50,60,long string long string long string long string ");
+
+  // the value read is checked again without running refresh()
+  EXPECT_FALSE(list.inputsChanged(L));
+  drawListValue = 6;
+  EXPECT_TRUE(list.inputsChanged(L));
+
+  // only the drawing which changed is invalidated
+  LuaDrawList previous = std::move(list);
+  list = LuaDrawList();
+  EXPECT_TRUE(drawListRecord(L, list, "refresh"));
+  std::vector<rect_t> rects;
+  list.diff(previous, [&](const rect_t & rect) { rects.push_back(rect); });
+  ASSERT_EQ(rects.size(), 1u);
+  EXPECT_EQ(rects[0].x, 1);
+  EXPECT_EQ(rects[0].y, 2);
+  EXPECT_EQ(rects[0].w, 10);
+  EXPECT_EQ(rects[0].h, 10);
+  previous.clear(L);
+
+  drawListDrawn.clear();
+  EXPECT_TRUE(list.replay(L));
+  ASSERT_EQ(drawListDrawn.size(), 3u);
+  EXPECT_EQ(drawListDrawn[0], "1,2,value 7");
+  list.clear(L);
+
+  // tables cannot be recorded
+  EXPECT_FALSE(drawListRecord(L, list, "refreshTable"));
+  EXPECT_FALSE(list.isValid());
+  list.clear(L);
+
+  EXPECT_EQ(lua_gettop(L), top);
+  drawListDrawn.clear();
+  lua_close(L);
+}
+#endif
+
 #endif   // #if defined(LUA)
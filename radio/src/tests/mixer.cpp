@@ -19,7 +19,11 @@
  * GNU General Public License for more details.
  */
 
+#include <vector>
+
 #include "gtests.h"
+#include "mixer_stats.h"
+#include "mixer_scheduler.h"
 
 class TrimsTest : public OpenTxTest {};
 class MixerTest : public OpenTxTest {};
@@ -489,6 +493,86 @@ TEST(Curves, LinearIntpol)
   EXPECT_EQ(applyCustomCurve(-192, 0), -192);
 }
 
+// hermite_spline() with the tangents computed on every call
+static int referenceSpline(int x, uint8_t idx)
+{
+  CurveHeader & crv = g_model.curves[idx];
+  int8_t * points = curveAddress(idx);
+  int count = crv.points + 5;
+
+  bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+
+  for (int i = 0; i < count - 1; i++) {
+    point_t p0, p3;
+    if (custom) {
+      p0.x = (i > 0 ? calc100toRESX(points[count + i - 1]) : -RESX);
+      p3.x = (i < count - 2 ? calc100toRESX(points[count + i]) : RESX);
+    } else {
+      p0.x = -RESX + (i * 2 * RESX) / (count - 1);
+      p3.x = -RESX + ((i + 1) * 2 * RESX) / (count - 1);
+    }
+    p0.y = calc100toRESX(points[i]);
+    p3.y = calc100toRESX(points[i + 1]);
+    if (x >= p0.x && x <= p3.x) {
+      int32_t m0 = compute_tangent(&crv, points, i);
+      int32_t m3 = compute_tangent(&crv, points, i + 1);
+      int32_t h = p3.x - p0.x;
+      int32_t t = (h > 0 ? (1024 * (x - p0.x)) / h : 0);
+      int32_t t2 = t * t / 1024;
+      int32_t t3 = t2 * t / 1024;
+      int32_t h00 = 2 * t3 - 3 * t2 + 1024;
+      int32_t h10 = t3 - 2 * t2 + t;
+      int32_t h01 = -2 * t3 + 3 * t2;
+      int32_t h11 = t3 - t2;
+      return (p0.y * h00 + h * (m0 * h10 / 1024) + p3.y * h01 +
+              h * (m3 * h11 / 1024)) / 1024;
+    }
+  }
+  return 0;
+}
+
+TEST(Curves, SmoothCurveLut)
+{
+  SYSTEM_RESET();
+  MODEL_RESET();
+  MIXER_RESET();
+  setModelDefaults();
+
+  // standard and custom curves, 5 to 17 points
+  g_model.curves[0] = {CURVE_TYPE_STANDARD, 1, 0};
+  g_model.curves[1] = {CURVE_TYPE_STANDARD, 1, 4};
+  g_model.curves[2] = {CURVE_TYPE_STANDARD, 1, 12};
+  g_model.curves[3] = {CURVE_TYPE_CUSTOM, 1, 0};
+  g_model.curves[4] = {CURVE_TYPE_CUSTOM, 1, 12};
+  loadCurves();
+
+  // points are changed, then the model marked dirty, as the menus do
+  srand(42);
+  for (int loop = 0; loop < 20; loop++) {
+    for (int idx = 0; idx < 5; idx++) {
+      CurveHeader & crv = g_model.curves[idx];
+      int8_t * points = curveAddress(idx);
+      int count = crv.points + 5;
+      for (int i = 0; i < count; i++) {
+        points[i] = rand() % 201 - 100;
+      }
+      if (crv.type == CURVE_TYPE_CUSTOM) {
+        resetCustomCurveX(points, count);
+        for (int i = 0; i < count - 2; i++) {
+          points[count + i] += rand() % 5 - 2;
+        }
+      }
+      storageDirty(EE_MODEL);
+      for (int x = -RESX; x <= RESX; x++) {
+        int y = applyCustomCurve(x, idx);
+        int expected = referenceSpline(x, idx);
+        ASSERT_LE(abs(y - expected), 1)
+            << "curve " << idx << " x=" << x << " loop " << loop;
+      }
+    }
+  }
+}
+
 
 
 TEST_F(MixerTest, InfiniteRecursiveChannels)
@@ -517,6 +601,28 @@ TEST_F(MixerTest, BlockingChannel)
   EXPECT_EQ(chans[0], 0);
 }
 
+TEST_F(MixerTest, MixerPlanRebuiltOnModelChange)
+{
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_MAX;
+  g_model.mixData[0].weight = 100;
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(chans[0], CHANNEL_MAX);
+  EXPECT_EQ(chans[1], 0);
+
+  g_model.mixData[1].destCh = 1;
+  g_model.mixData[1].srcRaw = MIXSRC_MAX;
+  g_model.mixData[1].weight = -100;
+  storageDirty(EE_MODEL);
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(chans[0], CHANNEL_MAX);
+  EXPECT_EQ(chans[1], -CHANNEL_MAX);
+
+  memclear(&g_model.mixData[0], sizeof(MixData));
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(chans[0], 0);
+}
+
 TEST_F(MixerTest, RecursiveAddChannel)
 {
   g_model.mixData[0].destCh = 0;
@@ -829,6 +935,108 @@ TEST_F(MixerTest, flightModeOverflow)
   CHECK_FLIGHT_MODE_TRANSITION(0, 1000, 1024, 1024);
 }
 
+static void setupFlightModesFadeModel()
+{
+  g_model.flightModeData[1].swtch = TR(SWSRC_ID2, SWSRC_SA2);
+  g_model.flightModeData[2].swtch = TR(SWSRC_ID0, SWSRC_SA0);
+  for (int fm = 0; fm < 3; fm++) {
+    g_model.flightModeData[fm].fadeIn = 3 + fm;
+    g_model.flightModeData[fm].fadeOut = 5 - fm;
+    g_model.flightModeData[fm].gvars[0] = 100 - 60 * fm;
+  }
+  g_model.flightModeData[0].trim[0].value = -20;
+  g_model.flightModeData[1].trim[0].value = 40;
+  g_model.flightModeData[1].trim[0].mode = 2;
+
+  // input 1 has no active line in flight mode 1
+  expoAddress(0)->flightModes = 0b10;
+
+  LogicalSwitchData * ls = lswAddress(0);
+  ls->func = LS_FUNC_VPOS;
+  ls->v1 = MIXSRC_FIRST_INPUT + 1;
+  ls->v2 = 0;
+
+  struct {
+    uint8_t destCh;
+    mixsrc_t srcRaw;
+    int16_t weight;
+  } lines[] = {
+    {0, MIXSRC_FIRST_INPUT, GV_CALC_VALUE_IDX_POS(0, GV1_LARGE)},
+    {0, MIXSRC_FIRST_INPUT + 1, 50},
+    {1, MIXSRC_CH1, 50},
+    {2, MIXSRC_MAX, 40},
+    {3, MIXSRC_FIRST_INPUT + 3, 100},
+    {4, MIXSRC_CH4, 100},
+    {4, MIXSRC_FIRST_LOGICAL_SWITCH, 30},
+    {5, MIXSRC_FIRST_TRIM, 100},
+    {6, MIXSRC_FIRST_INPUT, 100},
+    {7, MIXSRC_FIRST_INPUT + 1, 100},
+    {8, MIXSRC_FIRST_INPUT + 2, 100},
+  };
+  for (unsigned i = 0; i < DIM(lines); i++) {
+    MixData * md = mixAddress(i);
+    md->destCh = lines[i].destCh;
+    md->srcRaw = lines[i].srcRaw;
+    md->weight = lines[i].weight;
+    md->mltpx = MLTPX_ADD;
+  }
+  mixAddress(1)->flightModes = 0b100;
+  mixAddress(3)->swtch = TR(SWSRC_THR, SWSRC_SB2);
+  mixAddress(3)->delayUp = 5;
+  mixAddress(3)->delayDown = 3;
+  mixAddress(4)->offset = 10;
+  mixAddress(8)->swtch = SWSRC_FIRST_LOGICAL_SWITCH;
+  mixAddress(9)->curve.type = CURVE_REF_EXPO;
+  mixAddress(9)->curve.value = 40;
+  mixAddress(10)->speedUp = 20;
+  mixAddress(10)->speedDown = 20;
+}
+
+static std::vector<int16_t> runFlightModesFade(bool sharing)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  setModelDefaults();
+  setupFlightModesFadeModel();
+  simuSetSwitch(0, 0);
+  simuSetSwitch(1, -1);
+  s_mixer_first_run_done = true;
+
+  // let the fades of a previous run finish
+  for (int i = 0; i < 200; i++)
+    evalMixes(1);
+
+  mixerFadeSharing = sharing;
+  std::vector<int16_t> outputs;
+  for (int i = 0; i < 400; i++) {
+    for (int stick = 0; stick < 4; stick++)
+      anaInValues[stick] = 900 * ((i * (stick + 3)) % 41 - 20) / 20;
+    if (i == 50) simuSetSwitch(0, 1);     // flight mode 1
+    if (i == 80) simuSetSwitch(1, 1);
+    if (i == 90) simuSetSwitch(0, -1);    // flight mode 2 while fading
+    if (i == 150) simuSetSwitch(1, -1);
+    if (i == 200) simuSetSwitch(0, 0);    // flight mode 0
+    if (i == 230) simuSetSwitch(0, 1);
+    if (i == 235) simuSetSwitch(0, 0);
+    evalMixes(1);
+    outputs.insert(outputs.end(), channelOutputs, channelOutputs + 9);
+  }
+  mixerFadeSharing = true;
+  simuSetSwitch(0, 0);
+  simuSetSwitch(1, -1);
+  return outputs;
+}
+
+TEST_F(MixerTest, flightModesFadeSharing)
+{
+  std::vector<int16_t> reference = runFlightModesFade(false);
+  std::vector<int16_t> shared = runFlightModesFade(true);
+  ASSERT_EQ(reference.size(), shared.size());
+  for (unsigned i = 0; i < reference.size(); i++) {
+    ASSERT_EQ(reference[i], shared[i]) << "cycle " << i / 9 << " channel " << i % 9;
+  }
+}
+
 TEST_F(TrimsTest, throttleTrimWithCrossTrims)
 {
   g_model.thrTrim = 1;
@@ -977,3 +1185,102 @@ TEST_F(TrimsTest, invertedThrottlePlusThrottleTrimWithCrossTrims)
   EXPECT_EQ(channelOutputs[2], +1024);
   EXPECT_EQ(channelOutputs[1], 0);
 }
+
+TEST(LatencyHistogram, buckets)
+{
+  LatencyHistogram histogram;
+  histogram.reset();
+  EXPECT_EQ(histogram.getPercentile(99), 0u);
+
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(0), 0);
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(1), 0);
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(2), 1);
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(3), 1);
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(4000), 11);
+  EXPECT_EQ(LatencyHistogram::getBucketIndex(100000), LATENCY_HISTOGRAM_BUCKETS - 1);
+
+  for (int i = 0; i < 98; i++) {
+    histogram.add(100);
+  }
+  histogram.add(5000);
+  histogram.add(70000);
+
+  EXPECT_EQ(histogram.getCount(), 100u);
+  EXPECT_EQ(histogram.getMin(), 100);
+  EXPECT_EQ(histogram.getMax(), UINT16_MAX);
+  EXPECT_EQ(histogram.getLast(), UINT16_MAX);
+  EXPECT_EQ(histogram.getBucket(6), 98u);
+  EXPECT_EQ(histogram.getPercentile(50), 128u);
+  EXPECT_EQ(histogram.getPercentile(99), 8192u);
+  EXPECT_EQ(histogram.getPercentile(100), 65536u);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.getCount(), 0u);
+  EXPECT_EQ(histogram.getMax(), 0);
+}
+
+TEST(LatencyHistogram, longDurations)
+{
+  mixerLatencyRestart();
+  mixerLatencyReset();
+
+  // the 2MHz timer wraps after 32ms, longer durations use the ms time
+  mixerLatencyUpdate({0, 1000}, {26536, 1030}, {1000, 1050});
+  EXPECT_EQ(mixerLatency[MIXER_LATENCY_ADC_TO_PULSES].getLast(), 50000);
+  EXPECT_EQ(mixerLatency[MIXER_LATENCY_PULSES_SEND].getLast(), 20000);
+
+  mixerLatencyUpdate({2000, 1060}, {3000, 1060}, {4000, 1060});
+  EXPECT_EQ(mixerLatency[MIXER_LATENCY_ADC_TO_PULSES].getLast(), 1000);
+  EXPECT_EQ(mixerLatency[MIXER_LATENCY_PULSES_SEND].getLast(), 500);
+  EXPECT_EQ(mixerLatency[MIXER_LATENCY_PERIOD_JITTER].getLast(), 60000 - getMixerSchedulerPeriod());
+}
+
+TEST_F(MixerTest, channelsSnapshot)
+{
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_MAX;
+  g_model.mixData[0].weight = 50;
+  g_model.limitData[0].max = -500;
+
+  ChannelsSnapshot snapshot;
+  uint32_t sequence = getChannelsSnapshot(snapshot);
+  evalMixes(1);
+  EXPECT_EQ(getChannelsSnapshot(snapshot), sequence + 1);
+  EXPECT_EQ(snapshot.mixes[0], RESX / 2);
+  EXPECT_EQ(snapshot.outputs[0], channelOutputs[0]);
+  EXPECT_EQ(0, memcmp(snapshot.outputs, channelOutputs, sizeof(snapshot.outputs)));
+  EXPECT_EQ(0, memcmp(snapshot.mixes, ex_chans, sizeof(snapshot.mixes)));
+}
+
+#if defined(GTESTS_BENCHMARKS)
+#include <chrono>
+
+TEST(Curves, smoothBenchmark)
+{
+  SYSTEM_RESET();
+  MODEL_RESET();
+  MIXER_RESET();
+  setModelDefaults();
+
+  g_model.curves[0] = {CURVE_TYPE_STANDARD, 1, 12};
+  int8_t * points = curveAddress(0);
+  for (int i = 0; i < 17; i++) {
+    points[i] = (i * 37) % 201 - 100;
+  }
+  loadCurves();
+
+  const int iterations = 200;
+  int64_t check = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++) {
+    for (int x = -RESX; x <= RESX; x++) {
+      check += applyCustomCurve(x, 0);
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_NE(0, check);
+  printf("Smooth curve, 17 points: %6.1f ns/call\n",
+         elapsed.count() * 1e9 / (iterations * (2 * RESX + 1)));
+}
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "gtests.h"
+
+#if defined(STORAGE_MODELSLIST) && defined(SDCARD_YAML)
+#include "location.h"
+#include "storage/modelslist.h"
+
+static void writeTestFile(const char * path, const char * content)
+{
+  FIL file;
+  UINT written;
+  ASSERT_EQ(FR_OK, f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE));
+  f_write(&file, content, strlen(content), &written);
+  f_close(&file);
+}
+
+static void writeTestModel(const char * filename, const char * name)
+{
+  std::string path = std::string(MODELS_PATH PATH_SEPARATOR) + filename;
+  std::string content = std::string("header:\n  name: \"") + name + "\"\n";
+  writeTestFile(path.c_str(), content.c_str());
+}
+
+static void reloadModelsList()
+{
+  // load() clears the labels as well
+  modelslist.clear();
+  modelslist.load();
+}
+
+static bool hasModel(const char * filename, const char * name)
+{
+  for (auto model : modelslist) {
+    if (!strcmp(model->modelFilename, filename))
+      return !strcmp(model->modelName, name);
+  }
+  return false;
+}
+
+class ModelsListTest : public testing::Test
+{
+ protected:
+  void SetUp() override
+  {
+    simuFatfsSetPaths(TESTS_BUILD_PATH "/", TESTS_BUILD_PATH "/");
+    f_mkdir(MODELS_PATH);
+    f_unlink(LABELSLIST_YAML_PATH);
+    f_unlink(LABELSLIST_INDEX_PATH);
+    writeTestModel("model1.yml", "Alpha");
+    writeTestModel("model2.yml", "Bravo");
+    strcpy(g_eeGeneral.currModelFilename, "model1.yml");
+  }
+
+  void TearDown() override
+  {
+    modelslist.clear();
+    f_unlink(LABELSLIST_YAML_PATH);
+    f_unlink(LABELSLIST_INDEX_PATH);
+    f_unlink(MODELS_PATH PATH_SEPARATOR "model1.yml");
+    f_unlink(MODELS_PATH PATH_SEPARATOR "model2.yml");
+    f_unlink(MODELS_PATH PATH_SEPARATOR "model3.yml");
+    simuFatfsSetPaths("", "");
+  }
+};
+
+TEST_F(ModelsListTest, fullScanWritesIndex)
+{
+  FILINFO fno;
+
+  reloadModelsList();
+  EXPECT_FALSE(modelslist.isRescanPending());
+  EXPECT_EQ(2U, modelslist.getModelsCount());
+  EXPECT_EQ(FR_OK, f_stat(LABELSLIST_INDEX_PATH, &fno));
+
+  // a scan finding labels.yml in sync writes the index as well
+  f_unlink(LABELSLIST_INDEX_PATH);
+  reloadModelsList();
+  EXPECT_FALSE(modelslist.isRescanPending());
+  EXPECT_EQ(FR_OK, f_stat(LABELSLIST_INDEX_PATH, &fno));
+}
+
+TEST_F(ModelsListTest, loadFromIndex)
+{
+  reloadModelsList();
+
+  reloadModelsList();
+  EXPECT_TRUE(modelslist.isRescanPending());
+  EXPECT_EQ(2U, modelslist.getModelsCount());
+  EXPECT_TRUE(hasModel("model1.yml", "Alpha"));
+  EXPECT_TRUE(hasModel("model2.yml", "Bravo"));
+  ASSERT_NE(nullptr, modelslist.getCurrentModel());
+  EXPECT_STREQ("model1.yml", modelslist.getCurrentModel()->modelFilename);
+}
+
+TEST_F(ModelsListTest, staleIndexIsIgnored)
+{
+  reloadModelsList();
+
+  // labels.yml no longer has the size the index was written with
+  FIL file;
+  UINT written;
+  ASSERT_EQ(FR_OK, f_open(&file, LABELSLIST_YAML_PATH, FA_OPEN_APPEND | FA_WRITE));
+  f_write(&file, "\r\n", 2, &written);
+  f_close(&file);
+
+  reloadModelsList();
+  EXPECT_FALSE(modelslist.isRescanPending());
+  EXPECT_EQ(2U, modelslist.getModelsCount());
+
+  // and the index is written again
+  reloadModelsList();
+  EXPECT_TRUE(modelslist.isRescanPending());
+}
+
+TEST_F(ModelsListTest, rescanAfterIndexLoad)
+{
+  reloadModelsList();
+
+  writeTestModel("model3.yml", "Charlie");
+  f_unlink(MODELS_PATH PATH_SEPARATOR "model2.yml");
+
+  reloadModelsList();
+  ASSERT_TRUE(modelslist.isRescanPending());
+  EXPECT_TRUE(hasModel("model2.yml", "Bravo"));
+
+  for (int i = 0; i < 100 && modelslist.isRescanPending(); i++) {
+    modelslist.rescanStep();
+  }
+  EXPECT_FALSE(modelslist.isRescanPending());
+  EXPECT_EQ(2U, modelslist.getModelsCount());
+  EXPECT_TRUE(hasModel("model1.yml", "Alpha"));
+  EXPECT_TRUE(hasModel("model3.yml", "Charlie"));
+  EXPECT_FALSE(hasModel("model2.yml", "Bravo"));
+}
+#endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "gtests.h"
+#include "pulses/channels_packer.h"
+
+// Channels and failsafe values used to record the golden frames with the
+// encoders which were packing the channels one value at a time
+static void setupPackerChannels(int16_t * channels)
+{
+  for (int i = 0; i < MAX_OUTPUT_CHANNELS; i++) {
+    channels[i] = -1400 + 180 * (i % 16);
+    g_model.limitData[i].ppmCenter = (i % 3 - 1) * 25;
+    g_model.failsafeChannels[i] = 1300 - 170 * (i % 16);
+  }
+  g_model.failsafeChannels[3] = FAILSAFE_CHANNEL_HOLD;
+  g_model.failsafeChannels[5] = FAILSAFE_CHANNEL_NOPULSE;
+}
+
+static int channelValue(int16_t * channels, int i)
+{
+  return channels[i] + 2 * PPM_CH_CENTER(i) - 2 * PPM_CENTER;
+}
+
+template <const ChannelsScale & scale>
+static uint16_t failsafeValue(int i, uint16_t hold)
+{
+  int16_t value = g_model.failsafeChannels[i];
+  if (value == FAILSAFE_CHANNEL_HOLD)
+    return hold;
+  if (value == FAILSAFE_CHANNEL_NOPULSE)
+    return 0;
+  return scaleChannel<scale>(value + 2 * PPM_CH_CENTER(i) - 2 * PPM_CENTER);
+}
+
+#define EXPECT_FRAME_EQ(golden, frame, end)                             \
+  do {                                                                  \
+    ASSERT_EQ(sizeof(golden), (size_t)((end) - (frame)));               \
+    for (unsigned i = 0; i < sizeof(golden); i++)                       \
+      EXPECT_EQ(golden[i], frame[i]) << "byte " << i;                   \
+  } while (0)
+
+TEST(ChannelsPacker, sbus)
+{
+  static const uint8_t golden[] = {
+    0x00, 0x80, 0x00, 0x32, 0x10, 0x02, 0x1C, 0x3C, 0xE1, 0x0A, 0x6E,
+    0x28, 0x44, 0x23, 0x48, 0xB1, 0x8B, 0x61, 0x68, 0x23, 0x1E, 0xF9,
+  };
+
+  MODEL_RESET();
+  int16_t channels[MAX_OUTPUT_CHANNELS];
+  setupPackerChannels(channels);
+
+  uint16_t values[16];
+  for (int i = 0; i < 16; i++)
+    values[i] = scaleChannel<SBUS_CHANNELS_SCALE>(channelValue(channels, i));
+
+  uint8_t frame[32];
+  uint8_t * end = packChannels<11>(frame, values, 16);
+  EXPECT_FRAME_EQ(golden, frame, end);
+}
+
+TEST(ChannelsPacker, multi)
+{
+  static const uint8_t golden[] = {
+    0x00, 0x80, 0x01, 0x3A, 0x50, 0x02, 0x1E, 0x4C, 0x61, 0x0B, 0x72,
+    0x48, 0x44, 0x24, 0x50, 0xF1, 0x8B, 0x63, 0x78, 0xA3, 0x1E, 0xFD,
+  };
+  static const uint8_t goldenFailsafe[] = {
+    0xE8, 0x47, 0x3C, 0xCA, 0xFF, 0x0F, 0x5F, 0x00, 0xE0, 0x12, 0x8B,
+    0xF8, 0x03, 0x19, 0xB0, 0xC0, 0x84, 0x18, 0x94, 0x20, 0x23, 0x00,
+  };
+
+  MODEL_RESET();
+  int16_t channels[MAX_OUTPUT_CHANNELS];
+  setupPackerChannels(channels);
+
+  uint16_t values[16];
+  uint8_t frame[32];
+
+  for (int i = 0; i < 16; i++)
+    values[i] = scaleChannel<MULTI_CHANNELS_SCALE>(channelValue(channels, i));
+  uint8_t * end = packChannels<11>(frame, values, 16);
+  EXPECT_FRAME_EQ(golden, frame, end);
+
+  for (int i = 0; i < 16; i++)
+    values[i] = failsafeValue<MULTI_FAILSAFE_SCALE>(i, 2047);
+  end = packChannels<11>(frame, values, 16);
+  EXPECT_FRAME_EQ(goldenFailsafe, frame, end);
+}
+
+TEST(ChannelsPacker, pxx2)
+{
+  static const uint8_t golden[] = {
+    0x01, 0xD0, 0x06, 0x19, 0x51, 0x15, 0x02, 0xF2, 0x2A, 0xEB, 0x72, 0x39,
+    0x43, 0xF4, 0x47, 0x2C, 0x85, 0x5D, 0x15, 0x16, 0x6C, 0x6E, 0xA7, 0x7A,
+  };
+  static const uint8_t goldenFailsafe[] = {
+    0xAA, 0x07, 0x75, 0xF6, 0xF6, 0x7F, 0xD1, 0x05, 0x00, 0xAC, 0x24, 0x45,
+    0xF9, 0xE3, 0x32, 0xD4, 0xA2, 0x27, 0xAF, 0x51, 0x15, 0xFB, 0x10, 0x03,
+  };
+
+  MODEL_RESET();
+  int16_t channels[MAX_OUTPUT_CHANNELS];
+  setupPackerChannels(channels);
+
+  uint16_t values[16];
+  uint8_t frame[32];
+
+  for (int i = 0; i < 16; i++)
+    values[i] = scaleChannel<PXX2_CHANNELS_SCALE>(channelValue(channels, i));
+  uint8_t * end = packChannels<12>(frame, values, 16);
+  EXPECT_FRAME_EQ(golden, frame, end);
+
+  for (int i = 0; i < 16; i++)
+    values[i] = failsafeValue<PXX2_CHANNELS_SCALE>(i, 2047);
+  end = packChannels<12>(frame, values, 16);
+  EXPECT_FRAME_EQ(goldenFailsafe, frame, end);
+}
+
+// the packing loop used by the protocols before
+static uint8_t * packChannelsBytewise(uint8_t * buf, const uint16_t * values,
+                                      uint8_t count, uint8_t chBits)
+{
+  uint32_t bits = 0;
+  uint8_t bitsavailable = 0;
+  for (int i = 0; i < count; i++) {
+    bits |= (uint32_t)values[i] << bitsavailable;
+    bitsavailable += chBits;
+    while (bitsavailable >= 8) {
+      *buf++ = bits;
+      bits >>= 8;
+      bitsavailable -= 8;
+    }
+  }
+  return buf;
+}
+
+TEST(ChannelsPacker, randomValues)
+{
+  uint16_t values[24];
+  uint8_t frame[40], reference[40];
+
+  for (int n = 0; n < 1000; n++) {
+    for (int i = 0; i < 24; i++)
+      values[i] = rand() & 0x7FF;
+
+    uint8_t * end = packChannels<11>(frame, values, 16);
+    uint8_t * referenceEnd = packChannelsBytewise(reference, values, 16, 11);
+    ASSERT_EQ(referenceEnd - reference, end - frame);
+    ASSERT_EQ(0, memcmp(reference, frame, end - frame));
+
+    end = packChannels<12>(frame, values, 24);
+    referenceEnd = packChannelsBytewise(reference, values, 24, 12);
+    ASSERT_EQ(referenceEnd - reference, end - frame);
+    ASSERT_EQ(0, memcmp(reference, frame, end - frame));
+  }
+}
+
+#if defined(GTESTS_BENCHMARKS)
+#include <chrono>
+
+TEST(ChannelsPacker, packBenchmark)
+{
+  const int iterations = 200000;
+  int16_t channels[16];
+  uint16_t values[16];
+  uint8_t frame[32];
+  uint32_t check = 0;
+
+  for (int i = 0; i < 16; i++)
+    channels[i] = -1024 + 128 * i;
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++) {
+    channels[n & 15] = (n & 2047) - 1024;
+    uint32_t bits = 0;
+    uint8_t bitsavailable = 0;
+    uint8_t * buf = frame;
+    for (int i = 0; i < 16; i++) {
+      uint32_t val = limit(0, 0x3E0 + (channels[i] * 4) / 5, 2 * 0x3E0);
+      bits |= val << bitsavailable;
+      bitsavailable += 11;
+      while (bitsavailable >= 8) {
+        *buf++ = bits;
+        bits >>= 8;
+        bitsavailable -= 8;
+      }
+    }
+    check += crc8(frame, 22);
+  }
+  std::chrono::duration<double> bytewise = std::chrono::steady_clock::now() - start;
+
+  for (int i = 0; i < 16; i++)
+    channels[i] = -1024 + 128 * i;
+  start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++) {
+    channels[n & 15] = (n & 2047) - 1024;
+    for (int i = 0; i < 16; i++)
+      values[i] = scaleChannel<CROSSFIRE_CHANNELS_SCALE>(channels[i]);
+    packChannels<11>(frame, values, 16);
+    check -= crc8(frame, 22);
+  }
+  std::chrono::duration<double> packed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(0U, check);
+  printf("Channels packing (16 x 11 bits + crc): %6.1f ns bytewise, %6.1f ns packed\n",
+         bytewise.count() * 1e9 / iterations, packed.count() * 1e9 / iterations);
+}
+#endif
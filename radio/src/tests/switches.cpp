@@ -310,3 +310,62 @@ TEST(getSwitch, edgeRelease)
 
 }
 #endif // defined(PCBTARANIS)
+
+#if defined(PCBTARANIS)
+static swsrc_t randomBoolSource()
+{
+  static const swsrc_t sources[] = {
+    SWSRC_NONE, SWSRC_ON, SWSRC_SA0, SWSRC_SA2, SWSRC_SB0,
+    SWSRC_FIRST_FLIGHT_MODE, SWSRC_FIRST_FLIGHT_MODE + 1,
+  };
+  swsrc_t source;
+  if (rand() % 3 == 0)
+    source = sources[rand() % DIM(sources)];
+  else
+    source = SWSRC_SW1 + rand() % 40;
+  return rand() % 4 == 0 ? -source : source;
+}
+
+TEST(evalLogicalSwitches, eventDrivenMatchesFullEvaluation)
+{
+  RADIO_RESET();
+  MODEL_RESET();
+  MIXER_RESET();
+
+  // chains of AND/OR/XOR reading earlier and later switches, some with
+  // a delay so that they are polled
+  srand(7);
+  for (int i = 0; i < 40; i++) {
+    setLogicalSwitch(i, LS_FUNC_AND + rand() % 3, randomBoolSource(),
+                     randomBoolSource(), 0, 0, rand() % 8 == 0 ? 2 : 0,
+                     rand() % 4 == 0 ? randomBoolSource() : 0);
+  }
+
+  std::vector<uint64_t> history[2];
+  for (int run = 0; run < 2; run++) {
+    simuSetSwitch(0, -1);
+    simuSetSwitch(1, -1);
+    MIXER_RESET();
+    srand(11);
+    for (int tick = 0; tick < 500; tick++) {
+      if (rand() % 4 == 0)
+        simuSetSwitch(rand() % 2, rand() % 3 - 1);
+      if (rand() % 50 == 0)
+        mixerCurrentFlightMode = rand() % 2;
+      if (run == 0)
+        lswPlanInvalidate();  // every switch is evaluated in each cycle
+      logicalSwitchesTimerTick();
+      evalLogicalSwitches();
+      uint64_t states = 0;
+      for (int i = 0; i < 40; i++) {
+        if (getSwitch(SWSRC_SW1 + i))
+          states |= (uint64_t)1 << i;
+      }
+      history[run].push_back(states);
+    }
+  }
+
+  EXPECT_EQ(history[0], history[1]);
+  mixerCurrentFlightMode = 0;
+}
+#endif
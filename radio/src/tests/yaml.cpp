@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) EdgeTX
+ *
+ * Based on code named
+ *   opentx - https://github.com/opentx/opentx
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtests.h"
+#include "storage/yaml/yaml_tree_walker.h"
+#include "storage/yaml/yaml_parser.h"
+#include "storage/yaml/yaml_datastructs.h"
+
+static bool stringWriter(void* opaque, const char* str, size_t len)
+{
+  ((std::string*)opaque)->append(str, len);
+  return true;
+}
+
+static std::string generateYaml(const YamlNode* nodes, void* data)
+{
+  std::string yaml;
+  YamlTreeWalker tree;
+  tree.reset(nodes, (uint8_t*)data);
+  tree.generate(stringWriter, &yaml);
+  return yaml;
+}
+
+// feeds the parser the way readYamlFile() does, in chunks of 'chunk' bytes
+static void parseYaml(const YamlNode* nodes, void* data, const std::string& yaml,
+                      size_t chunk)
+{
+  YamlTreeWalker tree;
+  tree.reset(nodes, (uint8_t*)data);
+
+  YamlParser yp;
+  yp.init(YamlTreeWalker::get_parser_calls(), &tree);
+
+  for (size_t pos = 0; pos < yaml.size(); pos += chunk) {
+    size_t len = std::min(chunk, yaml.size() - pos);
+    if (pos + len == yaml.size()) yp.set_eof();
+    // copy each chunk so that tokens left in a previous chunk
+    // cannot be read from the source string by mistake
+    std::vector<char> buffer(yaml.begin() + pos, yaml.begin() + pos + len);
+    if (yp.parse(buffer.data(), len) != YamlParser::CONTINUE_PARSING)
+      break;
+  }
+}
+
+static void setupSampleModel()
+{
+  setModelDefaults(0);
+  strcpy(g_model.header.name, "Sample\x01model");
+
+  g_model.timers[0].mode = TMRMODE_ON;
+  g_model.timers[0].start = 300;
+  g_model.timers[0].persistent = 1;
+
+  for (int i = 0; i < 4; i++) {
+    ExpoData* expo = expoAddress(i);
+    expo->curve.type = CURVE_REF_EXPO;
+    expo->curve.value = 20 + i;
+    expo->weight = 90 - i;
+  }
+
+  for (int i = 0; i < 8; i++) {
+    MixData* mix = mixAddress(i);
+    mix->destCh = i;
+    mix->srcRaw = MIXSRC_FIRST_STICK + (i % 4);
+    mix->weight = 100 - 5 * i;
+    mix->offset = i * 3;
+    mix->mltpx = (i & 1) ? MLTPX_MUL : MLTPX_ADD;
+    mix->delayUp = i;
+    mix->speedDown = 2 * i;
+  }
+
+  g_model.curves[0].type = CURVE_TYPE_CUSTOM;
+  g_model.curves[0].points = 2;
+  for (int i = 0; i < 7; i++) {
+    g_model.points[i] = -100 + (200 * i) / 6;
+  }
+
+  for (int i = 0; i < 6; i++) {
+    LogicalSwitchData* ls = lswAddress(i);
+    ls->func = LS_FUNC_VPOS;
+    ls->v1 = MIXSRC_FIRST_STICK + (i % 4);
+    ls->v2 = -50 + 20 * i;
+    ls->duration = i;
+  }
+
+  for (int i = 0; i < MAX_OUTPUT_CHANNELS; i++) {
+    g_model.limitData[i].min = -i;
+    g_model.limitData[i].max = i;
+    g_model.limitData[i].offset = 10 * i;
+  }
+}
+
+static void clearRadioData()
+{
+  memset(&g_eeGeneral, 0, sizeof(g_eeGeneral));
+}
+
+// flight modes are only written when not left to their defaults
+static void clearModelData()
+{
+  setModelDefaults(0);
+}
+
+struct YamlSample {
+  const char* name;
+  const YamlNode* nodes;
+  void* data;
+  void (*clear)();
+  std::string yaml;
+};
+
+static std::vector<YamlSample> getSamples()
+{
+  std::vector<YamlSample> samples;
+
+  SYSTEM_RESET();
+  samples.push_back({"radio", get_radiodata_nodes(), &g_eeGeneral,
+                     clearRadioData,
+                     generateYaml(get_radiodata_nodes(), &g_eeGeneral)});
+
+  setModelDefaults(0);
+  samples.push_back({"default model", get_modeldata_nodes(), &g_model,
+                     clearModelData,
+                     generateYaml(get_modeldata_nodes(), &g_model)});
+
+  setupSampleModel();
+  samples.push_back({"sample model", get_modeldata_nodes(), &g_model,
+                     clearModelData,
+                     generateYaml(get_modeldata_nodes(), &g_model)});
+
+  return samples;
+}
+
+TEST(Yaml, chunkBoundaries)
+{
+  for (auto& sample : getSamples()) {
+    // 1 and 7 bytes split every attribute and value, 512 is a sector
+    for (size_t chunk : {1, 7, 31, 512, 1 << 16}) {
+      sample.clear();
+      parseYaml(sample.nodes, sample.data, sample.yaml, chunk);
+      EXPECT_EQ(sample.yaml, generateYaml(sample.nodes, sample.data))
+          << sample.name << " (chunk size " << chunk << ")";
+    }
+  }
+}
+
+#if defined(GTESTS_BENCHMARKS)
+#include <chrono>
+
+TEST(Yaml, parseBenchmark)
+{
+  const int iterations = 200;
+
+  for (auto& sample : getSamples()) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      parseYaml(sample.nodes, sample.data, sample.yaml, 512);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    double bytes = double(sample.yaml.size()) * iterations;
+    printf("YAML parse %-14s %6u bytes: %8.2f MB/s\n", sample.name,
+           (unsigned)sample.yaml.size(), bytes / elapsed.count() / 1e6);
+  }
+}
+#endif
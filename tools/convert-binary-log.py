@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) EdgeTX
+#
+# License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# Converts a binary log (.blg, firmware built with LOGS_BINARY=ON) to the
+# CSV format written by the default firmware. See radio/src/logs_binary.h.
+
+import argparse
+import datetime
+import os
+import struct
+import sys
+
+MAGIC = b"ETLG"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHHHI")
+RECORD_MARKER = 0xA5
+
+(COLUMN_TIME_10MS, COLUMN_TIME_RTC, COLUMN_VALUE, COLUMN_VALUE_PREC1,
+ COLUMN_VALUE_PREC2, COLUMN_GPS, COLUMN_DATETIME, COLUMN_TEXT, COLUMN_INT8,
+ COLUMN_INT16, COLUMN_LSW, COLUMN_VBAT) = range(12)
+
+COLUMN_FORMATS = {
+    COLUMN_TIME_10MS: "I",
+    COLUMN_TIME_RTC: "IB",
+    COLUMN_VALUE: "i",
+    COLUMN_VALUE_PREC1: "i",
+    COLUMN_VALUE_PREC2: "i",
+    COLUMN_GPS: "ii",
+    COLUMN_DATETIME: "HBBBBB",
+    COLUMN_TEXT: "16s",
+    COLUMN_INT8: "b",
+    COLUMN_INT16: "h",
+    COLUMN_LSW: "Q",
+    COLUMN_VBAT: "H",
+}
+
+
+def crc8_table():
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0xD5) if crc & 0x80 else (crc << 1)
+        table.append(crc & 0xFF)
+    return table
+
+
+CRC8_TABLE = crc8_table()
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc = CRC8_TABLE[crc ^ byte]
+    return crc
+
+
+def format_decimal(value, prec):
+    sign = "-" if value < 0 else ""
+    quot, rem = divmod(abs(value), 10 ** prec)
+    return "%s%d.%0*d" % (sign, quot, prec, rem)
+
+
+def format_column(column, values):
+    if column == COLUMN_TIME_10MS:
+        return "%d" % values[0]
+    if column == COLUMN_TIME_RTC:
+        t = datetime.datetime(1970, 1, 1) + datetime.timedelta(seconds=values[0])
+        return "%4d-%02d-%02d,%02d:%02d:%02d.%02d0" % (t.year, t.month, t.day, t.hour, t.minute, t.second, values[1])
+    if column == COLUMN_VALUE_PREC1:
+        return format_decimal(values[0], 1)
+    if column == COLUMN_VALUE_PREC2:
+        return format_decimal(values[0], 2)
+    if column == COLUMN_GPS:
+        latitude, longitude = values
+        if latitude and longitude:
+            return "%s %s" % (format_decimal(latitude, 6), format_decimal(longitude, 6))
+        return ""
+    if column == COLUMN_DATETIME:
+        return "%4d-%02d-%02d %02d:%02d:%02d" % values
+    if column == COLUMN_TEXT:
+        return '"%s"' % values[0].split(b"\0")[0].decode("utf-8", "replace")
+    if column == COLUMN_LSW:
+        return "0x%016X" % values[0]
+    if column == COLUMN_VBAT:
+        return "%d.%d" % divmod(values[0], 10)
+    return "%d" % values[0]
+
+
+def convert(data, output):
+    if len(data) < HEADER.size:
+        raise ValueError("file too short")
+    magic, version, flags, record_size, columns_count, header_size, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a binary log file (version %d)" % VERSION)
+
+    columns = data[HEADER.size:HEADER.size + columns_count]
+    text_header = data[HEADER.size + columns_count:header_size].split(b"\0")[0]
+    output.write(text_header.decode("utf-8", "replace"))
+
+    formats = [struct.Struct("<" + COLUMN_FORMATS[column]) for column in columns]
+    if 2 + sum(f.size for f in formats) != record_size:
+        raise ValueError("inconsistent record size")
+
+    records = skipped = 0
+    pos = header_size
+    while pos + record_size <= len(data):
+        record = data[pos:pos + record_size]
+        if record[0] != RECORD_MARKER or crc8(record[:-1]) != record[-1]:
+            # resync on the next marker (truncated or garbage data)
+            pos += 1
+            skipped += 1
+            continue
+        fields = []
+        offset = 1
+        for column, fmt in zip(columns, formats):
+            fields.append(format_column(column, fmt.unpack_from(record, offset)))
+            offset += fmt.size
+        output.write(",".join(fields) + "\n")
+        records += 1
+        pos += record_size
+    return records, skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a binary log file to CSV")
+    parser.add_argument("input", help="binary log file (.blg)")
+    parser.add_argument("output", nargs="?", help="CSV file (default: input with .csv extension)")
+    args = parser.parse_args()
+
+    output = args.output or os.path.splitext(args.input)[0] + ".csv"
+    with open(args.input, "rb") as f:
+        data = f.read()
+    with open(output, "w", newline="") as f:
+        records, skipped = convert(data, f)
+    print("%d records written to %s" % (records, output))
+    if skipped:
+        print("%d bytes skipped" % skipped, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()